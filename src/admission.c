@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "sketch.h"
+#include "admission.h"
+
+#define SKETCH_MAX_COUNT 15			// 4-bit counters
+
+static GhostDesc *ghost_descriptors;
+static long    *ghost_hashtable;		// first ghost of each hash bucket, -1 if none
+static long	nghosts;			// ADMISSION_GHOST_PERCENT of NSSDBuffers
+static long	next_ghost;			// ring position the next ghost replaces
+
+static CountMinSketch admission_sketch;
+
+static bool	admitGhost(SSDBufferTag ssd_buf_tag);
+static long	ghostLookup(SSDBufferTag ssd_buf_tag, long *prev);
+static void	deleteGhost(long ghost_id, long prev);
+
+/*
+ * Admission control in front of SSDBufferAlloc() for writes. Most blocks of
+ * log-style traffic are written once; giving each a slot evicts, and
+ * destages, a block that may still be read or rewritten. A write miss that
+ * is not admitted bypasses the cache and goes straight to the smr drive.
+ *
+ * AdmitGhost remembers the tags of the last nghosts rejected misses in a
+ * ring; a miss on one of them is its second touch and is admitted.
+ * AdmitTinyLFU counts every write, hit or miss, in a count-min sketch (see
+ * sketch.c) of 4-bit counters that are halved every 10 * width additions,
+ * and admits a miss whose estimate reaches ADMISSION_MIN_FREQUENCY.
+ *
+ * Both admit every miss while the free list still has a slot, as nothing is
+ * evicted for it then. The caller holds ssd_buf_mutex.
+ */
+void
+initAdmission()
+{
+	long		i;
+
+	admitted_blocks = 0;
+	bypassed_blocks = 0;
+	if (AdmissionPolicy == AdmitGhost) {
+		nghosts = NSSDBuffers * ADMISSION_GHOST_PERCENT / 100;
+		if (nghosts < 1)
+			nghosts = 1;
+		ghost_descriptors = (GhostDesc *) allocSSDArray(nghosts, sizeof(GhostDesc));
+		ghost_hashtable = (long *) allocSSDArray(nghosts, sizeof(long));
+		for (i = 0; i < nghosts; i++) {
+			ghost_descriptors[i].ghost_tag.offset = -1;
+			ghost_descriptors[i].next_hash = -1;
+			ghost_hashtable[i] = -1;
+		}
+		next_ghost = 0;
+	} else if (AdmissionPolicy == AdmitTinyLFU) {
+		initSketch(&admission_sketch, NSSDBuffers, SKETCH_MAX_COUNT, 0);
+	}
+}
+
+/*
+ * should a write to ssd_buf_tag get an ssd slot? found is whether the tag is
+ * cached already, which is always admitted
+ */
+bool
+admitSSDBuffer(SSDBufferTag ssd_buf_tag, bool found)
+{
+	unsigned long	frequency;
+
+	if (AdmissionPolicy == AdmitAll)
+		return 1;
+	frequency = AdmissionPolicy == AdmitTinyLFU ? incrementSketch(&admission_sketch, ssd_buf_tag.offset / BLCKSZ, 1) : 0;
+	if (found || ssd_buffer_strategy_control->first_freessd >= 0)
+		return 1;
+	if (AdmissionPolicy == AdmitGhost)
+		return admitGhost(ssd_buf_tag);
+	return frequency >= ADMISSION_MIN_FREQUENCY;
+}
+
+/* a ghost hit is admitted and forgotten, a ghost miss replaces the oldest ghost */
+static bool
+admitGhost(SSDBufferTag ssd_buf_tag)
+{
+	GhostDesc      *ghost_hdr;
+	long		ghost_id, prev, bucket;
+
+	ghost_id = ghostLookup(ssd_buf_tag, &prev);
+	if (ghost_id >= 0) {
+		deleteGhost(ghost_id, prev);
+		return 1;
+	}
+	ghost_hdr = &ghost_descriptors[next_ghost];
+	if (ghost_hdr->ghost_tag.offset != -1 && ghostLookup(ghost_hdr->ghost_tag, &prev) == next_ghost)
+		deleteGhost(next_ghost, prev);
+	bucket = ssd_buf_tag.offset / BLCKSZ % nghosts;
+	ghost_hdr->ghost_tag = ssd_buf_tag;
+	ghost_hdr->next_hash = ghost_hashtable[bucket];
+	ghost_hashtable[bucket] = next_ghost;
+	next_ghost = (next_ghost + 1) % nghosts;
+	return 0;
+}
+
+/* the ghost of ssd_buf_tag, -1 if none, and in prev the ghost before it in its bucket */
+static long
+ghostLookup(SSDBufferTag ssd_buf_tag, long *prev)
+{
+	long		ghost_id = ghost_hashtable[ssd_buf_tag.offset / BLCKSZ % nghosts];
+
+	*prev = -1;
+	while (ghost_id >= 0 && ghost_descriptors[ghost_id].ghost_tag.offset != ssd_buf_tag.offset) {
+		*prev = ghost_id;
+		ghost_id = ghost_descriptors[ghost_id].next_hash;
+	}
+	return ghost_id;
+}
+
+static void
+deleteGhost(long ghost_id, long prev)
+{
+	GhostDesc      *ghost_hdr = &ghost_descriptors[ghost_id];
+
+	if (prev >= 0)
+		ghost_descriptors[prev].next_hash = ghost_hdr->next_hash;
+	else
+		ghost_hashtable[ghost_hdr->ghost_tag.offset / BLCKSZ % nghosts] = ghost_hdr->next_hash;
+	ghost_hdr->ghost_tag.offset = -1;
+	ghost_hdr->next_hash = -1;
+}
@@ -0,0 +1,29 @@
+#ifndef SMR_SSD_CACHE_ADMISSION_H
+#define SMR_SSD_CACHE_ADMISSION_H
+
+#define DEBUG 0
+/* ---------------------------ssd cache admission---------------------------- */
+
+typedef enum
+{
+	AdmitAll = 0,				// every write miss takes a slot
+	AdmitGhost,				// a miss seen again within the ghost window
+	AdmitTinyLFU				// a miss the frequency sketch has seen often enough
+} SSDAdmissionPolicy;
+
+typedef struct
+{
+	SSDBufferTag	ghost_tag;
+	long		next_hash;			// to link ghosts with the same hash code
+} GhostDesc;
+
+extern SSDAdmissionPolicy AdmissionPolicy;
+extern char *admission_policy_names[];
+extern unsigned long ADMISSION_GHOST_PERCENT;
+extern unsigned long ADMISSION_MIN_FREQUENCY;
+extern unsigned long admitted_blocks;
+extern unsigned long bypassed_blocks;
+
+extern void initAdmission();
+extern bool admitSSDBuffer(SSDBufferTag ssd_buf_tag, bool found);
+#endif
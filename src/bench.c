@@ -0,0 +1,325 @@
+/*
+ * bench.c -- microbenchmarks of the hash tables, the band geometry, the band
+ * hotness sketch and the allocation path of every strategy, built and run by
+ * "make bench".
+ *
+ * Every benchmark sets up its own tables at the sizes in global.c and then
+ * times a loop over offsets drawn before the clock starts. One line per
+ * benchmark goes to stdout, tab separated:
+ *
+ *	name	ops	ns_per_op	cache_misses_per_op
+ *
+ * so two runs can be compared with diff or join. cache_misses_per_op is -1
+ * when perf_event_open() is not allowed.
+ */
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "smr-simulator/inner_ssd_buf_table.h"
+#include "ssd_buf_table.h"
+#include "strategy/band_table.h"
+#include "strategy/band_hotness.h"
+
+#define BENCH_SEED 1
+#define BENCH_ALLOC_OPS 500000		// timed allocations per strategy, after the cache is full
+
+static int	perf_fd = -1;
+static struct timespec ts_begin;
+static unsigned long *offsets;
+static unsigned long noffsets;
+
+static void	initCacheMissCounter();
+static void	benchBegin();
+static void	benchEnd(char *name, unsigned long nops);
+static unsigned long nextRandom();
+static void	drawOffsets(unsigned long n, unsigned long range, unsigned long unit);
+static void	benchSSDBufTable();
+static void	benchBandTable();
+static void	benchSSDTable();
+static void	benchBandGeometry();
+static void	benchBandHotness();
+static void	benchStrategy(char *name, SSDEvictionStrategy strategy, unsigned long nbands);
+
+int
+main()
+{
+	BandOrBlock = 0;		// ssdbuftableHashcode() would switch SSD_BUFFER_SIZE to BNDSZ
+	initCacheMissCounter();
+	printf("name\tops\tns_per_op\tcache_misses_per_op\n");
+	benchSSDBufTable();
+	benchBandTable();
+	benchSSDTable();
+	benchBandGeometry();
+	benchBandHotness();
+	benchStrategy("alloc_CLOCK", CLOCK, 0);
+	benchStrategy("alloc_LRU", LRU, 0);
+	benchStrategy("alloc_LRUofBand", LRUofBand, 0);
+	benchStrategy("alloc_Most", Most, 0);
+	benchStrategy("alloc_SCAN", SCAN, 0);
+	benchStrategy("alloc_WA", WA, 0);
+	benchStrategy("alloc_Most_Bucket", Most_Bucket, 0);
+	benchStrategy("alloc_ARC", ARC, 0);
+	benchStrategy("alloc_TwoQ", TwoQ, 0);
+	benchStrategy("alloc_CostBenefit", CostBenefit, 0);
+	/* blocks scattered over 2.4M bands, so Most keeps close to a million bands */
+	benchStrategy("alloc_Most_1M_bands", Most, 1200000);
+	benchStrategy("alloc_Most_Bucket_1M_bands", Most_Bucket, 1200000);
+	return 0;
+}
+
+static void
+initCacheMissCounter()
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void
+benchBegin()
+{
+	if (perf_fd >= 0) {
+		ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+}
+
+static void
+benchEnd(char *name, unsigned long nops)
+{
+	struct timespec	ts_end;
+	long long	misses = -1;
+	double		ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	if (perf_fd >= 0) {
+		ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(perf_fd, &misses, sizeof(misses)) != sizeof(misses))
+			misses = -1;
+	}
+	ns = (ts_end.tv_sec - ts_begin.tv_sec) * 1e9 + (ts_end.tv_nsec - ts_begin.tv_nsec);
+	printf("%s\t%lu\t%.1f\t%.2f\n", name, nops, ns / nops, misses < 0 ? -1.0 : (double) misses / nops);
+	fflush(stdout);
+}
+
+/* splitmix64, so every run draws the same offsets */
+static unsigned long
+nextRandom()
+{
+	static unsigned long state = BENCH_SEED;
+	unsigned long	z = (state += 0x9e3779b97f4a7c15UL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+	return z ^ (z >> 31);
+}
+
+/* n offsets, multiples of unit below range * unit */
+static void
+drawOffsets(unsigned long n, unsigned long range, unsigned long unit)
+{
+	unsigned long	i;
+
+	free(offsets);
+	offsets = (unsigned long *) malloc(sizeof(unsigned long) * n);
+	if (offsets == NULL) {
+		printf("[ERROR] drawOffsets():-------malloc %lu offsets\n", n);
+		exit(-1);
+	}
+	for (i = 0; i < n; i++)
+		offsets[i] = nextRandom() % range * unit;
+	noffsets = n;
+}
+
+static void
+benchSSDBufTable()
+{
+	SSDBufferTag	ssd_buf_tag;
+	unsigned long	i;
+
+	initSSDBufTable(NSSDBufTables);
+	drawOffsets(NSSDBuffers, 1UL << 32, BLCKSZ);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_buf_tag.offset = offsets[i];
+		ssdbuftableInsert(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag), i);
+	}
+	benchEnd("ssdbuftableInsert", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_buf_tag.offset = offsets[(i * 7919) % noffsets];
+		ssdbuftableLookup(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag));
+	}
+	benchEnd("ssdbuftableLookup_hit", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_buf_tag.offset = offsets[i] + BLCKSZ / 2;
+		ssdbuftableLookup(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag));
+	}
+	benchEnd("ssdbuftableLookup_miss", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_buf_tag.offset = offsets[i];
+		ssdbuftableDelete(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag));
+	}
+	benchEnd("ssdbuftableDelete", noffsets);
+}
+
+static void
+benchBandTable()
+{
+	BandHashBucket *band_hashtable;
+	unsigned long	i;
+
+	initBandTable(NBANDTables, &band_hashtable);
+	drawOffsets(NSMRBands, 1UL << 40, 1);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		bandtableInsert(offsets[i], bandtableHashcode(offsets[i]), i, &band_hashtable);
+	benchEnd("bandtableInsert", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		bandtableLookup(offsets[(i * 7919) % noffsets], bandtableHashcode(offsets[(i * 7919) % noffsets]), band_hashtable);
+	benchEnd("bandtableLookup", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		bandtableDelete(offsets[i], bandtableHashcode(offsets[i]), &band_hashtable);
+	benchEnd("bandtableDelete", noffsets);
+}
+
+static void
+benchSSDTable()
+{
+	SSDTag		ssd_tag;
+	SSDHashBucket  *ssd_hashtable;
+	unsigned long	i;
+
+	ssd_hashtable = initSSDTable(NSSDTables);
+	drawOffsets(NSSDs, 1UL << 32, BLCKSZ);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_tag.offset = offsets[i];
+		ssdtableInsert(&ssd_tag, ssdtableHashcode(&ssd_tag), i, ssd_hashtable);
+	}
+	benchEnd("ssdtableInsert", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_tag.offset = offsets[(i * 7919) % noffsets];
+		ssdtableLookup(&ssd_tag, ssdtableHashcode(&ssd_tag), ssd_hashtable);
+	}
+	benchEnd("ssdtableLookup", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++) {
+		ssd_tag.offset = offsets[i];
+		ssdtableDelete(&ssd_tag, ssdtableHashcode(&ssd_tag), ssd_hashtable);
+	}
+	benchEnd("ssdtableDelete", noffsets);
+}
+
+static void
+benchBandGeometry()
+{
+	unsigned long	i;
+
+	drawOffsets(BENCH_ALLOC_OPS, GetSMRBandStartFromNum(NSMRBands) / BLCKSZ, BLCKSZ);
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		GetSMRBandNumFromSSD(offsets[i]);
+	benchEnd("GetSMRBandNumFromSSD", noffsets);
+}
+
+static void
+benchBandHotness()
+{
+	unsigned long	i;
+
+	initBandHotness();
+	drawOffsets(BENCH_ALLOC_OPS, NSMRBands, 1);
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		touchBandHotness(offsets[i], 1);
+	benchEnd("touchBandHotness", noffsets);
+
+	benchBegin();
+	for (i = 0; i < noffsets; i++)
+		getBandHotness(offsets[(i * 7919) % noffsets]);
+	benchEnd("getBandHotness", noffsets);
+}
+
+/*
+ * SSDBufferAlloc() without the ssd and smr i/o: nothing is dirty, so an
+ * eviction only unlinks the victim. Offsets cover twice the cache, in the
+ * first bands of the disk, or are blocks at random 4KB offsets anywhere on
+ * a disk of twice nbands bands, so most cached blocks are alone in their band.
+ */
+static void
+benchStrategy(char *name, SSDEvictionStrategy strategy, unsigned long nbands)
+{
+	SSDBufferTag	ssd_buf_tag;
+	SSDBufferDesc  *ssd_buf_hdr;
+	unsigned long	ssd_buf_hash, i;
+	unsigned long	saved_nsmrbands = NSMRBands, saved_nssdbuffers = NSSDBuffers;
+	unsigned long	saved_nbandtables = NBANDTables, saved_nssdbuftables = NSSDBufTables;
+	long		ssd_buf_id;
+
+	EvictStrategy = strategy;
+	if (nbands > 0) {
+		NSMRBands = nbands * 2;
+		NBANDTables = nbands * 2;
+		NSSDBuffers = nbands;
+		NSSDBufTables = nbands;
+	}
+	initSSDBuffer();
+	if (nbands > 0)
+		drawOffsets(NSSDBuffers + BENCH_ALLOC_OPS, GetSMRBandStartFromNum(NSMRBands) / BLCKSZ, BLCKSZ);
+	else
+		drawOffsets(NSSDBuffers + BENCH_ALLOC_OPS, NSSDBuffers * 2, BLCKSZ);
+
+	for (i = 0; i < noffsets; i++) {
+		if (i == NSSDBuffers)
+			benchBegin();
+		ssd_buf_tag.offset = offsets[i];
+		ssd_buf_hash = ssdbuftableHashcode(&ssd_buf_tag);
+		ssd_buf_id = ssdbuftableLookup(&ssd_buf_tag, ssd_buf_hash);
+		if (ssd_buf_id >= 0) {
+			hitInSSDBuffer(&ssd_buffer_descriptors[ssd_buf_id], strategy);
+			continue;
+		}
+		ssd_buf_hdr = getSSDStrategyBuffer(ssd_buf_tag, strategy);
+		ssdbuftableInsert(&ssd_buf_tag, ssd_buf_hash, ssd_buf_hdr->ssd_buf_id);
+		ssd_buf_hdr->ssd_buf_flag = SSD_BUF_VALID;
+		ssd_buf_hdr->ssd_buf_tag = ssd_buf_tag;
+	}
+	benchEnd(name, BENCH_ALLOC_OPS);
+
+	NSMRBands = saved_nsmrbands;
+	NBANDTables = saved_nbandtables;
+	NSSDBuffers = saved_nssdbuffers;
+	NSSDBufTables = saved_nssdbuftables;
+}
@@ -0,0 +1,343 @@
+/*
+ * blktrace2trace.c -- convert the binary per-cpu files of blktrace into the
+ * trace format trace_to_iocall() replays, built by "make blktrace":
+ *
+ *	smr-ssd-cache-blktrace [-a Q|D|C] [-d major,minor] -o trace input...
+ *
+ * An input is one per-cpu file (sda.blktrace.0) or the name given to
+ * blktrace -o (sda), which stands for sda.blktrace.0, sda.blktrace.1, ...
+ * up to the first one that does not exist. Every file is sorted by time, so
+ * they are merged with a heap holding the next event of each file, and only
+ * BLKTRACE_READ_SIZE bytes of each file are in memory at once.
+ *
+ * Exactly one event per request is kept: the queue (Q, default), issue (D)
+ * or complete (C) event, so a request is never replayed twice the way the
+ * Q and I lines of trace_filter.sh were. Notify, passthrough, discard and
+ * zero length events are dropped. Every kept event becomes one line
+ *
+ *	seconds.nanoseconds Q|D|C W|R offset size(KB)
+ *
+ * with the time since the first event, the offset in bytes and the size in
+ * KB, as trace_to_iocall() expects.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BLK_IO_TRACE_MAGIC 0x65617400
+#define BLK_IO_TRACE_VERSION 0x07
+
+/* the action of an event is BLK_TA_* in the low 16 bits, BLK_TC_* above */
+#define BLK_TA_QUEUE 1
+#define BLK_TA_ISSUE 7
+#define BLK_TA_COMPLETE 8
+#define BLK_TC_READ (1 << 0)
+#define BLK_TC_WRITE (1 << 1)
+#define BLK_TC_PC (1 << 9)
+#define BLK_TC_NOTIFY (1 << 10)
+#define BLK_TC_DISCARD (1 << 13)
+#define BLK_TC_ACT(act) ((act) << 16)
+
+#define BLKTRACE_MAX_INPUTS 1024
+#define BLKTRACE_READ_SIZE (256 * 1024)
+#define BLKTRACE_OUT_SIZE (1024 * 1024)
+
+/* struct blk_io_trace of <linux/blktrace_api.h>, in the byte order of the traced machine */
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	sequence;
+	uint64_t	time;			// ns
+	uint64_t	sector;
+	uint32_t	bytes;
+	uint32_t	action;
+	uint32_t	pid;
+	uint32_t	device;
+	uint32_t	cpu;
+	uint16_t	error;
+	uint16_t	pdu_len;			// bytes of payload after the event
+} BlkIOTrace;
+
+_Static_assert(sizeof(BlkIOTrace) == 48, "BlkIOTrace must match struct blk_io_trace");
+
+typedef struct
+{
+	FILE	       *file;
+	char	       *path;
+	char	       *buffer;
+	size_t		begin;			// next unread byte of buffer
+	size_t		end;
+	int		swap;			// recorded on a machine of the other byte order
+	BlkIOTrace	event;			// next event of the file
+} BlkTraceInput;
+
+static BlkTraceInput inputs[BLKTRACE_MAX_INPUTS];
+static long	ninputs;
+static long	heap[BLKTRACE_MAX_INPUTS];	// inputs with an event left, earliest event first
+static long	nheap;
+static char	out[BLKTRACE_OUT_SIZE];
+static long	out_len;
+
+static void	openInput(char *path);
+static void	addInputs(char *name);
+static int	fillInput(BlkTraceInput * input, size_t n);
+static int	nextEvent(BlkTraceInput * input);
+static void	siftDown(long i);
+static void	siftUp(long i);
+static char    *formatUnsigned(char *p, unsigned long v, int width);
+static void	emitEvent(FILE * trace, BlkIOTrace * event, uint64_t genesis, char stage);
+
+int
+main(int argc, char **argv)
+{
+	FILE	       *trace;
+	BlkTraceInput  *input;
+	char	       *trace_file_path = NULL, stage = 'Q';
+	uint32_t	stage_action = BLK_TA_QUEUE, device = 0;
+	unsigned long	major, minor, nevents = 0, nrequests = 0;
+	uint64_t	genesis = 0;
+	int		opt, filter_device = 0;
+	long		i;
+	struct timespec	ts_begin, ts_end;
+
+	while ((opt = getopt(argc, argv, "a:d:o:")) != -1) {
+		if (opt == 'a' && strlen(optarg) == 1 && strchr("QDC", optarg[0]) != NULL) {
+			stage = optarg[0];
+			stage_action = stage == 'Q' ? BLK_TA_QUEUE : stage == 'D' ? BLK_TA_ISSUE : BLK_TA_COMPLETE;
+		} else if (opt == 'd' && sscanf(optarg, "%lu,%lu", &major, &minor) == 2) {
+			device = major << 20 | minor;
+			filter_device = 1;
+		} else if (opt == 'o')
+			trace_file_path = optarg;
+		else {
+			printf("usage: %s [-a Q|D|C] [-d major,minor] -o trace input...\n", argv[0]);
+			exit(1);
+		}
+	}
+	if (trace_file_path == NULL || optind >= argc) {
+		printf("usage: %s [-a Q|D|C] [-d major,minor] -o trace input...\n", argv[0]);
+		exit(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	for (i = optind; i < argc; i++)
+		addInputs(argv[i]);
+	for (i = 0; i < ninputs; i++)
+		if (nextEvent(&inputs[i])) {
+			heap[nheap] = i;
+			siftUp(nheap++);
+		}
+	if (nheap > 0)
+		genesis = inputs[heap[0]].event.time;
+	if ((trace = fopen(trace_file_path, "w")) == NULL) {
+		printf("[ERROR] blktrace2trace():-------open %s\n", trace_file_path);
+		exit(-1);
+	}
+
+	while (nheap > 0) {
+		input = &inputs[heap[0]];
+		nevents++;
+		if ((input->event.action & 0xffff) == stage_action &&
+		    (input->event.action & BLK_TC_ACT(BLK_TC_NOTIFY | BLK_TC_PC | BLK_TC_DISCARD)) == 0 &&
+		    (input->event.action & BLK_TC_ACT(BLK_TC_READ | BLK_TC_WRITE)) != 0 &&
+		    input->event.bytes > 0 && (!filter_device || input->event.device == device)) {
+			emitEvent(trace, &input->event, genesis, stage);
+			nrequests++;
+		}
+		if (!nextEvent(input))
+			heap[0] = heap[--nheap];
+		siftDown(0);
+	}
+	fwrite(out, 1, out_len, trace);
+	fclose(trace);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	printf("[INFO] blktrace2trace():-------%lu events from %ld files, %lu %c requests to %s in %.3fs\n",
+	       nevents, ninputs, nrequests, stage, trace_file_path,
+	       ts_end.tv_sec - ts_begin.tv_sec + (ts_end.tv_nsec - ts_begin.tv_nsec) / 1e9);
+	return 0;
+}
+
+static void
+openInput(char *path)
+{
+	BlkTraceInput  *input = &inputs[ninputs];
+
+	if (ninputs == BLKTRACE_MAX_INPUTS) {
+		printf("[ERROR] openInput():-------more than %d input files\n", BLKTRACE_MAX_INPUTS);
+		exit(-1);
+	}
+	if ((input->file = fopen(path, "r")) == NULL) {
+		printf("[ERROR] openInput():-------open %s\n", path);
+		exit(-1);
+	}
+	input->path = strdup(path);
+	input->buffer = (char *) malloc(BLKTRACE_READ_SIZE);
+	input->begin = input->end = 0;
+	input->swap = -1;
+	ninputs++;
+}
+
+/* a per-cpu file, or the blktrace -o name of a set of them */
+static void
+addInputs(char *name)
+{
+	char		path[1024];
+	long		cpu;
+
+	if (access(name, R_OK) == 0) {
+		openInput(name);
+		return;
+	}
+	for (cpu = 0;; cpu++) {
+		snprintf(path, sizeof(path), "%s.blktrace.%ld", name, cpu);
+		if (access(path, R_OK) != 0)
+			break;
+		openInput(path);
+	}
+	if (cpu == 0) {
+		printf("[ERROR] addInputs():-------neither %s nor %s.blktrace.0 exists\n", name, name);
+		exit(-1);
+	}
+}
+
+/* make n bytes readable at input->buffer + input->begin, 0 at end of file */
+static int
+fillInput(BlkTraceInput * input, size_t n)
+{
+	if (input->end - input->begin >= n)
+		return 1;
+	memmove(input->buffer, input->buffer + input->begin, input->end - input->begin);
+	input->end -= input->begin;
+	input->begin = 0;
+	input->end += fread(input->buffer + input->end, 1, BLKTRACE_READ_SIZE - input->end, input->file);
+	if (input->end == 0)
+		return 0;
+	if (input->end < n) {
+		printf("[ERROR] fillInput():-------%s ends in the middle of an event\n", input->path);
+		exit(-1);
+	}
+	return 1;
+}
+
+/* read the next event of input into input->event, 0 at end of file */
+static int
+nextEvent(BlkTraceInput * input)
+{
+	BlkIOTrace     *event = &input->event;
+
+	if (!fillInput(input, sizeof(BlkIOTrace))) {
+		fclose(input->file);
+		free(input->buffer);
+		return 0;
+	}
+	memcpy(event, input->buffer + input->begin, sizeof(BlkIOTrace));
+	input->begin += sizeof(BlkIOTrace);
+
+	if (input->swap < 0)
+		input->swap = (event->magic & 0xffffff00) != BLK_IO_TRACE_MAGIC;
+	if (input->swap) {
+		event->magic = __builtin_bswap32(event->magic);
+		event->sequence = __builtin_bswap32(event->sequence);
+		event->time = __builtin_bswap64(event->time);
+		event->sector = __builtin_bswap64(event->sector);
+		event->bytes = __builtin_bswap32(event->bytes);
+		event->action = __builtin_bswap32(event->action);
+		event->pid = __builtin_bswap32(event->pid);
+		event->device = __builtin_bswap32(event->device);
+		event->cpu = __builtin_bswap32(event->cpu);
+		event->error = __builtin_bswap16(event->error);
+		event->pdu_len = __builtin_bswap16(event->pdu_len);
+	}
+	if (event->magic != (BLK_IO_TRACE_MAGIC | BLK_IO_TRACE_VERSION)) {
+		printf("[ERROR] nextEvent():-------%s is not a version %d blktrace file, magic=%#x\n", input->path, BLK_IO_TRACE_VERSION, event->magic);
+		exit(-1);
+	}
+
+	/* skip the payload of the event, process names and the like */
+	if (event->pdu_len > 0) {
+		if (!fillInput(input, event->pdu_len)) {
+			printf("[ERROR] nextEvent():-------%s ends in the middle of an event\n", input->path);
+			exit(-1);
+		}
+		input->begin += event->pdu_len;
+	}
+	return 1;
+}
+
+static void
+siftDown(long i)
+{
+	long		child, tmp;
+
+	for (; (child = 2 * i + 1) < nheap; i = child) {
+		if (child + 1 < nheap && inputs[heap[child + 1]].event.time < inputs[heap[child]].event.time)
+			child++;
+		if (inputs[heap[i]].event.time <= inputs[heap[child]].event.time)
+			break;
+		tmp = heap[i];
+		heap[i] = heap[child];
+		heap[child] = tmp;
+	}
+}
+
+static void
+siftUp(long i)
+{
+	long		parent, tmp;
+
+	for (; i > 0 && inputs[heap[parent = (i - 1) / 2]].event.time > inputs[heap[i]].event.time; i = parent) {
+		tmp = heap[i];
+		heap[i] = heap[parent];
+		heap[parent] = tmp;
+	}
+}
+
+static char    *
+formatUnsigned(char *p, unsigned long v, int width)
+{
+	char		digits[20];
+	int		n = 0;
+
+	do {
+		digits[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v > 0);
+	while (n < width--)
+		*p++ = '0';
+	while (n > 0)
+		*p++ = digits[--n];
+	return p;
+}
+
+static void
+emitEvent(FILE * trace, BlkIOTrace * event, uint64_t genesis, char stage)
+{
+	uint64_t	time_ns = event->time - genesis;
+	char	       *p;
+
+	if (out_len > BLKTRACE_OUT_SIZE - 128) {
+		fwrite(out, 1, out_len, trace);
+		out_len = 0;
+	}
+	p = out + out_len;
+	p = formatUnsigned(p, time_ns / 1000000000, 0);
+	*p++ = '.';
+	p = formatUnsigned(p, time_ns % 1000000000, 9);
+	*p++ = ' ';
+	*p++ = stage;
+	*p++ = ' ';
+	*p++ = event->action & BLK_TC_ACT(BLK_TC_WRITE) ? 'W' : 'R';
+	*p++ = ' ';
+	p = formatUnsigned(p, event->sector * 512, 0);
+	*p++ = ' ';
+	p = formatUnsigned(p, event->bytes / 1024, 0);
+	if (event->bytes % 1024 != 0) {
+		*p++ = '.';
+		*p++ = '5';
+	}
+	*p++ = '\n';
+	out_len = p - out;
+}
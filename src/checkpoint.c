@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "ssd_buf_table.h"
+#include "checkpoint.h"
+
+static void	writeCheckpoint();
+static bool	restoreCheckpoint();
+static void	flushJournal();
+static void	restoreEntry(long ssd_buf_id, off_t offset, unsigned ssd_buf_flag);
+static int	compareLastTouch(const void *a, const void *b);
+static void	writeMetadata(void *buf, size_t size, off_t offset);
+static void	readMetadata(void *buf, size_t size, off_t offset);
+
+static off_t	metadata_offset;		// start of the metadata region on the ssd device
+static off_t	area_size;				// one checkpoint entry area
+static off_t	journal_offset;
+static CheckpointHeader checkpoint_header;
+static JournalRecord *journal_buffer;	// records not yet written to the journal
+static unsigned long nbuffered;
+static unsigned long njournal;			// records written since the last checkpoint
+static bool	journal_enabled;
+
+/* state being restored, indexed by ssd_buf_id */
+static off_t   *restored_offset;
+static unsigned *restored_flag;
+static unsigned long *last_touch;
+static unsigned long touch_clock;
+
+#define ROUNDUP(size) (((size) + CHECKPOINT_HEADER_SIZE - 1) / CHECKPOINT_HEADER_SIZE * CHECKPOINT_HEADER_SIZE)
+
+/*
+ * Cache metadata is checkpointed to a region past the cached blocks on the
+ * ssd device, and every change after a checkpoint is appended to a journal:
+ * a buffer taking a new tag (JOURNAL_INSERT), becoming dirty or becoming
+ * clean. Up to JOURNAL_FLUSH_RECORDS changes are buffered before they are
+ * written. A full journal triggers a new checkpoint.
+ *
+ * Records are written after the blocks they describe, and the inner ssd
+ * state is only saved with a checkpoint, so after a crash the metadata can
+ * point at blocks that were overwritten or lost. Only a shutdown through
+ * checkpointSSDBuffer() leaves them consistent, and it marks the header.
+ *
+ * Called once the devices are open. With WARM_RESTART set and a cleanly
+ * shut down cache on the device, the last checkpoint and its journal are
+ * replayed into the descriptors, hash table and strategy, the inner ssd
+ * state is restored, and the time it took is kept in restore_time_us.
+ * Otherwise the cache starts cold.
+ */
+void
+initCheckpoint()
+{
+	unsigned long	buffer_size = BandOrBlock == 1 ? BNDSZ : SSD_BUFFER_SIZE;
+	struct timeval	tv_begin, tv_end;
+
+	metadata_offset = ROUNDUP(NSSDBuffers * buffer_size);
+	area_size = ROUNDUP(NSSDBuffers * sizeof(CheckpointEntry));
+	journal_offset = metadata_offset + CHECKPOINT_HEADER_SIZE + 2 * area_size;
+
+	journal_buffer = (JournalRecord *) malloc(sizeof(JournalRecord) * JOURNAL_FLUSH_RECORDS);
+	memset(&checkpoint_header, 0, sizeof(CheckpointHeader));
+	nbuffered = 0;
+	njournal = 0;
+	journal_enabled = 0;
+	restore_time_us = 0;
+	restored_buffers = 0;
+	checkpoint_times = 0;
+	journal_records = 0;
+
+	pthread_mutex_lock(&ssd_buf_mutex);
+	if (WARM_RESTART) {
+		gettimeofday(&tv_begin, NULL);
+		if (restoreCheckpoint())
+			restoreSSD();
+		gettimeofday(&tv_end, NULL);
+		restore_time_us = (tv_end.tv_sec - tv_begin.tv_sec) * 1000000 + tv_end.tv_usec - tv_begin.tv_usec;
+	}
+	/* start a journal generation of our own, older records no longer match and the header is no longer clean */
+	writeCheckpoint();
+	journal_enabled = 1;
+	pthread_mutex_unlock(&ssd_buf_mutex);
+}
+
+/*
+ * Clean shutdown, once no more requests come: the buffered journal records
+ * and the inner ssd state are written, and then the header is marked clean.
+ * The sync keeps the mark from reaching the device before the journal.
+ */
+void
+checkpointSSDBuffer()
+{
+	pthread_mutex_lock(&ssd_buf_mutex);
+	if (nbuffered > 0)
+		flushJournal();
+	checkpointSSD();
+	fdatasync(ssd_fd);
+	checkpoint_header.clean_shutdown = 1;
+	writeMetadata(&checkpoint_header, sizeof(CheckpointHeader), metadata_offset);
+	fdatasync(ssd_fd);
+	pthread_mutex_unlock(&ssd_buf_mutex);
+}
+
+/* ssd_buf_mutex held */
+void
+journalSSDBuffer(unsigned short op, SSDBufferDesc * ssd_buf_hdr)
+{
+	JournalRecord  *record;
+
+	if (!journal_enabled)
+		return;
+	record = &journal_buffer[nbuffered++];
+	record->offset = ssd_buf_hdr->ssd_buf_tag.offset;
+	record->ssd_buf_id = ssd_buf_hdr->ssd_buf_id;
+	record->op = op;
+	record->seq = checkpoint_header.checkpoint_seq & 0xffff;
+	journal_records++;
+	if (nbuffered == JOURNAL_FLUSH_RECORDS)
+		flushJournal();
+}
+
+static void
+flushJournal()
+{
+	if (njournal + nbuffered > JOURNAL_RECORDS) {
+		writeCheckpoint();
+		return;
+	}
+	writeMetadata(journal_buffer, sizeof(JournalRecord) * nbuffered, journal_offset + njournal * sizeof(JournalRecord));
+	njournal += nbuffered;
+	nbuffered = 0;
+}
+
+/*
+ * Only buffers still reachable through the hash table are recorded; slots
+ * a strategy freed keep their old tag but are not cached anymore. Buffers
+ * a destager is writing back are still dirty.
+ */
+static void
+writeCheckpoint()
+{
+	CheckpointEntry *entries = (CheckpointEntry *) malloc(area_size);
+	SSDBufferDesc  *ssd_buf_hdr;
+	long		i, n = 0;
+
+	/* descriptors past n_initssd were never used */
+	for (i = 0; i < ssd_buffer_strategy_control->n_initssd; i++) {
+		ssd_buf_hdr = &ssd_buffer_descriptors[i];
+		if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_VALID) == 0 || ssdbuftableLookup(&ssd_buf_hdr->ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_hdr->ssd_buf_tag)) != i)
+			continue;
+		entries[n].offset = ssd_buf_hdr->ssd_buf_tag.offset;
+		entries[n].ssd_buf_id = i;
+		entries[n].ssd_buf_flag = ssd_buf_hdr->ssd_buf_flag & (SSD_BUF_VALID | SSD_BUF_DIRTY);
+		n++;
+	}
+
+	checkpoint_header.magic = CHECKPOINT_MAGIC;
+	checkpoint_header.checkpoint_seq++;
+	checkpoint_header.nssdbuffers = NSSDBuffers;
+	checkpoint_header.buffer_size = BandOrBlock == 1 ? BNDSZ : SSD_BUFFER_SIZE;
+	checkpoint_header.strategy = EvictStrategy;
+	checkpoint_header.band_or_block = BandOrBlock;
+	checkpoint_header.nentries = n;
+	checkpoint_header.clean_shutdown = 0;
+	if (n > 0)
+		writeMetadata(entries, sizeof(CheckpointEntry) * n, metadata_offset + CHECKPOINT_HEADER_SIZE + (checkpoint_header.checkpoint_seq % 2) * area_size);
+	writeMetadata(&checkpoint_header, sizeof(CheckpointHeader), metadata_offset);
+	free(entries);
+
+	checkpointSSD();
+
+	nbuffered = 0;
+	njournal = 0;
+	checkpoint_times++;
+}
+
+/*
+ * The hash table is kept in step with the restored state, so a tag taken
+ * over by another buffer later in the journal drops the older buffer.
+ */
+static void
+restoreEntry(long ssd_buf_id, off_t offset, unsigned ssd_buf_flag)
+{
+	SSDBufferTag	ssd_buf_tag;
+	unsigned long	ssd_buf_hash;
+	long		other;
+
+	if (ssd_buf_id < 0 || ssd_buf_id >= NSSDBuffers)
+		return;
+	if (restored_flag[ssd_buf_id] & SSD_BUF_VALID) {
+		ssd_buf_tag.offset = restored_offset[ssd_buf_id];
+		ssd_buf_hash = ssdbuftableHashcode(&ssd_buf_tag);
+		if (ssdbuftableLookup(&ssd_buf_tag, ssd_buf_hash) == ssd_buf_id)
+			ssdbuftableDelete(&ssd_buf_tag, ssd_buf_hash);
+	}
+	ssd_buf_tag.offset = offset;
+	ssd_buf_hash = ssdbuftableHashcode(&ssd_buf_tag);
+	other = ssdbuftableLookup(&ssd_buf_tag, ssd_buf_hash);
+	if (other >= 0) {
+		restored_flag[other] = 0;
+		ssdbuftableDelete(&ssd_buf_tag, ssd_buf_hash);
+	}
+	ssdbuftableInsert(&ssd_buf_tag, ssd_buf_hash, ssd_buf_id);
+	restored_offset[ssd_buf_id] = offset;
+	restored_flag[ssd_buf_id] = ssd_buf_flag | SSD_BUF_VALID;
+	last_touch[ssd_buf_id] = ++touch_clock;
+}
+
+static int
+compareLastTouch(const void *a, const void *b)
+{
+	unsigned long	x = last_touch[*(const long *) a];
+	unsigned long	y = last_touch[*(const long *) b];
+
+	return x < y ? -1 : x > y;
+}
+
+/* returns false for a cold start */
+static bool
+restoreCheckpoint()
+{
+	CheckpointHeader header;
+	CheckpointEntry *entries;
+	JournalRecord  *records;
+	unsigned long	i, j, nrecords;
+	long		n;
+	long	       *ssd_buf_ids;
+
+	readMetadata(&header, sizeof(CheckpointHeader), metadata_offset);
+	if (header.magic != CHECKPOINT_MAGIC || header.nssdbuffers != NSSDBuffers || header.buffer_size != (BandOrBlock == 1 ? BNDSZ : SSD_BUFFER_SIZE) || header.strategy != EvictStrategy || header.band_or_block != BandOrBlock || header.nentries > NSSDBuffers) {
+		if (DEBUG)
+			printf("[INFO] restoreCheckpoint():--------no checkpoint for this configuration, cold start\n");
+		return 0;
+	}
+	if (!header.clean_shutdown) {
+		printf("[INFO] restoreCheckpoint():--------cache was not shut down cleanly, cold start\n");
+		return 0;
+	}
+	checkpoint_header = header;
+
+	restored_offset = (off_t *) malloc(sizeof(off_t) * NSSDBuffers);
+	restored_flag = (unsigned *) calloc(NSSDBuffers, sizeof(unsigned));
+	last_touch = (unsigned long *) calloc(NSSDBuffers, sizeof(unsigned long));
+	touch_clock = 0;
+
+	entries = (CheckpointEntry *) malloc(area_size);
+	if (header.nentries > 0)
+		readMetadata(entries, sizeof(CheckpointEntry) * header.nentries, metadata_offset + CHECKPOINT_HEADER_SIZE + (header.checkpoint_seq % 2) * area_size);
+	for (i = 0; i < header.nentries; i++)
+		restoreEntry(entries[i].ssd_buf_id, entries[i].offset, entries[i].ssd_buf_flag);
+	free(entries);
+
+	records = (JournalRecord *) malloc(sizeof(JournalRecord) * JOURNAL_FLUSH_RECORDS);
+	for (i = 0; i < JOURNAL_RECORDS; i += nrecords) {
+		nrecords = JOURNAL_RECORDS - i < JOURNAL_FLUSH_RECORDS ? JOURNAL_RECORDS - i : JOURNAL_FLUSH_RECORDS;
+		readMetadata(records, sizeof(JournalRecord) * nrecords, journal_offset + i * sizeof(JournalRecord));
+		for (j = 0; j < nrecords; j++) {
+			if (records[j].seq != (header.checkpoint_seq & 0xffff) || records[j].ssd_buf_id >= NSSDBuffers)
+				break;
+			if (records[j].op == JOURNAL_INSERT)
+				restoreEntry(records[j].ssd_buf_id, records[j].offset, SSD_BUF_VALID);
+			else if (records[j].op == JOURNAL_DIRTY && (restored_flag[records[j].ssd_buf_id] & SSD_BUF_VALID))
+				restored_flag[records[j].ssd_buf_id] |= SSD_BUF_DIRTY;
+			else if (records[j].op == JOURNAL_CLEAN)
+				restored_flag[records[j].ssd_buf_id] &= ~SSD_BUF_DIRTY;
+			else if (records[j].op != JOURNAL_DIRTY)
+				break;
+		}
+		if (j < nrecords)
+			break;
+	}
+	free(records);
+
+	/* hand the buffers to the strategy oldest first */
+	ssd_buf_ids = (long *) malloc(sizeof(long) * NSSDBuffers);
+	n = 0;
+	for (i = 0; i < NSSDBuffers; i++)
+		if (restored_flag[i] & SSD_BUF_VALID)
+			ssd_buf_ids[n++] = i;
+	qsort(ssd_buf_ids, n, sizeof(long), compareLastTouch);
+	rebuildSSDBuffer(ssd_buf_ids, n, restored_offset, restored_flag);
+	restored_buffers = n;
+
+	free(ssd_buf_ids);
+	free(restored_offset);
+	free(restored_flag);
+	free(last_touch);
+	return 1;
+}
+
+static void
+writeMetadata(void *buf, size_t size, off_t offset)
+{
+	int		returnCode = pwrite(ssd_fd, buf, size, offset);
+
+	if (returnCode < 0) {
+		printf("[ERROR] writeMetadata():-------write to ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
+		exit(-1);
+	}
+	countSSDNandWrite(size);
+}
+
+/* a short read past the end of the device reads as zeros, i.e. no checkpoint */
+static void
+readMetadata(void *buf, size_t size, off_t offset)
+{
+	int		returnCode = pread(ssd_fd, buf, size, offset);
+
+	if (returnCode < 0) {
+		printf("[ERROR] readMetadata():-------read from ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
+		exit(-1);
+	}
+	if (returnCode < size)
+		memset((char *) buf + returnCode, 0, size - returnCode);
+}
@@ -0,0 +1,60 @@
+#ifndef SMR_SSD_CACHE_CHECKPOINT_H
+#define SMR_SSD_CACHE_CHECKPOINT_H
+
+#define DEBUG 0
+/* ---------------------------checkpoint---------------------------- */
+
+#define CHECKPOINT_MAGIC 0x534d52434b505431UL	// "SMRCKPT1"
+#define CHECKPOINT_HEADER_SIZE 4096
+
+/*
+ * Metadata region past the cached blocks on the ssd device:
+ *   header | entry area 0 | entry area 1 | journal
+ * A checkpoint writes its entries to area (checkpoint_seq % 2) and then the
+ * header, so a torn checkpoint leaves the previous one readable. The
+ * journal is not written ahead of the cached blocks, so the metadata only
+ * matches the devices after a clean shutdown; clean_shutdown says so.
+ */
+typedef struct
+{
+	unsigned long	magic;
+	unsigned long	checkpoint_seq;		// bumped by every checkpoint, stamped on journal records
+	unsigned long	nssdbuffers;
+	unsigned long	buffer_size;
+	unsigned long	strategy;
+	unsigned long	band_or_block;
+	unsigned long	nentries;			// CheckpointEntry records in the current area
+	unsigned long	clean_shutdown;		// set by checkpointSSDBuffer(), cleared by the next checkpoint
+} CheckpointHeader;
+
+typedef struct
+{
+	off_t		offset;
+	unsigned int	ssd_buf_id;
+	unsigned int	ssd_buf_flag;
+} CheckpointEntry;
+
+#define JOURNAL_INSERT 1
+#define JOURNAL_DIRTY 2
+#define JOURNAL_CLEAN 3
+
+typedef struct
+{
+	off_t		offset;
+	unsigned int	ssd_buf_id;
+	unsigned short	op;
+	unsigned short	seq;				// checkpoint_seq & 0xffff, a record from an older checkpoint ends the journal
+} JournalRecord;
+
+extern unsigned long WARM_RESTART;
+extern unsigned long JOURNAL_RECORDS;
+extern unsigned long JOURNAL_FLUSH_RECORDS;
+extern unsigned long restore_time_us;
+extern unsigned long restored_buffers;
+extern unsigned long checkpoint_times;
+extern unsigned long journal_records;
+
+extern void initCheckpoint();
+extern void checkpointSSDBuffer();
+extern void journalSSDBuffer(unsigned short op, SSDBufferDesc *ssd_buf_hdr);
+#endif
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "smr-simulator/zoned.h"
+#include "destage.h"
+#include "checkpoint.h"
+#include "strategy/costbenefit.h"
+
+static void    *destageSSDBuffers();
+static bool	needDestage();
+static void	unlinkDirty(long ssd_buf_id);
+static int	compareDestageRequest(const void *a, const void *b);
+
+/*
+ * Dirty buffers are kept in a list in the order they became dirty. When the
+ * number of clean slots (free or clean cached) drops below
+ * DESTAGE_LOW_WATERMARK, NDESTAGERS threads write back the oldest dirty
+ * buffers until DESTAGE_HIGH_WATERMARK slots are clean, so the eviction
+ * paths mostly find clean victims and skip flushSSDBuffer(). Each destager
+ * takes up to DESTAGE_WINDOW of them at a time and writes them back in one
+ * ascending sweep by offset, continuing from where the last window ended.
+ * The window is written back drive by drive of the smr array, each under
+ * that drive's smrwrite_mutex, so destagers can write to different drives
+ * at the same time.
+ *
+ * Everything here is protected by ssd_buf_mutex; the write back itself
+ * runs unlocked with the buffer marked SSD_BUF_DESTAGING. The buffer stays
+ * dirty until its write back is done, so an eviction path flushing it waits
+ * for the destager first and a write to it in the meantime keeps it dirty.
+ */
+void
+initDestager()
+{
+	pthread_t	destage_tid;
+	int		err;
+	long		i;
+
+	ssd_buffer_strategy_control_for_destage = (SSDBufferStrategyControlForDestage *) malloc(sizeof(SSDBufferStrategyControlForDestage));
+	ssd_buffer_strategy_control_for_destage->n_dirtyssd = 0;
+	ssd_buffer_strategy_control_for_destage->n_destagingssd = 0;
+	ssd_buffer_strategy_control_for_destage->first_dirtyssd = -1;
+	ssd_buffer_strategy_control_for_destage->last_dirtyssd = -1;
+	ssd_buffer_strategy_control_for_destage->active = 0;
+	ssd_buffer_strategy_control_for_destage->sweep_offset = 0;
+
+	ssd_buffer_descriptors_for_destage = (SSDBufferDescForDestage *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForDestage));
+	destage_blocks = 0;
+	sync_flush_blocks = 0;
+
+	pthread_mutex_init(&ssd_buf_mutex, NULL);
+	pthread_cond_init(&destage_cond, NULL);
+	pthread_cond_init(&destage_done_cond, NULL);
+
+	if (DESTAGE_HIGH_WATERMARK > NSSDBuffers)
+		DESTAGE_HIGH_WATERMARK = NSSDBuffers;
+	if (DESTAGE_WINDOW < 1)
+		DESTAGE_WINDOW = 1;
+	if (DESTAGE_LOW_WATERMARK > DESTAGE_HIGH_WATERMARK)
+		DESTAGE_LOW_WATERMARK = DESTAGE_HIGH_WATERMARK;
+	for (i = 0; i < NDESTAGERS; i++) {
+		err = pthread_create(&destage_tid, NULL, destageSSDBuffers, NULL);
+		if (err != 0) {
+			printf("[ERROR] initDestager: fail to create thread: %s\n", strerror(err));
+			exit(-1);
+		}
+	}
+}
+
+/* set up by initSSDBufferDesc() when the buffer first reaches the head of the free list */
+void
+initSSDBufferDescForDestage(long ssd_buf_id)
+{
+	SSDBufferDescForDestage *ssd_buf_hdr_for_destage = &ssd_buffer_descriptors_for_destage[ssd_buf_id];
+
+	ssd_buf_hdr_for_destage->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_destage->next_dirty = -1;
+	ssd_buf_hdr_for_destage->last_dirty = -1;
+}
+
+static void
+unlinkDirty(long ssd_buf_id)
+{
+	SSDBufferDescForDestage *ssd_buf_hdr_for_destage = &ssd_buffer_descriptors_for_destage[ssd_buf_id];
+
+	if (ssd_buf_hdr_for_destage->last_dirty >= 0)
+		ssd_buffer_descriptors_for_destage[ssd_buf_hdr_for_destage->last_dirty].next_dirty = ssd_buf_hdr_for_destage->next_dirty;
+	else
+		ssd_buffer_strategy_control_for_destage->first_dirtyssd = ssd_buf_hdr_for_destage->next_dirty;
+	if (ssd_buf_hdr_for_destage->next_dirty >= 0)
+		ssd_buffer_descriptors_for_destage[ssd_buf_hdr_for_destage->next_dirty].last_dirty = ssd_buf_hdr_for_destage->last_dirty;
+	else
+		ssd_buffer_strategy_control_for_destage->last_dirtyssd = ssd_buf_hdr_for_destage->last_dirty;
+	ssd_buf_hdr_for_destage->next_dirty = -1;
+	ssd_buf_hdr_for_destage->last_dirty = -1;
+	ssd_buffer_strategy_control_for_destage->n_dirtyssd--;
+}
+
+/*
+ * clean slots below the low watermark starts a round, the high watermark ends
+ * it. A round starts its sweep at offset 0 and keeps it until it ends.
+ */
+static bool
+needDestage()
+{
+	unsigned long	clean_slots = NSSDBuffers - ssd_buffer_strategy_control_for_destage->n_dirtyssd + ssd_buffer_strategy_control_for_destage->n_destagingssd;
+
+	if (clean_slots < DESTAGE_LOW_WATERMARK && !ssd_buffer_strategy_control_for_destage->active) {
+		ssd_buffer_strategy_control_for_destage->active = 1;
+		ssd_buffer_strategy_control_for_destage->sweep_offset = 0;
+	} else if (clean_slots >= DESTAGE_HIGH_WATERMARK)
+		ssd_buffer_strategy_control_for_destage->active = 0;
+	return ssd_buffer_strategy_control_for_destage->active && ssd_buffer_strategy_control_for_destage->n_dirtyssd > ssd_buffer_strategy_control_for_destage->n_destagingssd;
+}
+
+void
+markSSDBufferDirty(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferDescForDestage *ssd_buf_hdr_for_destage = &ssd_buffer_descriptors_for_destage[ssd_buf_hdr->ssd_buf_id];
+
+	if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DIRTY) == 0) {
+		ssd_buf_hdr_for_destage->next_dirty = -1;
+		ssd_buf_hdr_for_destage->last_dirty = ssd_buffer_strategy_control_for_destage->last_dirtyssd;
+		if (ssd_buffer_strategy_control_for_destage->last_dirtyssd >= 0)
+			ssd_buffer_descriptors_for_destage[ssd_buffer_strategy_control_for_destage->last_dirtyssd].next_dirty = ssd_buf_hdr->ssd_buf_id;
+		else
+			ssd_buffer_strategy_control_for_destage->first_dirtyssd = ssd_buf_hdr->ssd_buf_id;
+		ssd_buffer_strategy_control_for_destage->last_dirtyssd = ssd_buf_hdr->ssd_buf_id;
+		ssd_buffer_strategy_control_for_destage->n_dirtyssd++;
+		journalSSDBuffer(JOURNAL_DIRTY, ssd_buf_hdr);
+		if (EvictStrategy == CostBenefit)
+			dirtyInCostBenefitBuffer(ssd_buf_hdr, 1);
+	} else if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DESTAGING) != 0)
+		ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_REDIRTIED;
+	ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID | SSD_BUF_DIRTY;
+	if (NDESTAGERS > 0 && needDestage())
+		pthread_cond_signal(&destage_cond);
+}
+
+/* not for a buffer being destaged, its destager marks it clean when done */
+void
+markSSDBufferClean(SSDBufferDesc * ssd_buf_hdr)
+{
+	if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DIRTY) != 0) {
+		unlinkDirty(ssd_buf_hdr->ssd_buf_id);
+		journalSSDBuffer(JOURNAL_CLEAN, ssd_buf_hdr);
+		if (EvictStrategy == CostBenefit)
+			dirtyInCostBenefitBuffer(ssd_buf_hdr, -1);
+	}
+	ssd_buf_hdr->ssd_buf_flag &= ~(SSD_BUF_DIRTY | SSD_BUF_REDIRTIED);
+}
+
+/* the slot is about to be flushed or reused for another tag */
+void
+waitSSDBufferDestaged(SSDBufferDesc * ssd_buf_hdr)
+{
+	while ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DESTAGING) != 0)
+		pthread_cond_wait(&destage_done_cond, &ssd_buf_mutex);
+}
+
+static int
+compareDestageRequest(const void *a, const void *b)
+{
+	off_t		x = ((const DestageRequest *) a)->ssd_buf_tag.offset;
+	off_t		y = ((const DestageRequest *) b)->ssd_buf_tag.offset;
+
+	return x < y ? -1 : x > y;
+}
+
+static void    *
+destageSSDBuffers()
+{
+	SSDBufferDesc  *ssd_buf_hdr;
+	DestageRequest *window = (DestageRequest *) malloc(sizeof(DestageRequest) * DESTAGE_WINDOW);
+	long	       *ssd_buf_ids = (long *) malloc(sizeof(long) * DESTAGE_WINDOW);
+	SSDBufferTag   *ssd_buf_tags = (SSDBufferTag *) malloc(sizeof(SSDBufferTag) * DESTAGE_WINDOW);
+	long		nwindow, start, i, k, next, d, drive_num, ndrive;
+	static long	next_drive;		// drive a destager starts its window with
+
+	pthread_mutex_lock(&ssd_buf_mutex);
+	while (1) {
+		while (!needDestage())
+			pthread_cond_wait(&destage_cond, &ssd_buf_mutex);
+
+		/* oldest dirty buffers, skipping ones another destager is writing back */
+		nwindow = 0;
+		next = ssd_buffer_strategy_control_for_destage->first_dirtyssd;
+		while (nwindow < DESTAGE_WINDOW && next >= 0 && needDestage()) {
+			ssd_buf_hdr = &ssd_buffer_descriptors[next];
+			next = ssd_buffer_descriptors_for_destage[next].next_dirty;
+			if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DESTAGING) != 0)
+				continue;
+			ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_DESTAGING;
+			ssd_buffer_strategy_control_for_destage->n_destagingssd++;
+			window[nwindow].ssd_buf_id = ssd_buf_hdr->ssd_buf_id;
+			window[nwindow].ssd_buf_tag = ssd_buf_hdr->ssd_buf_tag;
+			nwindow++;
+		}
+		if (nwindow == 0) {
+			pthread_cond_wait(&destage_done_cond, &ssd_buf_mutex);
+			continue;
+		}
+		qsort(window, nwindow, sizeof(DestageRequest), compareDestageRequest);
+		for (start = 0; start < nwindow && window[start].ssd_buf_tag.offset < ssd_buffer_strategy_control_for_destage->sweep_offset; start++);
+		/* a host-managed drive takes the window zone by zone, in offset order */
+		if (start == nwindow || ZONED_SMR)
+			start = 0;
+		ssd_buffer_strategy_control_for_destage->sweep_offset = window[(start + nwindow - 1) % nwindow].ssd_buf_tag.offset + 1;
+		/* concurrent destagers start on different drives */
+		drive_num = next_drive++ % NSMRDrives;
+		pthread_mutex_unlock(&ssd_buf_mutex);
+
+		/* the part of one window on one drive reaches it as an uninterrupted sweep */
+		for (d = 0; d < NSMRDrives; d++, drive_num = (drive_num + 1) % NSMRDrives) {
+			for (i = 0, ndrive = 0; i < nwindow; i++) {
+				if (GetSMRDriveNumFromSSD(window[(start + i) % nwindow].ssd_buf_tag.offset) != drive_num)
+					continue;
+				ssd_buf_ids[ndrive] = window[(start + i) % nwindow].ssd_buf_id;
+				ssd_buf_tags[ndrive] = window[(start + i) % nwindow].ssd_buf_tag;
+				ndrive++;
+			}
+			if (ndrive == 0)
+				continue;
+			pthread_mutex_lock(&smr_drives[drive_num].smrwrite_mutex);
+			for (i = 0; i < ndrive; i = k) {
+				/* a host-managed drive rewrites each zone of the window once */
+				for (k = i + 1; ZONED_SMR && k < ndrive && GetSMRBandNumFromSSD(ssd_buf_tags[k].offset) == GetSMRBandNumFromSSD(ssd_buf_tags[i].offset); k++);
+				writeBackSSDBuffers(ssd_buf_ids + i, ssd_buf_tags + i, k - i);
+			}
+			pthread_mutex_unlock(&smr_drives[drive_num].smrwrite_mutex);
+		}
+
+		pthread_mutex_lock(&ssd_buf_mutex);
+		for (i = 0; i < nwindow; i++) {
+			ssd_buf_hdr = &ssd_buffer_descriptors[window[i].ssd_buf_id];
+			ssd_buf_hdr->ssd_buf_flag &= ~SSD_BUF_DESTAGING;
+			ssd_buffer_strategy_control_for_destage->n_destagingssd--;
+			if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_REDIRTIED) != 0)
+				ssd_buf_hdr->ssd_buf_flag &= ~SSD_BUF_REDIRTIED;
+			else
+				markSSDBufferClean(ssd_buf_hdr);
+		}
+		destage_blocks += nwindow;
+		pthread_cond_broadcast(&destage_done_cond);
+		if (DEBUG)
+			printf("[INFO] destageSSDBuffers():--------nwindow=%ld n_dirtyssd=%ld\n", nwindow, ssd_buffer_strategy_control_for_destage->n_dirtyssd);
+	}
+	return NULL;
+}
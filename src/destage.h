@@ -0,0 +1,49 @@
+#ifndef SMR_SSD_CACHE_DESTAGE_H
+#define SMR_SSD_CACHE_DESTAGE_H
+
+#define DEBUG 0
+/* ---------------------------destager---------------------------- */
+#include <pthread.h>
+
+typedef struct
+{
+	long		ssd_buf_id;			// ssd buffer location in shared buffer
+	long		next_dirty;			// to link dirty ssd, oldest first
+	long		last_dirty;
+} SSDBufferDescForDestage;
+
+typedef struct
+{
+	long		n_dirtyssd;			// # of buffers with SSD_BUF_DIRTY set
+	long		n_destagingssd;		// of them being written back, counted clean by the watermarks
+	long		first_dirtyssd;		// Head of list of dirty ssds, destaged first
+	long		last_dirtyssd;		// Tail of list of dirty ssds
+	bool		active;				// cleaning until the high watermark is reached
+	off_t		sweep_offset;		// where the last destage window ended
+} SSDBufferStrategyControlForDestage;
+
+typedef struct
+{
+	long		ssd_buf_id;
+	SSDBufferTag	ssd_buf_tag;		// tag when picked, the slot may be retagged after
+} DestageRequest;
+
+extern unsigned long NDESTAGERS;
+extern unsigned long DESTAGE_LOW_WATERMARK;
+extern unsigned long DESTAGE_HIGH_WATERMARK;
+extern unsigned long DESTAGE_WINDOW;
+extern unsigned long destage_blocks;
+extern unsigned long sync_flush_blocks;
+extern pthread_mutex_t ssd_buf_mutex;
+
+SSDBufferDescForDestage *ssd_buffer_descriptors_for_destage;
+SSDBufferStrategyControlForDestage *ssd_buffer_strategy_control_for_destage;
+pthread_cond_t destage_cond;		// signalled when clean slots drop below the low watermark
+pthread_cond_t destage_done_cond;	// broadcast when a buffer leaves SSD_BUF_DESTAGING
+
+extern void initDestager();
+extern void initSSDBufferDescForDestage(long ssd_buf_id);
+extern void markSSDBufferDirty(SSDBufferDesc *ssd_buf_hdr);
+extern void markSSDBufferClean(SSDBufferDesc *ssd_buf_hdr);
+extern void waitSSDBufferDestaged(SSDBufferDesc *ssd_buf_hdr);
+#endif
@@ -1,6 +1,9 @@
 #include "ssd-cache.h"
 #include "smr-simulator/smr-simulator.h"
+#include "smr-simulator/zoned.h"
 #include "main.h"
+#include "tracegen.h"
+#include "admission.h"
 
 int BandOrBlock = 1;
 /* Block = 0,Band =1*/
@@ -13,8 +16,11 @@ unsigned long SSD_BUFFER_SIZE = 4096;
 unsigned long NSMRBands = 194180;		// 194180*(18MB+36MB)/2~5TB
 unsigned long NSMRBlocks = 2621952;		// 2621952*8KB~20GB
 //unsigned long NSSDs = 2621952;		// 2621952*8KB~20GB
-unsigned long NSSDs = 100000;
+unsigned long NSSDs = 100000;			// inner ssd blocks of each smr drive
 unsigned long NSSDTables = 100000;
+unsigned long NSMRDrives = 1;			// smr drives in the array, the bands striped over them
+unsigned long CACHE_PARTITIONS = 1;		// ssd cache partitions, one process per cpu each
+long		cache_partition;		// of this process
 unsigned long NBANDTables = 2621952;
 /*unsigned long NSMRBands = 500;		// 569*36MB~20GB
 unsigned long NSMRBlocks = 500;		// 2621952*8KB~20GB
@@ -27,7 +33,55 @@ size_t BNDSZ = 36*1024*1024;
 unsigned long INTERVALTIMELIMIT = 1000;
 unsigned long NSSDLIMIT = 500000;
 unsigned long NSSDCLEAN = 20000;
+unsigned long ELEVATOR_CLEAN = 1;		// inner ssd cleaner flushes bands in offset order
+unsigned long SMR_TRACK_SIZE = 1024 * 1024;	// shingled track, 0 rewrites whole bands
+SSDCleanPolicy CleanPolicy = CleanFIFO;		// which bands the inner ssd cleaner flushes
+char	       *clean_policy_names[] = {"FIFO", "Greedy", "CostBenefit"};
+unsigned long ZONED_SMR = 0;			// host-managed zoned smr instead of the drive-managed one
+unsigned long ZONED_MAX_OPEN = 128;		// zones open for writing at once
 unsigned long WRITEAMPLIFICATION = 100;
+unsigned long WA_AUTOTUNE = 0;			// hill-climb WRITEAMPLIFICATION while the trace runs, see WA.c
+unsigned long WA_TUNE_EPOCH_BLOCKS = 20000;	// request blocks between two threshold steps
+unsigned long KIN_PERCENT_2Q = 25;		// A1in size for 2Q, % of NSSDBuffers
+unsigned long KOUT_PERCENT_2Q = 50;		// A1out ghost size for 2Q, % of NSSDBuffers
+unsigned long COSTBENEFIT_CANDIDATES = 32;	// bands with the oldest pages a CostBenefit eviction scores
+unsigned long NDESTAGERS = 0;			// background destager threads, 0 flushes only on eviction
+unsigned long DESTAGE_LOW_WATERMARK = 5000;	// clean slots that wake the destagers
+unsigned long DESTAGE_HIGH_WATERMARK = 20000;	// clean slots at which they stop
+unsigned long DESTAGE_WINDOW = 64;		// dirty buffers a destager sorts into one sweep
+unsigned long WARM_RESTART = 0;			// rebuild the cache from the checkpoint on the ssd at startup
+unsigned long JOURNAL_RECORDS = 1048576;	// journal records between two checkpoints
+unsigned long JOURNAL_FLUSH_RECORDS = 256;	// journal records buffered before they are written
+unsigned long USE_HUGEPAGES = 0;		// back descriptor arrays and hash tables with huge pages
+unsigned long WEAR_LEVELING = 0;		// reuse the least worn free ssd slots first, band strategies and SCAN only
+unsigned long SSD_ERASE_BLOCK_MB = 4;		// cache ssd model for the nand write estimate...
+unsigned long SSD_OVERPROVISION_PERCENT = 28;
+unsigned long SSD_PE_CYCLES = 3000;		// ...and its lifetime
+unsigned long STAGING_BUFFER_MB = 0;		// dram staging buffer in front of the ssd cache (block mode), 0 writes through
+unsigned long STAGING_BATCH_BLOCKS = 64;	// staged blocks written to the ssd cache at once
+SSDAdmissionPolicy AdmissionPolicy = AdmitAll;	// which write misses get an ssd slot, the rest go to smr
+char	       *admission_policy_names[] = {"All", "Ghost", "TinyLFU"};
+unsigned long ADMISSION_GHOST_PERCENT = 100;	// AdmitGhost: rejected misses remembered, % of NSSDBuffers
+unsigned long ADMISSION_MIN_FREQUENCY = 2;	// AdmitTinyLFU: sketch estimate a miss needs
+unsigned long BAND_HOTNESS = 0;			// LRUofBand, Most and WA pass over bands written lately, see band_hotness.c
+unsigned long BAND_HOTNESS_WIDTH = 4096;	// counters per sketch row, whatever NSMRBands is
+unsigned long BAND_HOTNESS_HALF_LIFE = 0;	// blocks written between two halvings, 0 is 10 * BAND_HOTNESS_WIDTH
+unsigned long BAND_HOTNESS_CANDIDATES = 4;	// victim bands compared per eviction
+unsigned long WARMUP_REQUESTS = 0;		// trace lines replayed before the counters start, 0 counts from the first
+unsigned long RECORD_LATENCY = 1;		// histogram of request latencies for the p50/p99 report
+unsigned long TRACEGEN_REQUESTS = 0;		// generate a trace of this many requests before replaying it, 0 replays the file as is
+unsigned long TRACEGEN_SEED = 1;
+TraceGenPattern TRACEGEN_PATTERN = TRACEGEN_ZIPF;
+double TRACEGEN_ZIPF_THETA = 0.99;
+unsigned long TRACEGEN_WORKING_SET_MB = 4096;	// requests fall in the first 4GB of the smr disk
+unsigned long TRACEGEN_REQUEST_KB = 4;
+unsigned long TRACEGEN_READ_PERCENT = 0;
+unsigned long TRACEGEN_HOT_BAND_PERCENT = 10;	// TRACEGEN_HOTBAND: 10% of the bands...
+unsigned long TRACEGEN_HOT_ACCESS_PERCENT = 90;	// ...get 90% of the requests
+unsigned long TRACEGEN_STREAMS = 4;		// TRACEGEN_SEQUENTIAL: interleaved streams
+unsigned long TRACEGEN_BURST_PERCENT = 0;	// requests that start a burst from the first byte of a band
+unsigned long TRACEGEN_BURST_KB = 1024;
+unsigned long TRACEGEN_INTERVAL_US = 10;	// between two request timestamps
 //unsigned long NSSDLIMIT = 2500000;
 //unsigned long NSSDCLEAN = 100000;
 /*unsigned long INTERVALTIMELIMIT = 1000;
@@ -48,30 +102,62 @@ SSDEvictionStrategy EvictStrategy = Most;
 //SSDEvictionStrategy EvictStrategy = LRU;
 //SSDEvictionStrategy EvictStrategy = SCAN;
 //SSDEvictionStrategy EvictStrategy = WA;
+//SSDEvictionStrategy EvictStrategy = Most_Bucket;
+//SSDEvictionStrategy EvictStrategy = ARC;
+//SSDEvictionStrategy EvictStrategy = TwoQ;
+//SSDEvictionStrategy EvictStrategy = CostBenefit;
 //int BandOrBlock = 0;
 /*Block = 0, Band=1*/
-int 		    smr_fd;
 int 		    ssd_fd;
-int 		    inner_ssd_fd;
-unsigned long	interval_time;
 unsigned long hit_num;
 unsigned long flush_bands;
 unsigned long flush_fifo_blocks;
+unsigned long smr_seeks;
+unsigned long smr_seek_distance;
+unsigned long smrwrite_band_switches;
+unsigned long flush_band_blocks;
+unsigned long flush_band_syscalls;
+unsigned long flush_band_read_bytes;
+unsigned long flush_band_write_bytes;
+unsigned long clean_stalls;
+unsigned long zone_resets;
+unsigned long zone_reset_bytes;
+unsigned long zone_finishes;
+unsigned long zone_write_bytes;
 unsigned long flush_ssd_blocks;
 //unsigned long write-fifo-num;
 //unsigned long write-ssd-num;
 unsigned long flush_fifo_times;
+unsigned long destage_blocks;
+unsigned long sync_flush_blocks;
+unsigned long restore_time_us;
+unsigned long restored_buffers;
+unsigned long checkpoint_times;
+unsigned long journal_records;
+unsigned long staging_write_blocks;
+unsigned long staging_coalesced_blocks;
+unsigned long staging_read_hits;
+unsigned long admitted_blocks;
+unsigned long bypassed_blocks;
+unsigned long band_hotness_touches;
+unsigned long band_hotness_queries;
+unsigned long band_hotness_halvings;
+unsigned long wa_tune_epochs;
+unsigned long ssd_write_blocks;
+unsigned long ssd_write_calls;
+unsigned long ssd_nand_write_bytes;
+unsigned long request_blocks;
+unsigned long io_requests;		// requests replayed since the counters were reset
 
-pthread_mutex_t free_ssd_mutex;
 pthread_mutex_t inner_ssd_hdr_mutex;
 pthread_mutex_t inner_ssd_hash_mutex;
+pthread_mutex_t ssd_buf_mutex;
 
 SSDBufferDesc	*ssd_buffer_descriptors;
 SSDBufferStrategyControl	*ssd_buffer_strategy_control;
 SSDBufferHashBucket	        *ssd_buffer_hashtable;
 
-SSDStrategyControl	*ssd_strategy_control;
-
-SSDDesc		*ssd_descriptors;
+SMRDrive	*smr_drives;
+ZoneDesc	*zone_descriptors;
+ZoneControl	*zone_control;
 //char		*ssd_blocks;
-SSDHashBucket	*ssd_hashtable;
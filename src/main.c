@@ -14,20 +14,36 @@
 #include "ssd-cache.h"
 #include "smr-simulator/smr-simulator.h"
 #include "trace2call.h"
+#include "checkpoint.h"
+#include "staging.h"
+#include "tracegen.h"
+#include "partition.h"
 
 int main()
 {
     char trace_file_path[]="../test-10-2.txt";
+    PartitionResult result;
 
+    if (TRACEGEN_REQUESTS > 0)
+        generateTrace(trace_file_path);
+    markStartup();
+    if (CACHE_PARTITIONS > 1) {
+        result = runPartitions(trace_file_path, ssd_device, smr_device, inner_ssd_device);
+        printf("partitions:%lu requests:%lu blocks:%lu hit_num:%lu band_rmws:%lu time(s):%.3f iops:%.1f\n",
+               CACHE_PARTITIONS, result.requests, result.request_blocks, result.hit_num, result.flush_bands,
+               result.replay_s, result.replay_s > 0 ? result.requests / result.replay_s : 0);
+        return 0;
+    }
 	initSSD();
     initSSDBuffer();
-    smr_fd = open(smr_device, O_RDWR|O_DIRECT);
+    openSMRDrives(smr_device, inner_ssd_device, O_RDWR|O_DIRECT);
     ssd_fd = open(ssd_device, O_RDWR);
-    inner_ssd_fd = open(inner_ssd_device, O_RDWR|O_DIRECT);
+    initCheckpoint();
     trace_to_iocall(trace_file_path);
-    close(smr_fd);
+    flushStagingBuffer();
+    checkpointSSDBuffer();
+    closeSMRDrives();
     close(ssd_fd);
-    close(inner_ssd_fd);
     
 	return 0;
 }
@@ -4,6 +4,4 @@
 extern char smr_device[100];
 extern char ssd_device[100];
 extern char inner_ssd_device[100];
-extern int 		    smr_fd;
 extern int 		    ssd_fd;
-extern int 		    inner_ssd_fd;
@@ -0,0 +1,174 @@
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "main.h"
+#include "destage.h"
+#include "checkpoint.h"
+#include "staging.h"
+#include "trace2call.h"
+#include "partition.h"
+
+static void	runPartition(long partition, char *trace_file_path, char *paths[3], int result_fd);
+static unsigned long shrinkToPartition(unsigned long nslots);
+
+/*
+ * With CACHE_PARTITIONS > 1 the ssd cache is split into that many
+ * independent partitions, one process each, pinned to one cpu. A partition
+ * owns the smr bands whose number is cache_partition modulo
+ * CACHE_PARTITIONS, so every band-granular strategy sees whole bands, and
+ * its own share of the cache: its own ssd device file (a contiguous slot
+ * range on a partitioned ssd), inner ssd and smr drives, and every
+ * descriptor array and hash table. Nothing is shared, so no cache line
+ * moves between cpus. The arrays come from allocSSDArray() and are first
+ * touched by the pinned process, which places them on its numa node.
+ *
+ * Every partition reads the whole trace and replays only the parts of the
+ * requests that fall into its bands.
+ */
+unsigned long
+accessPartitionExtent(off_t offset, unsigned long size, char *buffer, bool is_write)
+{
+	unsigned long	band_num, band_end, part, nblocks = 0;
+
+	while (size > 0) {
+		band_num = GetSMRBandNumFromSSD(offset);
+		band_end = GetSMRBandStartFromNum(band_num) + GetSMRActualBandSizeFromSSD(offset);
+		part = band_end > offset && band_end - offset < size ? band_end - offset : size;
+		if (band_num % CACHE_PARTITIONS == cache_partition) {
+			if (is_write)
+				write_extent(offset, part, buffer);
+			else
+				read_extent(offset, part, buffer);
+			nblocks += part / BLCKSZ;
+		}
+		offset += part;
+		buffer += part;
+		size -= part;
+	}
+	return nblocks;
+}
+
+/* the cache, the inner ssd and the watermarks are split evenly */
+static unsigned long
+shrinkToPartition(unsigned long nslots)
+{
+	return nslots / CACHE_PARTITIONS > 0 ? nslots / CACHE_PARTITIONS : 1;
+}
+
+/*
+ * fork one process per partition on the device files "<path>.p<partition>"
+ * and sum up their results; requests is the # of requests with blocks in
+ * any partition, counted once per partition they touch, and replay_s the
+ * wall time until the last partition is done
+ */
+PartitionResult
+runPartitions(char *trace_file_path, char *ssd_path, char *smr_path, char *inner_ssd_path)
+{
+	PartitionResult	total, result;
+	struct timespec	ts_begin, ts_end;
+	char	       *paths[3] = {ssd_path, smr_path, inner_ssd_path};
+	pid_t		pid;
+	long		partition;
+	int		result_fds[2], status;
+
+	if (pipe(result_fds) < 0) {
+		printf("[ERROR] runPartitions():-------pipe\n");
+		exit(-1);
+	}
+	fflush(stdout);
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	for (partition = 0; partition < CACHE_PARTITIONS; partition++) {
+		pid = fork();
+		if (pid < 0) {
+			printf("[ERROR] runPartitions():-------fork partition %ld\n", partition);
+			exit(-1);
+		}
+		if (pid == 0) {
+			close(result_fds[0]);
+			runPartition(partition, trace_file_path, paths, result_fds[1]);
+		}
+	}
+	close(result_fds[1]);
+	while (wait(&status) > 0)
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			printf("[ERROR] runPartitions():-------a partition failed, see %s.p*.log\n", ssd_path);
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+	memset(&total, 0, sizeof(total));
+	total.partition = CACHE_PARTITIONS;
+	while (read(result_fds[0], &result, sizeof(result)) == sizeof(result)) {
+		total.requests += result.requests;
+		total.request_blocks += result.request_blocks;
+		total.hit_num += result.hit_num;
+		total.flush_bands += result.flush_bands;
+	}
+	close(result_fds[0]);
+	total.replay_s = ts_end.tv_sec - ts_begin.tv_sec + (ts_end.tv_nsec - ts_begin.tv_nsec) / 1e9;
+	return total;
+}
+
+/* one partition, in a child process that never returns */
+static void
+runPartition(long partition, char *trace_file_path, char *paths[3], int result_fd)
+{
+	PartitionResult	result;
+	struct timespec	ts_begin, ts_end;
+	cpu_set_t	cpus;
+	char		path[4][1024];
+	int		i;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(partition % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0)
+		printf("[INFO] runPartition():-------partition %ld runs unpinned\n", partition);
+	cache_partition = partition;
+	NSSDBuffers = shrinkToPartition(NSSDBuffers);
+	NSSDBufTables = shrinkToPartition(NSSDBufTables);
+	NSSDs = shrinkToPartition(NSSDs);
+	NSSDTables = shrinkToPartition(NSSDTables);
+	NSSDLIMIT = shrinkToPartition(NSSDLIMIT);
+	NSSDCLEAN = shrinkToPartition(NSSDCLEAN);
+	DESTAGE_LOW_WATERMARK = shrinkToPartition(DESTAGE_LOW_WATERMARK);
+	DESTAGE_HIGH_WATERMARK = shrinkToPartition(DESTAGE_HIGH_WATERMARK);
+
+	for (i = 0; i < 3; i++)
+		snprintf(path[i], sizeof(path[i]), "%s.p%ld", paths[i], partition);
+	snprintf(path[3], sizeof(path[3]), "%s.p%ld.log", paths[0], partition);
+	if (freopen(path[3], "w", stdout) == NULL)
+		_exit(1);
+	ssd_fd = open(path[0], O_RDWR | O_CREAT, 0644);
+	if (ssd_fd < 0) {
+		printf("[ERROR] runPartition():-------open %s\n", path[0]);
+		_exit(1);
+	}
+	initSSD();
+	openSMRDrives(path[1], path[2], O_RDWR | O_CREAT);
+	initSSDBuffer();
+	initCheckpoint();
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	trace_to_iocall(trace_file_path);
+	flushStagingBuffer();
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	checkpointSSDBuffer();
+
+	memset(&result, 0, sizeof(result));
+	result.partition = partition;
+	result.requests = io_requests;
+	result.request_blocks = request_blocks;
+	result.hit_num = hit_num;
+	result.flush_bands = flush_bands;
+	result.replay_s = ts_end.tv_sec - ts_begin.tv_sec + (ts_end.tv_nsec - ts_begin.tv_nsec) / 1e9;
+	if (write(result_fd, &result, sizeof(result)) != sizeof(result))
+		_exit(1);
+	fflush(stdout);
+	_exit(0);
+}
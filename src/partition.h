@@ -0,0 +1,22 @@
+#ifndef SMR_SSD_CACHE_PARTITION_H
+#define SMR_SSD_CACHE_PARTITION_H
+
+#define DEBUG 0
+/* ---------------------------per-cpu cache partitions---------------------------- */
+
+typedef struct
+{
+	long		partition;
+	unsigned long	requests;			// requests with blocks in the partition
+	unsigned long	request_blocks;
+	unsigned long	hit_num;
+	unsigned long	flush_bands;
+	double		replay_s;			// trace_to_iocall() of the partition
+} PartitionResult;
+
+extern unsigned long CACHE_PARTITIONS;
+extern long cache_partition;
+
+extern unsigned long accessPartitionExtent(off_t offset, unsigned long size, char *buffer, bool is_write);
+extern PartitionResult runPartitions(char *trace_file_path, char *ssd_path, char *smr_path, char *inner_ssd_path);
+#endif
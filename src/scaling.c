@@ -0,0 +1,111 @@
+/*
+ * scaling.c -- replay one trace through 1, 2, 4, ... cache partitions (see
+ * partition.c) and print the throughput of each partition count, built by
+ * "make scaling":
+ *
+ *	smr-ssd-cache-scaling [-p partitions] [-c blocks] [-m block|band] [-d dir] trace
+ *
+ * -p is the most partitions tried, the number of cpus by default. -c sets
+ * NSSDBuffers, the cache size in blocks over all partitions; band mode gets
+ * as many BNDSZ buffers as fit in the same bytes. Partition p of a run
+ * leaves its simulator output in dir/scaling-ssd.p<p>.log, its device files
+ * are removed once the run is over. speedup is iops over the iops of one
+ * partition.
+ */
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "checkpoint.h"
+#include "trace2call.h"
+#include "partition.h"
+
+static char    *scaling_dir = ".";
+
+static void	removePartitionFiles(char *path[3]);
+
+int
+main(int argc, char **argv)
+{
+	PartitionResult	result;
+	long		max_partitions = sysconf(_SC_NPROCESSORS_ONLN), npartitions;
+	double		iops, base_iops = 0;
+	char		path[3][1024], *paths[3] = {path[0], path[1], path[2]};
+	char	       *trace_file_path;
+	int		opt;
+
+	while ((opt = getopt(argc, argv, "p:c:m:d:")) != -1) {
+		if (opt == 'p')
+			max_partitions = atol(optarg);
+		else if (opt == 'c')
+			NSSDBuffers = NSSDBufTables = atol(optarg);
+		else if (opt == 'm')
+			BandOrBlock = strcmp(optarg, "band") == 0;
+		else if (opt == 'd')
+			scaling_dir = optarg;
+		else {
+			printf("usage: %s [-p partitions] [-c blocks] [-m block|band] [-d dir] trace\n", argv[0]);
+			exit(1);
+		}
+	}
+	if (optind != argc - 1) {
+		printf("usage: %s [-p partitions] [-c blocks] [-m block|band] [-d dir] trace\n", argv[0]);
+		exit(1);
+	}
+	trace_file_path = argv[optind];
+	if (max_partitions < 1)
+		max_partitions = 1;
+	if (BandOrBlock == 1) {
+		NSSDBuffers = NSSDBuffers * BLCKSZ / BNDSZ;
+		if (NSSDBuffers < 1)
+			NSSDBuffers = 1;
+		NSSDBufTables = NSSDBuffers;
+	}
+	WARM_RESTART = 0;
+	RECORD_LATENCY = 0;
+	snprintf(path[0], sizeof(path[0]), "%s/scaling-ssd", scaling_dir);
+	snprintf(path[1], sizeof(path[1]), "%s/scaling-smr", scaling_dir);
+	snprintf(path[2], sizeof(path[2]), "%s/scaling-inner_ssd", scaling_dir);
+
+	printf("trace:%s mode:%s cache_blocks:%lu cpus:%ld\n", trace_file_path, BandOrBlock ? "band" : "block",
+	       NSSDBuffers, sysconf(_SC_NPROCESSORS_ONLN));
+	printf("partitions\trequests\thit_ratio\tband_rmws\ttime(s)\tiops\tspeedup\n");
+	for (npartitions = 1;; npartitions = npartitions * 2 < max_partitions ? npartitions * 2 : max_partitions) {
+		CACHE_PARTITIONS = npartitions;
+		result = runPartitions(trace_file_path, paths[0], paths[1], paths[2]);
+		removePartitionFiles(paths);
+		iops = result.replay_s > 0 ? result.requests / result.replay_s : 0;
+		if (npartitions == 1)
+			base_iops = iops;
+		printf("%ld\t%lu\t%.4f\t%lu\t%.3f\t%.1f\t%.2f\n", npartitions, result.requests,
+		       result.request_blocks ? (double) result.hit_num / result.request_blocks : 0, result.flush_bands,
+		       result.replay_s, iops, base_iops > 0 ? iops / base_iops : 0);
+		fflush(stdout);
+		if (npartitions == max_partitions)
+			break;
+	}
+	return 0;
+}
+
+/* the device files of every partition of the last run */
+static void
+removePartitionFiles(char *path[3])
+{
+	char		name[1100];
+	long		partition, drive, i;
+
+	for (partition = 0; partition < CACHE_PARTITIONS; partition++) {
+		for (i = 0; i < 3; i++) {
+			snprintf(name, sizeof(name), "%s.p%ld", path[i], partition);
+			unlink(name);
+		}
+		for (drive = 1; drive < NSMRDrives; drive++)
+			for (i = 1; i < 3; i++) {
+				snprintf(name, sizeof(name), "%s.p%ld.%ld", path[i], partition, drive);
+				unlink(name);
+			}
+	}
+}
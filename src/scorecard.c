@@ -0,0 +1,293 @@
+/*
+ * scorecard.c -- replay one trace through every strategy in block and in
+ * band mode and print one line of results per run, built by
+ * "make scorecard":
+ *
+ *	smr-ssd-cache-scorecard [-j jobs] [-w warmup%] [-c blocks] [-m block|band] [-p fifo|greedy|costbenefit] [-a all|ghost|tinylfu] [-n requests] [-s seed] [-d dir] trace
+ *
+ * Every run is a child process with its own ssd, smr and inner ssd files in
+ * dir and its simulator output in dir/scorecard-<strategy>-<mode>.log; at
+ * most jobs of them (the number of cpus by default) run at once. The first
+ * warmup% of the trace lines only warm the cache. With -n the trace is first
+ * generated by generateTrace() with the given seed. -c sets NSSDBuffers, the
+ * cache size in blocks; band mode gets as many BNDSZ buffers as fit in the
+ * same bytes. -m runs only one of the two modes: a band mode miss copies a
+ * whole BNDSZ band, so band mode is much slower on the same trace. -p picks
+ * the inner ssd cleaning policy; rmw_per_GB is band RMWs per GB written to
+ * the smr drive and clean_stalls the blocks that waited for the cleaner. -a
+ * picks the ssd cache admission policy; bypass(MB) is what it wrote around
+ * the cache.
+ *
+ * est_time(s) is a device model, not a measurement: SCORECARD_SSD_IO_US per
+ * ssd write call, inner ssd write and dirty block read back, the written
+ * bytes at SCORECARD_SSD_MB_PER_S, SCORECARD_SMR_SEEK_MS per smr seek and the
+ * bytes band read-modify-writes read and rewrite at SCORECARD_SMR_MB_PER_S.
+ * metadata(MB) is the growth of the resident set over the run.
+ * nand_write(MB) is the nand writes the cache ssd is estimated to make for
+ * the ssd writes (see countSSDNandWrite()) and lifetime(d) the days the cache
+ * ssd lasts writing them every est_time(s).
+ */
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "main.h"
+#include "destage.h"
+#include "checkpoint.h"
+#include "staging.h"
+#include "admission.h"
+#include "trace2call.h"
+#include "tracegen.h"
+
+#define SCORECARD_SSD_IO_US 20
+#define SCORECARD_SSD_MB_PER_S 500
+#define SCORECARD_SMR_SEEK_MS 8.5
+#define SCORECARD_SMR_MB_PER_S 150
+
+typedef struct
+{
+	long		run;
+	unsigned long	request_blocks;
+	unsigned long	hit_num;
+	unsigned long	ssd_write_blocks;
+	unsigned long	ssd_write_calls;
+	unsigned long	dirty_destages;		// synchronous flushes and destager write backs
+	unsigned long	flush_fifo_blocks;
+	unsigned long	flush_bands;
+	unsigned long	smr_seeks;
+	unsigned long	clean_stalls;
+	unsigned long	flush_band_bytes;	// read and rewritten by band flushes
+	unsigned long	metadata_bytes;
+	unsigned long	bypassed_blocks;	// write misses the admission policy sent to smr
+	unsigned long	nand_write_bytes;
+	double		lifetime_days;
+} ScorecardResult;
+
+static SSDEvictionStrategy strategies[] = {CLOCK, LRU, LRUofBand, Most, SCAN, WA, Most_Bucket, ARC, TwoQ, CostBenefit};
+static char    *strategy_names[] = {"CLOCK", "LRU", "LRUofBand", "Most", "SCAN", "WA", "Most_Bucket", "ARC", "TwoQ", "CostBenefit"};
+#define NSTRATEGIES (sizeof(strategies) / sizeof(strategies[0]))
+#define NRUNS (NSTRATEGIES * 2)
+
+static char    *scorecard_dir = ".";
+static long	scorecard_mode = -1;		// 0 block, 1 band, -1 both
+
+static unsigned long countTraceLines(char *trace_file_path);
+static unsigned long residentBytes();
+static void	runScorecard(long run, char *trace_file_path, int result_fd);
+static double	estimateServiceTime(ScorecardResult * result);
+
+int
+main(int argc, char **argv)
+{
+	ScorecardResult	results[NRUNS], result;
+	pid_t		pids[NRUNS], pid;
+	bool		done[NRUNS];
+	long		jobs = sysconf(_SC_NPROCESSORS_ONLN), warmup_percent = 10;
+	long		run, next = 0, running = 0;
+	int		result_fds[2], status, opt;
+	char	       *trace_file_path;
+
+	while ((opt = getopt(argc, argv, "j:w:c:m:p:a:n:s:d:")) != -1) {
+		if (opt == 'j')
+			jobs = atol(optarg);
+		else if (opt == 'w')
+			warmup_percent = atol(optarg);
+		else if (opt == 'c')
+			NSSDBuffers = NSSDBufTables = atol(optarg);
+		else if (opt == 'm')
+			scorecard_mode = strcmp(optarg, "band") == 0;
+		else if (opt == 'p')
+			CleanPolicy = strcmp(optarg, "greedy") == 0 ? CleanGreedy : strcmp(optarg, "costbenefit") == 0 ? CleanCostBenefit : CleanFIFO;
+		else if (opt == 'a')
+			AdmissionPolicy = strcmp(optarg, "ghost") == 0 ? AdmitGhost : strcmp(optarg, "tinylfu") == 0 ? AdmitTinyLFU : AdmitAll;
+		else if (opt == 'n')
+			TRACEGEN_REQUESTS = atol(optarg);
+		else if (opt == 's')
+			TRACEGEN_SEED = atol(optarg);
+		else if (opt == 'd')
+			scorecard_dir = optarg;
+		else {
+			printf("usage: %s [-j jobs] [-w warmup%%] [-c blocks] [-m block|band] [-p fifo|greedy|costbenefit] [-a all|ghost|tinylfu] [-n requests] [-s seed] [-d dir] trace\n", argv[0]);
+			exit(1);
+		}
+	}
+	if (optind != argc - 1) {
+		printf("usage: %s [-j jobs] [-w warmup%%] [-c blocks] [-m block|band] [-p fifo|greedy|costbenefit] [-a all|ghost|tinylfu] [-n requests] [-s seed] [-d dir] trace\n", argv[0]);
+		exit(1);
+	}
+	trace_file_path = argv[optind];
+	if (TRACEGEN_REQUESTS > 0)
+		generateTrace(trace_file_path);
+	WARMUP_REQUESTS = countTraceLines(trace_file_path) * warmup_percent / 100;
+	if (jobs < 1)
+		jobs = 1;
+
+	if (pipe(result_fds) < 0) {
+		printf("[ERROR] scorecard():-------pipe\n");
+		exit(-1);
+	}
+	memset(done, 0, sizeof(done));
+	memset(pids, 0, sizeof(pids));
+	while (next < NRUNS || running > 0) {
+		if (next < NRUNS && scorecard_mode >= 0 && next % 2 != scorecard_mode) {
+			next++;
+			continue;
+		}
+		if (next < NRUNS && running < jobs) {
+			fflush(stdout);
+			pid = fork();
+			if (pid < 0) {
+				printf("[ERROR] scorecard():-------fork run %ld\n", next);
+				exit(-1);
+			}
+			if (pid == 0) {
+				close(result_fds[0]);
+				runScorecard(next, trace_file_path, result_fds[1]);
+			}
+			pids[next++] = pid;
+			running++;
+			continue;
+		}
+		pid = wait(&status);
+		running--;
+		for (run = 0; run < next; run++)
+			if (pids[run] == pid && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+				printf("[ERROR] scorecard():-------%s %s failed, see its log\n", strategy_names[run / 2], run % 2 ? "band" : "block");
+	}
+	close(result_fds[1]);
+	while (read(result_fds[0], &result, sizeof(result)) == sizeof(result)) {
+		results[result.run] = result;
+		done[result.run] = 1;
+	}
+
+	printf("trace:%s warmup_lines:%lu clean_policy:%s admission:%s ssd_io(us):%d ssd(MB/s):%d smr_seek(ms):%.1f smr(MB/s):%d\n",
+	       trace_file_path, WARMUP_REQUESTS, clean_policy_names[CleanPolicy], admission_policy_names[AdmissionPolicy], SCORECARD_SSD_IO_US, SCORECARD_SSD_MB_PER_S, SCORECARD_SMR_SEEK_MS, SCORECARD_SMR_MB_PER_S);
+	printf("strategy\tmode\thit_ratio\tssd_write(MB)\tdirty_destages\tfifo_blocks\tband_rmws\trmw_per_GB\tclean_stalls\tsmr_seeks\test_time(s)\tmetadata(MB)\tbypass(MB)\tnand_write(MB)\tlifetime(d)\n");
+	for (run = 0; run < NRUNS; run++) {
+		if (!done[run])
+			continue;
+		printf("%s\t%s\t%.4f\t%.1f\t%lu\t%lu\t%lu\t%.2f\t%lu\t%lu\t%.2f\t%.1f\t%.1f\t%.1f\t%.2f\n",
+		       strategy_names[run / 2], run % 2 ? "band" : "block",
+		       results[run].request_blocks ? (double) results[run].hit_num / results[run].request_blocks : 0,
+		       results[run].ssd_write_blocks * (double) BLCKSZ / 1024 / 1024,
+		       results[run].dirty_destages, results[run].flush_fifo_blocks, results[run].flush_bands,
+		       results[run].flush_fifo_blocks ? results[run].flush_bands / (results[run].flush_fifo_blocks * (double) BLCKSZ / 1024 / 1024 / 1024) : 0,
+		       results[run].clean_stalls, results[run].smr_seeks,
+		       estimateServiceTime(&results[run]), results[run].metadata_bytes / 1024.0 / 1024.0,
+		       results[run].bypassed_blocks * (double) BLCKSZ / 1024 / 1024, results[run].nand_write_bytes / 1024.0 / 1024.0,
+		       results[run].lifetime_days);
+	}
+	return 0;
+}
+
+static unsigned long
+countTraceLines(char *trace_file_path)
+{
+	FILE	       *trace;
+	unsigned long	nlines = 0;
+	int		c;
+
+	if ((trace = fopen(trace_file_path, "r")) == NULL) {
+		printf("[ERROR] countTraceLines():-------open %s\n", trace_file_path);
+		exit(-1);
+	}
+	while ((c = getc_unlocked(trace)) != EOF)
+		if (c == '\n')
+			nlines++;
+	fclose(trace);
+	return nlines;
+}
+
+static unsigned long
+residentBytes()
+{
+	FILE	       *statm = fopen("/proc/self/statm", "r");
+	unsigned long	size = 0, resident = 0;
+
+	if (statm == NULL)
+		return 0;
+	if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+		resident = 0;
+	fclose(statm);
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* one strategy in one mode, in a child process that never returns */
+static void
+runScorecard(long run, char *trace_file_path, int result_fd)
+{
+	ScorecardResult	result;
+	char		path[4][1024];
+	unsigned long	rss_begin;
+	int		i;
+
+	EvictStrategy = strategies[run / 2];
+	BandOrBlock = run % 2;
+	for (i = 0; i < 4; i++)
+		snprintf(path[i], sizeof(path[i]), "%s/scorecard-%s-%s.%s", scorecard_dir, strategy_names[run / 2],
+			 BandOrBlock ? "band" : "block", i == 0 ? "log" : i == 1 ? "ssd" : i == 2 ? "smr" : "inner_ssd");
+	if (freopen(path[0], "w", stdout) == NULL)
+		_exit(1);
+	if (BandOrBlock == 1) {
+		NSSDBuffers = NSSDBuffers * BLCKSZ / BNDSZ;
+		if (NSSDBuffers < 1)
+			NSSDBuffers = 1;
+		NSSDBufTables = NSSDBuffers;
+	}
+	WARM_RESTART = 0;
+	RECORD_LATENCY = 0;
+
+	rss_begin = residentBytes();
+	ssd_fd = open(path[1], O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (ssd_fd < 0) {
+		printf("[ERROR] runScorecard():-------open device files %s.*\n", path[1]);
+		_exit(1);
+	}
+	initSSD();
+	openSMRDrives(path[2], path[3], O_RDWR | O_CREAT | O_TRUNC);
+	initSSDBuffer();
+	trace_to_iocall(trace_file_path);
+	flushStagingBuffer();
+	collectSMRDriveStats();
+
+	memset(&result, 0, sizeof(result));
+	result.run = run;
+	result.request_blocks = request_blocks;
+	result.hit_num = hit_num;
+	result.ssd_write_blocks = ssd_write_blocks;
+	result.ssd_write_calls = ssd_write_calls;
+	result.dirty_destages = sync_flush_blocks + destage_blocks;
+	result.flush_fifo_blocks = flush_fifo_blocks;
+	result.flush_bands = flush_bands;
+	result.smr_seeks = smr_seeks;
+	result.clean_stalls = clean_stalls;
+	result.flush_band_bytes = flush_band_read_bytes + flush_band_write_bytes;
+	result.metadata_bytes = residentBytes() - rss_begin;
+	result.bypassed_blocks = bypassed_blocks;
+	result.nand_write_bytes = ssd_nand_write_bytes;
+	result.lifetime_days = projectSSDLifetime(ssd_nand_write_bytes, estimateServiceTime(&result));
+	if (write(result_fd, &result, sizeof(result)) != sizeof(result))
+		_exit(1);
+
+	for (i = 1; i < 4; i++)
+		unlink(path[i]);
+	fflush(stdout);
+	_exit(0);
+}
+
+static double
+estimateServiceTime(ScorecardResult * result)
+{
+	double		ssd_ios = result->ssd_write_calls + result->flush_fifo_blocks + result->dirty_destages;
+	double		ssd_bytes = result->ssd_write_blocks * (double) BLCKSZ;
+	double		smr_bytes = result->flush_band_bytes;
+
+	return ssd_ios * SCORECARD_SSD_IO_US / 1e6 + ssd_bytes / (SCORECARD_SSD_MB_PER_S * 1024.0 * 1024.0) +
+		result->smr_seeks * SCORECARD_SMR_SEEK_MS / 1e3 + smr_bytes / (SCORECARD_SMR_MB_PER_S * 1024.0 * 1024.0);
+}
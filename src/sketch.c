@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "sketch.h"
+
+static const unsigned long sketch_seeds[SKETCH_DEPTH] = {
+	0x9E3779B97F4A7C15UL, 0xC2B2AE3D27D4EB4FUL, 0x165667B19E3779F9UL, 0xD6E8FEB86659FD93UL
+};
+
+static void	halveSketch(CountMinSketch * sketch);
+
+/*
+ * A count-min sketch: SKETCH_DEPTH rows of saturating counters, each row
+ * indexed by its own multiplicative hash of the key. A key's estimate is its
+ * smallest counter, which never undercounts. Every sample additions all
+ * counters are halved, so old counts decay exponentially and the memory
+ * stays SKETCH_DEPTH * width bytes however many keys are counted. Used by
+ * the TinyLFU admission policy and by band_hotness.c.
+ */
+void
+initSketch(CountMinSketch * sketch, unsigned long min_width, unsigned char max_count, unsigned long sample)
+{
+	for (sketch->width = 1, sketch->shift = 64; sketch->width < min_width; sketch->width *= 2, sketch->shift--);
+	sketch->counters = (unsigned char *) allocSSDArray(SKETCH_DEPTH * sketch->width, sizeof(unsigned char));
+	sketch->max_count = max_count;
+	sketch->additions = 0;
+	sketch->sample = sample > 0 ? sample : 10 * sketch->width;
+	sketch->halvings = 0;
+}
+
+/* count key count times more and return its estimate */
+unsigned long
+incrementSketch(CountMinSketch * sketch, unsigned long key, unsigned long count)
+{
+	unsigned long	frequency = sketch->max_count, i;
+	unsigned char  *counter;
+
+	for (i = 0; i < SKETCH_DEPTH; i++) {
+		counter = &sketch->counters[i * sketch->width + (sketch->shift < 64 ? (key * sketch_seeds[i]) >> sketch->shift : 0)];
+		*counter = *counter + count < sketch->max_count ? *counter + count : sketch->max_count;
+		if (*counter < frequency)
+			frequency = *counter;
+	}
+	sketch->additions += count;
+	if (sketch->additions >= sketch->sample)
+		halveSketch(sketch);
+	return frequency;
+}
+
+unsigned long
+estimateSketch(CountMinSketch * sketch, unsigned long key)
+{
+	unsigned long	frequency = sketch->max_count, i;
+	unsigned char	counter;
+
+	for (i = 0; i < SKETCH_DEPTH; i++) {
+		counter = sketch->counters[i * sketch->width + (sketch->shift < 64 ? (key * sketch_seeds[i]) >> sketch->shift : 0)];
+		if (counter < frequency)
+			frequency = counter;
+	}
+	return frequency;
+}
+
+static void
+halveSketch(CountMinSketch * sketch)
+{
+	unsigned long	i;
+
+	for (i = 0; i < SKETCH_DEPTH * sketch->width; i++)
+		sketch->counters[i] >>= 1;
+	sketch->additions = 0;
+	sketch->halvings++;
+}
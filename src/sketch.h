@@ -0,0 +1,23 @@
+#ifndef SMR_SSD_CACHE_SKETCH_H
+#define SMR_SSD_CACHE_SKETCH_H
+
+#define DEBUG 0
+/* ---------------------------count-min sketch---------------------------- */
+
+#define SKETCH_DEPTH 4
+
+typedef struct
+{
+	unsigned char  *counters;		// SKETCH_DEPTH rows of width counters
+	unsigned long	width;			// a power of two
+	int		shift;			// 64 - log2(width), to index a row by the top hash bits
+	unsigned char	max_count;		// counters saturate here
+	unsigned long	additions;		// counted since the counters were last halved
+	unsigned long	sample;			// additions between two halvings
+	unsigned long	halvings;
+} CountMinSketch;
+
+extern void initSketch(CountMinSketch * sketch, unsigned long min_width, unsigned char max_count, unsigned long sample);
+extern unsigned long incrementSketch(CountMinSketch * sketch, unsigned long key, unsigned long count);
+extern unsigned long estimateSketch(CountMinSketch * sketch, unsigned long key);
+#endif
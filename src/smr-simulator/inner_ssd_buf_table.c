@@ -6,16 +6,10 @@
 
 static bool isSamessd(SSDTag *, SSDTag *);
 
-void initSSDTable(size_t size)
+/* bucket heads only link the entries, an all-zero table is empty; one table per smr drive */
+SSDHashBucket *initSSDTable(size_t size)
 {
-	ssd_hashtable = (SSDHashBucket *)malloc(sizeof(SSDHashBucket)*size);
-	size_t i;
-	SSDHashBucket *ssd_hash = ssd_hashtable;
-	for (i = 0; i < size; ssd_hash++, i++){
-		ssd_hash->ssd_id = -1;
-		ssd_hash->hash_key.offset = -1;
-		ssd_hash->next_item = NULL;
-	}
+	return (SSDHashBucket *)allocSSDArray(size, sizeof(SSDHashBucket));
 }
 
 unsigned long ssdtableHashcode(SSDTag *ssd_tag)
@@ -24,11 +18,11 @@ unsigned long ssdtableHashcode(SSDTag *ssd_tag)
 	return ssd_hash;
 }
 
-long ssdtableLookup(SSDTag *ssd_tag, unsigned long hash_code)
+long ssdtableLookup(SSDTag *ssd_tag, unsigned long hash_code, SSDHashBucket *ssd_hashtable)
 {
 	if (DEBUG)
 		printf("[INFO] Lookup ssd_tag: %lu\n",ssd_tag->offset);
-	SSDHashBucket *nowbucket = GetSSDHashBucket(hash_code);
+	SSDHashBucket *nowbucket = GetSSDHashBucket(ssd_hashtable, hash_code)->next_item;
 	while (nowbucket != NULL) {
 	//	printf("nowbucket->buf_id = %u %u %u\n", nowbucket->hash_key.rel.database, nowbucket->hash_key.rel.relation, nowbucket->hash_key.block_num);
 		if (isSamessd(&nowbucket->hash_key, ssd_tag)) {
@@ -42,14 +36,14 @@ long ssdtableLookup(SSDTag *ssd_tag, unsigned long hash_code)
 	return -1;
 }
 
-long ssdtableInsert(SSDTag *ssd_tag, unsigned long hash_code, long ssd_id)
+long ssdtableInsert(SSDTag *ssd_tag, unsigned long hash_code, long ssd_id, SSDHashBucket *ssd_hashtable)
 {
 	if (DEBUG)
 		printf("[INFO] Insert ssd_tag: %lu, hash_code=%lu\n",ssd_tag->offset, hash_code);
-	SSDHashBucket *nowbucket = GetSSDHashBucket(hash_code);
-	while (nowbucket->next_item != NULL && nowbucket != NULL) {
-		if (isSamessd(&nowbucket->hash_key, ssd_tag)) {
-			return nowbucket->ssd_id;
+	SSDHashBucket *nowbucket = GetSSDHashBucket(ssd_hashtable, hash_code);
+	while (nowbucket->next_item != NULL) {
+		if (isSamessd(&nowbucket->next_item->hash_key, ssd_tag)) {
+			return nowbucket->next_item->ssd_id;
 		}
 		nowbucket = nowbucket->next_item;
 	}
@@ -69,14 +63,13 @@ long ssdtableInsert(SSDTag *ssd_tag, unsigned long hash_code, long ssd_id)
 	return -1;
 }
 
-long ssdtableDelete(SSDTag *ssd_tag, unsigned long hash_code)
+long ssdtableDelete(SSDTag *ssd_tag, unsigned long hash_code, SSDHashBucket *ssd_hashtable)
 {
 	if (DEBUG)
 		printf("[INFO] Delete ssd_tag: %lu, hash_code=%lu\n",ssd_tag->offset, hash_code);
-	SSDHashBucket *nowbucket = GetSSDHashBucket(hash_code);
-	long del_id;
+	SSDHashBucket *nowbucket = GetSSDHashBucket(ssd_hashtable, hash_code);
+	long del_id = -1;
 	SSDHashBucket *delitem;
-	nowbucket->next_item;
 	while (nowbucket->next_item != NULL && nowbucket != NULL) {
 		if (isSamessd(&nowbucket->next_item->hash_key, ssd_tag)) {
 			del_id = nowbucket->next_item->ssd_id;
@@ -84,10 +77,6 @@ long ssdtableDelete(SSDTag *ssd_tag, unsigned long hash_code)
 		}
 		nowbucket = nowbucket->next_item;
 	}
-	//printf("not found2\n");
-	if (isSamessd(&nowbucket->hash_key, ssd_tag)) {
-		del_id = nowbucket->ssd_id;
-	}
 	//printf("not found3\n");
 	if (nowbucket->next_item != NULL) {
 		delitem = nowbucket->next_item;
@@ -1,9 +1,9 @@
-#ifndef SSDBUFTABLE_H
-#define SSDBUFTABLE_H
+#ifndef INNER_SSDBUFTABLE_H
+#define INNER_SSDBUFTABLE_H
 
-extern void initSSDTable(int size);
-extern unsigned ssdtableHashcode(SSDTag *ssd_tag);
-extern int ssdtableLookup(SSDTag *ssd_tag, unsigned hash_code);
-extern int ssdtableInsert(SSDTag *ssd_tag, unsigned hash_code, int ssd_id);
-extern int ssdtableDelete(SSDTag *ssd_tag, unsigned hash_code);
-#endif   /* SSDBUFTABLE_H */
+extern SSDHashBucket *initSSDTable(size_t size);
+extern unsigned long ssdtableHashcode(SSDTag *ssd_tag);
+extern long ssdtableLookup(SSDTag *ssd_tag, unsigned long hash_code, SSDHashBucket *ssd_hashtable);
+extern long ssdtableInsert(SSDTag *ssd_tag, unsigned long hash_code, long ssd_id, SSDHashBucket *ssd_hashtable);
+extern long ssdtableDelete(SSDTag *ssd_tag, unsigned long hash_code, SSDHashBucket *ssd_hashtable);
+#endif   /* INNER_SSDBUFTABLE_H */
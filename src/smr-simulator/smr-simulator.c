@@ -3,98 +3,275 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <memory.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 
 #include "ssd-cache.h"
 #include "smr-simulator.h"
 #include "inner_ssd_buf_table.h"
+#include "zoned.h"
 
-static SSDDesc *getStrategySSD();
-static void    *freeStrategySSD();
-static volatile void *flushSSD(SSDDesc * ssd_hdr);
+static SSDDesc *getStrategySSD(SMRDrive * drive, SSDTag ssd_tag);
+static void    *freeStrategySSD(void *arg);
+static volatile void *flushSSD(SMRDrive * drive, long band_num);
+static void	addToSSDBand(SMRDrive * drive, SSDDesc * ssd_hdr);
+static double	cleanScore(SMRDrive * drive, long band_num);
+static int	compareCandidateByScore(const void *a, const void *b);
+static int	compareCandidateByBand(const void *a, const void *b);
+static int	compareLong(const void *a, const void *b);
+static long	elevatorStart(SSDCleanCandidate * window, long n, off_t head);
+static unsigned long countDriveBands(unsigned long band_num, long drive_num);
+static void	checkpointSSDDrive(SMRDrive * drive);
+static long	restoreSSDDrive(SMRDrive * drive);
 
 /*
- * init inner ssd buffer hash table, strategy_control, buffer, work_mem
+ * init the NSMRDrives drives of the smr array: inner ssd buffer hash table,
+ * strategy_control and work_mem of each, and one cleaner thread per drive
  */
 void 
 initSSD()
 {
 	pthread_t	freessd_tid;
+	SMRDrive       *drive;
+	long		d;
 	int		err;
 
-	initSSDTable(NSSDTables);
+	if (NSMRDrives < 1)
+		NSMRDrives = 1;
+	/* the write pointers are kept for one drive */
+	if (ZONED_SMR && NSMRDrives > 1) {
+		printf("[ERROR] initSSD():-------zoned smr takes one drive, not %lu\n", NSMRDrives);
+		exit(-1);
+	}
+	smr_drives = (SMRDrive *) allocSSDArray(NSMRDrives, sizeof(SMRDrive));
+	for (d = 0; d < NSMRDrives; d++) {
+		drive = &smr_drives[d];
+		drive->drive_num = d;
+		drive->smr_fd = -1;
+		drive->inner_ssd_fd = -1;
+		drive->ssd_hashtable = initSSDTable(NSSDTables);
 
-	ssd_strategy_control = (SSDStrategyControl *) malloc(sizeof(SSDStrategyControl));
-	ssd_strategy_control->first_usedssd = 0;
-	ssd_strategy_control->last_usedssd = -1;
-	ssd_strategy_control->n_usedssd = 0;
+		drive->ssd_strategy_control = (SSDStrategyControl *) malloc(sizeof(SSDStrategyControl));
+		drive->ssd_strategy_control->n_usedssd = 0;
+		drive->ssd_strategy_control->first_freessd = -1;
+		drive->ssd_strategy_control->n_initssd = 0;
+		drive->ssd_strategy_control->first_band = -1;
+		drive->ssd_strategy_control->last_band = -1;
+		drive->ssd_strategy_control->nbands = 0;
+		drive->ssd_strategy_control->write_clock = 0;
 
-	ssd_descriptors = (SSDDesc *) malloc(sizeof(SSDDesc) * NSSDs);
-	SSDDesc        *ssd_hdr;
-	long		i;
-	ssd_hdr = ssd_descriptors;
-	for (i = 0; i < NSSDs; ssd_hdr++, i++) {
-		ssd_hdr->ssd_flag = 0;
-		ssd_hdr->ssd_id = i;
-		//ssd_hdr->usage_count = 0;
-		//ssd_hdr->next_freessd = i + 1;
+		/* zero is a free slot, ssd_id is set when getStrategySSD() hands the slot out */
+		drive->ssd_descriptors = (SSDDesc *) allocSSDArray(NSSDs, sizeof(SSDDesc));
+		drive->ssd_band_descriptors = (SSDBandDesc *) allocSSDArray(NSMRBands, sizeof(SSDBandDesc));
+		drive->clean_window = (SSDCleanCandidate *) malloc(sizeof(SSDCleanCandidate) * NSSDs);
+		drive->interval_time = 0;
+		drive->smr_head_offset = 0;
+		drive->last_band = -1;
+
+		pthread_mutex_init(&drive->free_ssd_mutex, NULL);
+		pthread_mutex_init(&drive->smrwrite_mutex, NULL);
 	}
-	//ssd_descriptors[NSSDs - 1].next_freessd = -1;
-	interval_time = 0;
+	resetSMRDriveStats();
+	if (ZONED_SMR)
+		initZones();
+
+	for (d = 0; d < NSMRDrives; d++) {
+		err = pthread_create(&freessd_tid, NULL, freeStrategySSD, &smr_drives[d]);
+		if (err != 0) {
+			printf("[ERROR] initSSD: fail to create thread: %s\n", strerror(err));
+		}
+	}
+}
+
+/*
+ * drive 0 is smr_path and inner_ssd_path, drive d the same with ".d"
+ * appended, so a single drive opens the files it always did
+ */
+void
+openSMRDrives(char *smr_path, char *inner_ssd_path, int flags)
+{
+	char		path[2][256];
+	long		d;
 
-	//ssd_blocks = (char *)malloc(SSD_SIZE * NSSDs);
-	//printf("%d\n", sizeof(ssd_blocks));
-	//memset(ssd_blocks, 0, SSD_SIZE * NSSDs);
+	for (d = 0; d < NSMRDrives; d++) {
+		snprintf(path[0], sizeof(path[0]), d > 0 ? "%s.%ld" : "%s", smr_path, d);
+		snprintf(path[1], sizeof(path[1]), d > 0 ? "%s.%ld" : "%s", inner_ssd_path, d);
+		smr_drives[d].smr_fd = open(path[0], flags, 0644);
+		smr_drives[d].inner_ssd_fd = open(path[1], flags, 0644);
+		if (smr_drives[d].smr_fd < 0 || smr_drives[d].inner_ssd_fd < 0) {
+			printf("[ERROR] openSMRDrives():-------open drive %ld: %s %s\n", d, path[0], path[1]);
+			exit(-1);
+		}
+	}
+}
 
-	pthread_mutex_init(&free_ssd_mutex, NULL);
-	//pthread_mutex_init(&inner_ssd_hdr_mutex, NULL);
-	//pthread_mutex_init(&inner_ssd_table_mutex, NULL);
+void
+closeSMRDrives()
+{
+	long		d;
 
-	err = pthread_create(&freessd_tid, NULL, freeStrategySSD, NULL);
-	if (err != 0) {
-		printf("[ERROR] initSSD: fail to create thread: %s\n", strerror(err));
+	for (d = 0; d < NSMRDrives; d++) {
+		close(smr_drives[d].smr_fd);
+		close(smr_drives[d].inner_ssd_fd);
 	}
+}
+
+/* the array wide counters are the sums over the drives, brought up to date here */
+void
+collectSMRDriveStats()
+{
+	SMRDriveStats  *stats;
+	long		d;
+
 	flush_bands = 0;
 	flush_fifo_blocks = 0;
+	smr_seeks = 0;
+	smr_seek_distance = 0;
+	smrwrite_band_switches = 0;
+	flush_band_blocks = 0;
+	flush_band_syscalls = 0;
+	flush_band_read_bytes = 0;
+	flush_band_write_bytes = 0;
+	clean_stalls = 0;
+	for (d = 0; d < NSMRDrives; d++) {
+		stats = &smr_drives[d].stats;
+		flush_bands += stats->flush_bands;
+		flush_fifo_blocks += stats->flush_fifo_blocks;
+		smr_seeks += stats->smr_seeks;
+		smr_seek_distance += stats->smr_seek_distance;
+		smrwrite_band_switches += stats->smrwrite_band_switches;
+		flush_band_blocks += stats->flush_band_blocks;
+		flush_band_syscalls += stats->flush_band_syscalls;
+		flush_band_read_bytes += stats->flush_band_read_bytes;
+		flush_band_write_bytes += stats->flush_band_write_bytes;
+		clean_stalls += stats->clean_stalls;
+	}
+}
+
+void
+resetSMRDriveStats()
+{
+	long		d;
+
+	for (d = 0; d < NSMRDrives; d++)
+		memset(&smr_drives[d].stats, 0, sizeof(SMRDriveStats));
+	collectSMRDriveStats();
+}
+
+/*
+ * head movement of the smr disk of drive, counted on every access that does
+ * not start where the previous one ended; offset is on the drive
+ */
+void
+trackSMRSeek(SMRDrive * drive, off_t offset, size_t size)
+{
+	if (offset != drive->smr_head_offset) {
+		drive->stats.smr_seeks++;
+		drive->stats.smr_seek_distance += offset > drive->smr_head_offset ? offset - drive->smr_head_offset : drive->smr_head_offset - offset;
+	}
+	drive->smr_head_offset = offset + size;
 }
 
+/* the higher score is cleaned first */
+static int
+compareCandidateByScore(const void *a, const void *b)
+{
+	double		x = ((const SSDCleanCandidate *) a)->score;
+	double		y = ((const SSDCleanCandidate *) b)->score;
+
+	return x > y ? -1 : x < y;
+}
+
+static int
+compareCandidateByBand(const void *a, const void *b)
+{
+	long		x = ((const SSDCleanCandidate *) a)->band_num;
+	long		y = ((const SSDCleanCandidate *) b)->band_num;
+
+	return x < y ? -1 : x > y;
+}
+
+static int
+compareLong(const void *a, const void *b)
+{
+	long		x = *(const long *) a;
+	long		y = *(const long *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* first entry of the window sorted by band at or after head, where a one-way sweep starts */
+static long
+elevatorStart(SSDCleanCandidate * window, long n, off_t head)
+{
+	long		low = 0, high = n;
+	long		mid;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (GetSMRDriveBandStartFromNum(window[mid].band_num) < head)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low < n ? low : 0;
+}
+
+/*
+ * Each block goes to the inner ssd or the smr disk of its own drive, under
+ * that drive's free_ssd_mutex so the cleaner cannot move it in between.
+ */
 int 
-smrread(int smr_fd, char *buffer, size_t size, off_t offset)
+smrread(char *buffer, size_t size, off_t offset)
 {
+	SMRDrive       *drive;
 	SSDTag		ssd_tag;
-	SSDDesc        *ssd_hdr;
 	long		i;
 	int		returnCode;
 	long		ssd_hash;
 	long		ssd_id;
+	off_t		smr_offset;
 
+	/* a host-managed drive has no inner ssd */
+	if (ZONED_SMR)
+		return zoneread(smr_drives[0].smr_fd, buffer, size, offset);
 	for (i = 0; i * BLCKSZ < size; i++) {
+		drive = &smr_drives[GetSMRDriveNumFromSSD(offset + i * BLCKSZ)];
 		ssd_tag.offset = offset + i * BLCKSZ;
 		ssd_hash = ssdtableHashcode(&ssd_tag);
-		ssd_id = ssdtableLookup(&ssd_tag, ssd_hash);
+		pthread_mutex_lock(&drive->free_ssd_mutex);
+		ssd_id = ssdtableLookup(&ssd_tag, ssd_hash, drive->ssd_hashtable);
 
 		if (ssd_id >= 0) {
-			ssd_hdr = &ssd_descriptors[ssd_id];
-			returnCode = pread(inner_ssd_fd, buffer, BLCKSZ, ssd_hdr->ssd_id * BLCKSZ);
+			returnCode = pread(drive->inner_ssd_fd, buffer + i * BLCKSZ, BLCKSZ, ssd_id * BLCKSZ);
 			if (returnCode < 0) {
-				printf("[ERROR] smrread():-------read from inner ssd: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, ssd_hdr->ssd_id * BLCKSZ);
+				printf("[ERROR] smrread():-------read from inner ssd: fd=%d, errorcode=%d, offset=%lu\n", drive->inner_ssd_fd, returnCode, ssd_id * BLCKSZ);
 				exit(-1);
 			}
-			return returnCode;
 		} else {
-			returnCode = pread(smr_fd, buffer, BLCKSZ, offset + i * BLCKSZ);
+			smr_offset = GetSMRDriveOffsetFromSSD(offset + i * BLCKSZ);
+			trackSMRSeek(drive, smr_offset, BLCKSZ);
+			returnCode = pread(drive->smr_fd, buffer + i * BLCKSZ, BLCKSZ, smr_offset);
 			if (returnCode < 0) {
-				printf("[ERROR] smrread():-------read from smr disk: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, offset + i * BLCKSZ);
+				printf("[ERROR] smrread():-------read from smr disk: fd=%d, errorcode=%d, offset=%lu\n", drive->smr_fd, returnCode, smr_offset);
 				exit(-1);
 			}
 		}
+		pthread_mutex_unlock(&drive->free_ssd_mutex);
 	}
 
 	return 0;
 }
 
+/*
+ * the smrwrite_mutex of the drive of offset is held by the caller; a write
+ * that crosses into a band of another drive takes that drive's
+ * free_ssd_mutex for its blocks
+ */
 int 
-smrwrite(int smr_fd, char *buffer, size_t size, off_t offset)
+smrwrite(char *buffer, size_t size, off_t offset)
 {
+	SMRDrive       *drive = &smr_drives[GetSMRDriveNumFromSSD(offset)];
 	SSDTag		ssd_tag;
 	SSDDesc        *ssd_hdr;
 	long		i;
@@ -102,136 +279,407 @@ smrwrite(int smr_fd, char *buffer, size_t size, off_t offset)
 	long		ssd_hash;
 	long		ssd_id;
 
+	if (GetSMRBandNumFromSSD(offset) != drive->last_band) {
+		drive->stats.smrwrite_band_switches++;
+		drive->last_band = GetSMRBandNumFromSSD(offset);
+	}
 	for (i = 0; i * BLCKSZ < size; i++) {
+		drive = &smr_drives[GetSMRDriveNumFromSSD(offset + i * BLCKSZ)];
 		ssd_tag.offset = offset + i * BLCKSZ;
 		ssd_hash = ssdtableHashcode(&ssd_tag);
-		ssd_id = ssdtableLookup(&ssd_tag, ssd_hash);
+		//allocatelock
+			pthread_mutex_lock(&drive->free_ssd_mutex);
+		ssd_id = ssdtableLookup(&ssd_tag, ssd_hash, drive->ssd_hashtable);
 		if (ssd_id >= 0) {
-			ssd_hdr = &ssd_descriptors[ssd_id];
+			ssd_hdr = &drive->ssd_descriptors[ssd_id];
 		} else {
-			ssd_hdr = getStrategySSD();
-			//releaselock
-				pthread_mutex_unlock(&free_ssd_mutex);
+			ssd_hdr = getStrategySSD(drive, ssd_tag);
+			ssdtableInsert(&ssd_tag, ssd_hash, ssd_hdr->ssd_id, drive->ssd_hashtable);
 		}
-
-		ssdtableInsert(&ssd_tag, ssd_hash, ssd_hdr->ssd_id);
-		ssd_hdr->ssd_flag |= SSD_VALID | SSD_DIRTY;
-		ssd_hdr->ssd_tag = ssd_tag;
-		flush_fifo_blocks++;
-		returnCode = pwrite(inner_ssd_fd, buffer, BLCKSZ, ssd_hdr->ssd_id * BLCKSZ);
+		drive->stats.flush_fifo_blocks++;
+		returnCode = pwrite(drive->inner_ssd_fd, buffer + i * BLCKSZ, BLCKSZ, ssd_hdr->ssd_id * BLCKSZ);
+		//releaselock
+			pthread_mutex_unlock(&drive->free_ssd_mutex);
 		if (returnCode < 0) {
-			printf("[ERROR] smrwrite():-------write to smr disk: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, offset + i * BLCKSZ);
+			printf("[ERROR] smrwrite():-------write to smr disk: fd=%d, errorcode=%d, offset=%lu\n", drive->inner_ssd_fd, returnCode, offset + i * BLCKSZ);
 			exit(-1);
 		}
 	}
 
+	return 0;
 }
 
+/*
+ * a free slot of drive for ssd_tag, free_ssd_mutex held. The slot joins
+ * the list of its band. When the inner ssd is full the mutex is dropped
+ * until the cleaner has freed a slot, which counts as a cleaning stall.
+ */
 static SSDDesc *
-getStrategySSD()
+getStrategySSD(SMRDrive * drive, SSDTag ssd_tag)
 {
+	SSDStrategyControl *strategy_control = drive->ssd_strategy_control;
 	SSDDesc        *ssd_hdr;
+	long		ssd_id;
 
-	while (ssd_strategy_control->n_usedssd >= NSSDs) {
+	if (strategy_control->n_usedssd >= NSSDs)
+		drive->stats.clean_stalls++;
+	while (strategy_control->n_usedssd >= NSSDs) {
+		pthread_mutex_unlock(&drive->free_ssd_mutex);
 		usleep(1);
 		if (DEBUG)
-			printf("[INFO] getStrategySSD():--------ssd_strategy_control->n_usedssd=%ld\n", ssd_strategy_control->n_usedssd);
+			printf("[INFO] getStrategySSD():--------drive=%ld n_usedssd=%ld\n", drive->drive_num, strategy_control->n_usedssd);
+		pthread_mutex_lock(&drive->free_ssd_mutex);
+	}
+	if (strategy_control->first_freessd >= 0) {
+		ssd_id = strategy_control->first_freessd;
+		strategy_control->first_freessd = drive->ssd_descriptors[ssd_id].next_freessd;
+	} else
+		ssd_id = strategy_control->n_initssd++;
+	strategy_control->n_usedssd++;
+	ssd_hdr = &drive->ssd_descriptors[ssd_id];
+	ssd_hdr->ssd_id = ssd_id;
+	ssd_hdr->ssd_tag = ssd_tag;
+	ssd_hdr->ssd_flag = SSD_VALID | SSD_DIRTY;
+	addToSSDBand(drive, ssd_hdr);
+
+	return ssd_hdr;
+}
+
+/* link ssd_hdr into its band, a band's first block puts it at the tail of the band list */
+static void
+addToSSDBand(SMRDrive * drive, SSDDesc * ssd_hdr)
+{
+	SSDStrategyControl *strategy_control = drive->ssd_strategy_control;
+	long		band_num = GetSMRBandNumFromSSD(ssd_hdr->ssd_tag.offset);
+	SSDBandDesc    *band_hdr = &drive->ssd_band_descriptors[band_num];
+
+	if (band_hdr->nblocks == 0) {
+		band_hdr->first_ssd = -1;
+		band_hdr->first_write = strategy_control->write_clock;
+		band_hdr->next_band = -1;
+		band_hdr->last_band = strategy_control->last_band;
+		if (strategy_control->last_band >= 0)
+			drive->ssd_band_descriptors[strategy_control->last_band].next_band = band_num;
+		else
+			strategy_control->first_band = band_num;
+		strategy_control->last_band = band_num;
+		strategy_control->nbands++;
 	}
-	//allocatelock
-		pthread_mutex_lock(&free_ssd_mutex);
-	ssd_strategy_control->last_usedssd = (ssd_strategy_control->last_usedssd + 1) % NSSDs;
-	ssd_strategy_control->n_usedssd++;
+	ssd_hdr->next_freessd = band_hdr->first_ssd;
+	band_hdr->first_ssd = ssd_hdr->ssd_id;
+	band_hdr->nblocks++;
+	strategy_control->write_clock++;
+}
 
-	return &ssd_descriptors[ssd_strategy_control->last_usedssd];
+/*
+ * how much cleaning band_num is worth under CleanPolicy. FIFO keeps the
+ * band list order, greedy frees the most slots per band RMW, cost-benefit
+ * also favours bands whose blocks have sat in the inner ssd longest.
+ */
+static double
+cleanScore(SMRDrive * drive, long band_num)
+{
+	SSDBandDesc    *band_hdr = &drive->ssd_band_descriptors[band_num];
+
+	if (CleanPolicy == CleanGreedy)
+		return band_hdr->nblocks;
+	if (CleanPolicy == CleanCostBenefit)
+		return (double) band_hdr->nblocks * (drive->ssd_strategy_control->write_clock - band_hdr->first_write + 1);
+	return -(double) band_hdr->first_write;
 }
 
+/*
+ * the cleaner of one drive: flushes whole bands, chosen by cleanScore(),
+ * until at least NSSDCLEAN slots of its inner ssd are free again. The
+ * drives clean independently of each other.
+ */
 static void    *
-freeStrategySSD()
+freeStrategySSD(void *arg)
 {
+	SMRDrive       *drive = (SMRDrive *) arg;
+	SSDStrategyControl *strategy_control = drive->ssd_strategy_control;
+	SSDCleanCandidate *clean_window = drive->clean_window;
 	long		i;
+	long		nclean, nfree, start, band_num;
 
 	while (1) {
 		usleep(100);
-		interval_time++;
-		if ((interval_time > INTERVALTIMELIMIT && ssd_strategy_control->n_usedssd >= NSSDCLEAN) || ssd_strategy_control->n_usedssd >= NSSDLIMIT) {
+		drive->interval_time++;
+		if ((drive->interval_time > INTERVALTIMELIMIT && strategy_control->n_usedssd >= NSSDCLEAN) || strategy_control->n_usedssd >= NSSDLIMIT) {
 			if (DEBUG) {
-				printf("[INFO] freeStrategySSD():--------interval_time=%ld\n", interval_time);
-				printf("[INFO] freeStrategySSD():--------ssd_strategy_control->n_usedssd=%lu ssd_strategy_control->first_usedssd=%ld\n", ssd_strategy_control->n_usedssd, ssd_strategy_control->first_usedssd);
+				printf("[INFO] freeStrategySSD():--------drive=%ld interval_time=%ld\n", drive->drive_num, drive->interval_time);
+				printf("[INFO] freeStrategySSD():--------n_usedssd=%lu nbands=%ld\n", strategy_control->n_usedssd, strategy_control->nbands);
 			}
 			//allocatelock
-				pthread_mutex_lock(&free_ssd_mutex);
-			interval_time = 0;
-			for (i = ssd_strategy_control->first_usedssd; i < ssd_strategy_control->first_usedssd + NSSDCLEAN; i++) {
-				if (ssd_descriptors[i % NSSDs].ssd_flag & SSD_VALID) {
-					flushSSD(&ssd_descriptors[i % NSSDs]);
-				}
+				pthread_mutex_lock(&drive->free_ssd_mutex);
+			drive->interval_time = 0;
+			nclean = 0;
+			for (band_num = strategy_control->first_band; band_num >= 0; band_num = drive->ssd_band_descriptors[band_num].next_band) {
+				clean_window[nclean].band_num = band_num;
+				clean_window[nclean].score = cleanScore(drive, band_num);
+				nclean++;
 			}
-			ssd_strategy_control->first_usedssd = (ssd_strategy_control->first_usedssd + NSSDCLEAN) % NSSDs;
-			ssd_strategy_control->n_usedssd -= NSSDCLEAN;
+			if (CleanPolicy != CleanFIFO)
+				qsort(clean_window, nclean, sizeof(SSDCleanCandidate), compareCandidateByScore);
+			for (i = 0, nfree = 0; i < nclean && nfree < NSSDCLEAN; i++)
+				nfree += drive->ssd_band_descriptors[clean_window[i].band_num].nblocks;
+			nclean = i;
+			/* flush bands in one sweep from the head instead of in score order */
+			start = 0;
+			if (ELEVATOR_CLEAN) {
+				qsort(clean_window, nclean, sizeof(SSDCleanCandidate), compareCandidateByBand);
+				start = elevatorStart(clean_window, nclean, drive->smr_head_offset);
+			}
+			for (i = 0; i < nclean; i++)
+				flushSSD(drive, clean_window[(start + i) % nclean].band_num);
 			//releaselock
-				pthread_mutex_unlock(&free_ssd_mutex);
+				pthread_mutex_unlock(&drive->free_ssd_mutex);
 			if (DEBUG)
 				printf("[INFO] freeStrategySSD():--------after clean\n");
 		}
 	}
+	return NULL;
 }
 
+/*
+ * write band band_num back to the smr disk of drive together with all its
+ * inner ssd blocks, free_ssd_mutex held, and free their slots. The band
+ * image is assembled with one preadv() per run of adjacent slots, straight
+ * into the image; only the holes between the cached blocks are read from
+ * smr, one pread() each.
+ *
+ * A band is a row of SMR_TRACK_SIZE tracks, each shingled over the one
+ * before it, so rewriting a track clobbers only the tracks after it. Only
+ * the tracks from the one holding the first cached block to the end of the
+ * band are read and rewritten.
+ */
 static volatile void *
-flushSSD(SSDDesc * ssd_hdr)
+flushSSD(SMRDrive * drive, long band_num)
 {
-	long		i;
-	unsigned long	actual_band_size;
-	int		returnCode;
-	char		buffer    [BLCKSZ];
-	char           *band;
-	unsigned long	BandNum = GetSMRBandNumFromSSD(ssd_hdr->ssd_tag.offset);
-	off_t		Offset;
+	struct iovec	iov[SSD_IOV_MAX];
+	SSDStrategyControl *strategy_control = drive->ssd_strategy_control;
+	SSDDesc        *ssd_descriptors = drive->ssd_descriptors;
+	SSDBandDesc    *band_hdr = &drive->ssd_band_descriptors[band_num];
+	off_t		band_start = GetSMRDriveBandStartFromNum(band_num);
+	unsigned long	band_size = GetSMRActualBandSizeFromSSD(GetSMRBandStartFromNum(band_num));
+	long		nblocks = band_size / BLCKSZ, nslots = 0, first, i, k;
+	long	       *slots;
+	char	       *band, *cached;
+	ssize_t		returnCode;
 
-	actual_band_size = GetSMRActualBandSizeFromSSD(ssd_hdr->ssd_tag.offset);
-	returnCode = posix_memalign(&band, 512, sizeof(char) * actual_band_size);
-	if (returnCode < 0) {
-		printf("[ERROR] flushSSD():-------posix_memalign\n");
+	slots = (long *) malloc(sizeof(long) * nblocks);
+	cached = (char *) calloc(nblocks, 1);
+	if (slots == NULL || cached == NULL || posix_memalign((void **) &band, 512, band_size) != 0) {
+		printf("[ERROR] flushSSD():-------alloc band of %lu bytes\n", band_size);
 		exit(-1);
 	}
-	if (BandOrBlock == 0) {
-		returnCode = pread(smr_fd, band, BNDSZ, BandNum * BNDSZ);
-		if (returnCode < 0) {
-			printf("[ERROR] flushSSD():---------read from smr: fd=%d, errorcode=%d, offset=%lu\n", smr_fd, returnCode, BandNum * actual_band_size);
-			exit(-1);
+	for (i = band_hdr->first_ssd; nslots < band_hdr->nblocks; i = ssd_descriptors[i].next_freessd)
+		slots[nslots++] = i;
+	qsort(slots, nslots, sizeof(long), compareLong);
+
+	for (i = 0; i < nslots; i = k) {
+		for (k = i; k < nslots && k - i < SSD_IOV_MAX && slots[k] == slots[i] + (k - i); k++) {
+			iov[k - i].iov_base = band + GetSMROffsetInBandFromSSD(&ssd_descriptors[slots[k]]) * BLCKSZ;
+			iov[k - i].iov_len = BLCKSZ;
+			cached[GetSMROffsetInBandFromSSD(&ssd_descriptors[slots[k]])] = 1;
 		}
-		returnCode = pread(inner_ssd_fd, band + GetSMROffsetInBandFromSSD(ssd_hdr) * BLCKSZ, BLCKSZ, ssd_hdr->ssd_id * BLCKSZ);
+		returnCode = preadv(drive->inner_ssd_fd, iov, k - i, slots[i] * BLCKSZ);
 		if (returnCode < 0) {
-			printf("[ERROR] flushSSD():-------read from inner ssd: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, ssd_hdr->ssd_id * BLCKSZ);
+			printf("[ERROR] flushSSD():-------read from inner ssd: fd=%d, errorcode=%ld, offset=%lu\n", drive->inner_ssd_fd, (long) returnCode, slots[i] * BLCKSZ);
 			exit(-1);
 		}
-		for (i = ssd_strategy_control->first_usedssd; i < ssd_strategy_control->first_usedssd + ssd_strategy_control->n_usedssd; i++) {
-			if (ssd_descriptors[i % NSSDs].ssd_flag & SSD_VALID && GetSMRBandNumFromSSD((&ssd_descriptors[i % NSSDs])->ssd_tag.offset) == BandNum) {
-				Offset = GetSMROffsetInBandFromSSD(&ssd_descriptors[i % NSSDs]);
-				returnCode = pread(inner_ssd_fd, band + Offset * BLCKSZ, BLCKSZ, ssd_descriptors[i % NSSDs].ssd_id * BLCKSZ);
-				if (returnCode < 0) {
-					printf("[ERROR] flushSSD():-------read from inner ssd: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, ssd_descriptors[i % NSSDs].ssd_id * BLCKSZ);
-					exit(-1);
-				}
-				long		tmp_hash = ssdtableHashcode(&ssd_descriptors[i % NSSDs].ssd_tag);
-				long		tmp_id = ssdtableLookup(&ssd_descriptors[i % NSSDs].ssd_tag, tmp_hash);
-				ssdtableDelete(&ssd_descriptors[i % NSSDs].ssd_tag, ssdtableHashcode(&ssd_descriptors[i % NSSDs].ssd_tag));
-				ssd_descriptors[i % NSSDs].ssd_flag = 0;
-			}
+		drive->stats.flush_band_syscalls++;
+		drive->stats.flush_band_read_bytes += (k - i) * BLCKSZ;
+	}
+	for (first = 0; first < nblocks && !cached[first]; first++);
+	if (SMR_TRACK_SIZE > 0)
+		first = first * BLCKSZ / SMR_TRACK_SIZE * SMR_TRACK_SIZE / BLCKSZ;
+	else
+		first = 0;
+	for (i = first; i < nblocks; i = k) {
+		if (cached[i]) {
+			k = i + 1;
+			continue;
 		}
-	} else {
-		returnCode = pread(inner_ssd_fd, band, BNDSZ, ssd_hdr->ssd_id * BNDSZ);
+		for (k = i; k < nblocks && !cached[k]; k++);
+		trackSMRSeek(drive, band_start + i * BLCKSZ, (k - i) * BLCKSZ);
+		returnCode = pread(drive->smr_fd, band + i * BLCKSZ, (k - i) * BLCKSZ, band_start + i * BLCKSZ);
 		if (returnCode < 0) {
-			printf("[ERROR] flushSSD():-------pread: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, BandNum * actual_band_size);
+			printf("[ERROR] flushSSD():---------read from smr: fd=%d, errorcode=%ld, offset=%lu\n", drive->smr_fd, (long) returnCode, band_start + i * BLCKSZ);
 			exit(-1);
 		}
+		/* never written, past the end of the smr file */
+		if (returnCode < (k - i) * BLCKSZ)
+			memset(band + i * BLCKSZ + returnCode, 0, (k - i) * BLCKSZ - returnCode);
+		drive->stats.flush_band_syscalls++;
+		drive->stats.flush_band_read_bytes += (k - i) * BLCKSZ;
+	}
+
+	for (i = 0; i < nslots; i++) {
+		ssdtableDelete(&ssd_descriptors[slots[i]].ssd_tag, ssdtableHashcode(&ssd_descriptors[slots[i]].ssd_tag), drive->ssd_hashtable);
+		ssd_descriptors[slots[i]].ssd_flag = 0;
+		ssd_descriptors[slots[i]].next_freessd = strategy_control->first_freessd;
+		strategy_control->first_freessd = slots[i];
+		drive->stats.flush_band_blocks++;
 	}
-	flush_bands++;
-	returnCode = pwrite(smr_fd, band, BNDSZ, BandNum * BNDSZ);
+	strategy_control->n_usedssd -= nslots;
+	band_hdr->nblocks = 0;
+	if (band_hdr->last_band >= 0)
+		drive->ssd_band_descriptors[band_hdr->last_band].next_band = band_hdr->next_band;
+	else
+		strategy_control->first_band = band_hdr->next_band;
+	if (band_hdr->next_band >= 0)
+		drive->ssd_band_descriptors[band_hdr->next_band].last_band = band_hdr->last_band;
+	else
+		strategy_control->last_band = band_hdr->last_band;
+	strategy_control->nbands--;
+	drive->stats.flush_bands++;
+	trackSMRSeek(drive, band_start + first * BLCKSZ, band_size - first * BLCKSZ);
+	returnCode = pwrite(drive->smr_fd, band + first * BLCKSZ, band_size - first * BLCKSZ, band_start + first * BLCKSZ);
 	if (returnCode < 0) {
-		printf("[ERROR] flushSSD():-------write to smr: fd=%d, errorcode=%d, offset=%lu\n", inner_ssd_fd, returnCode, BandNum * actual_band_size);
+		printf("[ERROR] flushSSD():-------write to smr: fd=%d, errorcode=%ld, offset=%lu\n", drive->smr_fd, (long) returnCode, band_start + first * BLCKSZ);
 		exit(-1);
 	}
+	drive->stats.flush_band_syscalls++;
+	drive->stats.flush_band_write_bytes += band_size - first * BLCKSZ;
 	free(band);
+	free(cached);
+	free(slots);
+	return NULL;
+}
+
+/*
+ * The inner ssds are persistent: the FIFO state of each and the tags of
+ * its valid blocks are written past its NSSDs blocks with every cache
+ * checkpoint, drive by drive.
+ */
+void
+checkpointSSD()
+{
+	long		d;
+
+	for (d = 0; d < NSMRDrives; d++) {
+		pthread_mutex_lock(&smr_drives[d].smrwrite_mutex);
+		checkpointSSDDrive(&smr_drives[d]);
+		pthread_mutex_unlock(&smr_drives[d].smrwrite_mutex);
+	}
+}
+
+/* smrwrite_mutex of drive held; free_ssd_mutex keeps the cleaner out while the state is copied */
+static void
+checkpointSSDDrive(SMRDrive * drive)
+{
+	SSDCheckpointHeader *header;
+	SSDCheckpointEntry *entries;
+	char	       *buffer;
+	size_t		size = 4096 + (sizeof(SSDCheckpointEntry) * NSSDs + 4095) / 4096 * 4096;
+	long		i, n, band_num;
+	int		returnCode;
+
+	returnCode = posix_memalign((void **) &buffer, 512, size);
+	if (returnCode != 0) {
+		printf("[ERROR] checkpointSSD():-------posix_memalign\n");
+		exit(-1);
+	}
+	memset(buffer, 0, size);
+	header = (SSDCheckpointHeader *) buffer;
+	entries = (SSDCheckpointEntry *) (buffer + 4096);
+
+	pthread_mutex_lock(&drive->free_ssd_mutex);
+	header->magic = SSD_CHECKPOINT_MAGIC;
+	header->nssds = NSSDs;
+	header->blcksz = BLCKSZ;
+	header->n_usedssd = drive->ssd_strategy_control->n_usedssd;
+	header->nentries = 0;
+	for (band_num = drive->ssd_strategy_control->first_band; band_num >= 0; band_num = drive->ssd_band_descriptors[band_num].next_band) {
+		for (i = drive->ssd_band_descriptors[band_num].first_ssd, n = 0; n < drive->ssd_band_descriptors[band_num].nblocks; i = drive->ssd_descriptors[i].next_freessd, n++) {
+			entries[header->nentries].offset = drive->ssd_descriptors[i].ssd_tag.offset;
+			entries[header->nentries].ssd_id = i;
+			header->nentries++;
+		}
+	}
+	pthread_mutex_unlock(&drive->free_ssd_mutex);
+
+	/* entries first, the header makes them current */
+	returnCode = pwrite(drive->inner_ssd_fd, buffer + 4096, size - 4096, NSSDs * BLCKSZ + 4096);
+	if (returnCode >= 0)
+		returnCode = pwrite(drive->inner_ssd_fd, buffer, 4096, NSSDs * BLCKSZ);
+	if (returnCode < 0) {
+		printf("[ERROR] checkpointSSD():-------write to inner ssd: fd=%d, errorcode=%d, offset=%lu\n", drive->inner_ssd_fd, returnCode, NSSDs * BLCKSZ);
+		exit(-1);
+	}
+	free(buffer);
+}
+
+/* returns the # of inner ssd blocks restored over all drives */
+long
+restoreSSD()
+{
+	long		d, nrestored = 0;
+
+	for (d = 0; d < NSMRDrives; d++) {
+		pthread_mutex_lock(&smr_drives[d].smrwrite_mutex);
+		nrestored += restoreSSDDrive(&smr_drives[d]);
+		pthread_mutex_unlock(&smr_drives[d].smrwrite_mutex);
+	}
+	return nrestored;
+}
+
+static long
+restoreSSDDrive(SMRDrive * drive)
+{
+	SSDCheckpointHeader *header;
+	SSDCheckpointEntry *entries;
+	char	       *buffer;
+	size_t		size = 4096 + (sizeof(SSDCheckpointEntry) * NSSDs + 4095) / 4096 * 4096;
+	long		i;
+	int		returnCode;
+	unsigned long	ssd_hash;
+	SSDDesc        *ssd_hdr;
+
+	returnCode = posix_memalign((void **) &buffer, 512, size);
+	if (returnCode != 0) {
+		printf("[ERROR] restoreSSD():-------posix_memalign\n");
+		exit(-1);
+	}
+	memset(buffer, 0, size);
+	header = (SSDCheckpointHeader *) buffer;
+	entries = (SSDCheckpointEntry *) (buffer + 4096);
+	returnCode = pread(drive->inner_ssd_fd, buffer, size, NSSDs * BLCKSZ);
+	if (returnCode < 0) {
+		printf("[ERROR] restoreSSD():-------read from inner ssd: fd=%d, errorcode=%d, offset=%lu\n", drive->inner_ssd_fd, returnCode, NSSDs * BLCKSZ);
+		exit(-1);
+	}
+	if (header->magic != SSD_CHECKPOINT_MAGIC || header->nssds != NSSDs || header->blcksz != BLCKSZ || header->nentries > NSSDs) {
+		free(buffer);
+		return 0;
+	}
+
+	/* the entries come band by band in first_write order, which rebuilds the band list */
+	pthread_mutex_lock(&drive->free_ssd_mutex);
+	drive->ssd_strategy_control->n_usedssd = header->nentries;
+	for (i = 0; i < header->nentries; i++) {
+		ssd_hdr = &drive->ssd_descriptors[entries[i].ssd_id];
+		ssd_hdr->ssd_id = entries[i].ssd_id;
+		ssd_hdr->ssd_tag.offset = entries[i].offset;
+		ssd_hdr->ssd_flag = SSD_VALID | SSD_DIRTY;
+		ssd_hash = ssdtableHashcode(&ssd_hdr->ssd_tag);
+		ssdtableInsert(&ssd_hdr->ssd_tag, ssd_hash, ssd_hdr->ssd_id, drive->ssd_hashtable);
+		addToSSDBand(drive, ssd_hdr);
+	}
+	/* every other slot is free */
+	drive->ssd_strategy_control->first_freessd = -1;
+	drive->ssd_strategy_control->n_initssd = NSSDs;
+	for (i = NSSDs - 1; i >= 0; i--) {
+		if (drive->ssd_descriptors[i].ssd_flag & SSD_VALID)
+			continue;
+		drive->ssd_descriptors[i].next_freessd = drive->ssd_strategy_control->first_freessd;
+		drive->ssd_strategy_control->first_freessd = i;
+	}
+	pthread_mutex_unlock(&drive->free_ssd_mutex);
+	i = header->nentries;
+	free(buffer);
+	return i;
 }
 
 unsigned long 
@@ -242,7 +690,7 @@ GetSMRActualBandSizeFromSSD(unsigned long offset)
 	long		i        , size, total_size = 0;
 	for (i = 0; i < band_size_num; i++) {
 		size = BNDSZ / 2 + i * 1024 * 1024;
-		if (total_size + size * num_each_size >= offset)
+		if (total_size + size * num_each_size > offset)
 			return size;
 		total_size += size * num_each_size;
 	}
@@ -266,6 +714,25 @@ GetSMRBandNumFromSSD(unsigned long offset)
 	return 0;
 }
 
+/*
+ * first byte of band band_num, the inverse of GetSMRBandNumFromSSD()
+ */
+unsigned long
+GetSMRBandStartFromNum(unsigned long band_num)
+{
+	long		band_size_num = BNDSZ / 1024 / 1024 / 2 + 1;
+	long		num_each_size = NSMRBands / band_size_num;
+	long		i        , size, total_size = 0;
+	for (i = 0; i < band_size_num; i++) {
+		size = BNDSZ / 2 + i * 1024 * 1024;
+		if (band_num < num_each_size * (i + 1))
+			return total_size + (band_num - num_each_size * i) * size;
+		total_size += size * num_each_size;
+	}
+
+	return total_size;
+}
+
 off_t 
 GetSMROffsetInBandFromSSD(SSDDesc * ssd_hdr)
 {
@@ -277,10 +744,58 @@ GetSMROffsetInBandFromSSD(SSDDesc * ssd_hdr)
 	for (i = 0; i < band_size_num; i++) {
 		size = BNDSZ / 2 + i * 1024 * 1024;
 		if (total_size + size * num_each_size > offset)
-			return (offset - (offset - total_size) / size * size) / BLCKSZ;
+			return (offset - total_size) % size / BLCKSZ;
 		total_size += size * num_each_size;
 	}
 
 	return -1;
 	//return (ssd_hdr->ssd_tag.offset / BLCKSZ) % (actual_band_size / BLCKSZ);
 }
+
+
+/*
+ * The smr bands are striped over the drives of the array: band band_num is
+ * on drive band_num % NSMRDrives, which stores only its own bands, back to
+ * back in band order. One drive stores every band where it always did.
+ */
+long
+GetSMRDriveNumFromSSD(unsigned long offset)
+{
+	return GetSMRBandNumFromSSD(offset) % NSMRDrives;
+}
+
+/* # of bands before band_num that are on drive drive_num */
+static unsigned long
+countDriveBands(unsigned long band_num, long drive_num)
+{
+	return (band_num + NSMRDrives - 1 - drive_num) / NSMRDrives;
+}
+
+/*
+ * first byte of band band_num on its drive, GetSMRBandStartFromNum() with
+ * only the bands of that drive counted
+ */
+unsigned long
+GetSMRDriveBandStartFromNum(unsigned long band_num)
+{
+	long		band_size_num = BNDSZ / 1024 / 1024 / 2 + 1;
+	long		num_each_size = NSMRBands / band_size_num;
+	long		drive_num = band_num % NSMRDrives;
+	long		i        , size, total_size = 0;
+	for (i = 0; i < band_size_num; i++) {
+		size = BNDSZ / 2 + i * 1024 * 1024;
+		if (band_num < num_each_size * (i + 1))
+			return total_size + (countDriveBands(band_num, drive_num) - countDriveBands(num_each_size * i, drive_num)) * size;
+		total_size += (countDriveBands(num_each_size * (i + 1), drive_num) - countDriveBands(num_each_size * i, drive_num)) * size;
+	}
+
+	return total_size;
+}
+
+unsigned long
+GetSMRDriveOffsetFromSSD(unsigned long offset)
+{
+	unsigned long	band_num = GetSMRBandNumFromSSD(offset);
+
+	return GetSMRDriveBandStartFromNum(band_num) + offset - GetSMRBandStartFromNum(band_num);
+}
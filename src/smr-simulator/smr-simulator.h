@@ -16,7 +16,7 @@ typedef struct
         long       ssd_id;			// ssd buffer location 
         unsigned   ssd_flag;
 //	long		usage_count;
-//	long		next_freessd;
+	long		next_freessd;		// next free slot, or next slot of the same band
 } SSDDesc;
 
 #define SSD_VALID 0x01
@@ -29,32 +29,126 @@ typedef struct SSDHashBucket
         struct SSDHashBucket		*next_item;
 } SSDHashBucket;
 
+/* the inner ssd blocks of one smr band, indexed by band number */
+typedef struct
+{
+	long		first_ssd;		// first slot of the band, valid if nblocks > 0
+	long		nblocks;
+	unsigned long	first_write;		// write_clock when the band got its oldest block
+	long		last_band;		// cached bands in first_write order
+	long		next_band;
+} SSDBandDesc;
+
 typedef struct
 {
 	unsigned long		n_usedssd;
-	long		first_usedssd;		// Head of list of used ssds
-	long		last_usedssd;		// Tail of list of used ssds
+	long		first_freessd;		// Head of list of free ssds
+	long		n_initssd;		// slots [0, n_initssd) have been handed out before
+	long		first_band;		// Head of list of cached bands, the oldest first
+	long		last_band;		// Tail of list of cached bands
+	long		nbands;
+	unsigned long	write_clock;		// inner ssd blocks written so far
 } SSDStrategyControl;
 
+/* a band the cleaner may flush, scored by cleanScore() */
+typedef struct
+{
+	long		band_num;
+	double		score;
+} SSDCleanCandidate;
+
+typedef struct
+{
+	unsigned long	flush_bands;
+	unsigned long	flush_fifo_blocks;
+	unsigned long	smr_seeks;
+	unsigned long	smr_seek_distance;
+	unsigned long	smrwrite_band_switches;
+	unsigned long	flush_band_blocks;
+	unsigned long	flush_band_syscalls;
+	unsigned long	flush_band_read_bytes;
+	unsigned long	flush_band_write_bytes;
+	unsigned long	clean_stalls;
+} SMRDriveStats;
+
+/*
+ * one smr drive of the array with its own inner ssd, cleaner and counters.
+ * The smr bands are striped over the drives, see GetSMRDriveNumFromSSD().
+ */
+typedef struct
+{
+	long		drive_num;
+	int		smr_fd;
+	int		inner_ssd_fd;
+	SSDDesc	       *ssd_descriptors;
+	SSDBandDesc    *ssd_band_descriptors;	// indexed by array wide band number
+	SSDStrategyControl *ssd_strategy_control;
+	SSDHashBucket  *ssd_hashtable;
+	pthread_mutex_t	free_ssd_mutex;		// inner ssd state, taken by smrread, smrwrite and the cleaner
+	pthread_mutex_t	smrwrite_mutex;		// write backs of the ssd cache to this drive
+	SSDCleanCandidate *clean_window;	// bands of one cleaning round, in elevator order
+	unsigned long	interval_time;
+	off_t		smr_head_offset;	// on this drive, see trackSMRSeek()
+	long		last_band;		// of the previous smrwrite
+	SMRDriveStats	stats;
+} SMRDrive;
+
+typedef enum
+{
+	CleanFIFO,				// the bands cached longest
+	CleanGreedy,				// the bands with the most cached blocks
+	CleanCostBenefit			// the most cached blocks times age
+} SSDCleanPolicy;
+
+#define SSD_CHECKPOINT_MAGIC 0x534d52494e4e5232UL	// "SMRINNR2"
+
+/* inner ssd metadata, kept past the NSSDs blocks of the inner ssd device */
+typedef struct
+{
+	unsigned long	magic;
+	unsigned long	nssds;
+	unsigned long	blcksz;
+	unsigned long	n_usedssd;
+	unsigned long	nentries;			// SSDCheckpointEntry records following the header block, band by band in first_write order
+} SSDCheckpointHeader;
+
+typedef struct
+{
+	unsigned long	offset;
+	long		ssd_id;
+} SSDCheckpointEntry;
+
 extern unsigned long flush_bands;
 extern unsigned long flush_fifo_blocks;
+extern unsigned long smr_seeks;
+extern unsigned long smr_seek_distance;		// bytes of head movement over all seeks
+extern unsigned long smrwrite_band_switches;	// smrwrite calls to a different band than the previous one
+extern unsigned long flush_band_blocks;		// inner ssd blocks written back by band flushes
+extern unsigned long flush_band_syscalls;	// preadv, pread and pwrite calls of band flushes
+extern unsigned long flush_band_read_bytes;	// inner ssd and smr bytes read to assemble flushed bands
+extern unsigned long flush_band_write_bytes;	// smr bytes rewritten by band flushes, from the first updated track on
+extern unsigned long clean_stalls;		// smrwrite blocks that waited for the cleaner to free a slot
 //extern unsigned long write-fifo-num;
 
-extern SSDDesc		*ssd_descriptors;
+extern SMRDrive		*smr_drives;
 extern char             *ssd_blocks;
-extern SSDStrategyControl *ssd_strategy_control;
-extern SSDHashBucket	*ssd_hashtable;
 
 //#define GetSSDblockFromId(ssd_id) ((void *) (ssd_blocks + ((long) (ssd_id)) * SSD_SIZE))
-#define GetSSDHashBucket(hash_code) ((SSDHashBucket *) (ssd_hashtable + (unsigned long) (hash_code)))
+#define GetSSDHashBucket(ssd_hashtable, hash_code) ((SSDHashBucket *) ((ssd_hashtable) + (unsigned long) (hash_code)))
 
 extern unsigned long GetSMRActualBandSizeFromSSD(unsigned long offset);
 extern unsigned long GetSMRBandNumFromSSD(unsigned long offset);
+extern unsigned long GetSMRBandStartFromNum(unsigned long band_num);
 extern off_t GetSMROffsetInBandFromSSD(SSDDesc *ssd_hdr);
-extern int smrread(int smr_fd, char* buffer, size_t size, off_t offset);
-extern int smrwrite(int smr_fd, char* buffer, size_t size, off_t offset);
+extern long GetSMRDriveNumFromSSD(unsigned long offset);
+extern unsigned long GetSMRDriveBandStartFromNum(unsigned long band_num);
+extern unsigned long GetSMRDriveOffsetFromSSD(unsigned long offset);
+extern void trackSMRSeek(SMRDrive *drive, off_t offset, size_t size);
+extern int smrread(char* buffer, size_t size, off_t offset);
+extern int smrwrite(char* buffer, size_t size, off_t offset);
 
 extern unsigned long NSSDs;
+extern unsigned long NSMRDrives;
 extern unsigned long NSSDTables;
 extern unsigned long NSMRBands;
 extern unsigned long SSD_SIZE;
@@ -63,14 +157,20 @@ extern size_t BNDSZ;
 extern unsigned long INTERVALTIMELIMIT;
 extern unsigned	long NSSDLIMIT;
 extern unsigned long NSSDCLEAN;
+extern unsigned long ELEVATOR_CLEAN;
+extern unsigned long SMR_TRACK_SIZE;
+extern SSDCleanPolicy CleanPolicy;
+extern char    *clean_policy_names[];
 extern char     smr_device[100];
 extern char	inner_ssd_device[100];
-extern int 	inner_ssd_fd;
-extern int 	smr_fd;
-extern unsigned	long interval_time;
-extern pthread_mutex_t free_ssd_mutex;
 extern pthread_mutex_t inner_ssd_hdr_mutex;
 extern pthread_mutex_t inner_ssd_hash_mutex;
 extern void initSSD();
+extern void openSMRDrives(char *smr_path, char *inner_ssd_path, int flags);
+extern void closeSMRDrives();
+extern void collectSMRDriveStats();
+extern void resetSMRDriveStats();
+extern void checkpointSSD();
+extern long restoreSSD();
 
 #endif
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+
+#include "ssd-cache.h"
+#include "smr-simulator.h"
+#include "zoned.h"
+
+static void	openZone(unsigned long zone);
+static void	closeZone(unsigned long zone);
+
+/*
+ * A host-managed smr drive on a plain file: the zones are the smr bands and
+ * each has a write pointer. Writes must start at the write pointer of their
+ * zone and stay inside it; a write to an empty zone opens it, which fails
+ * when ZONED_MAX_OPEN zones are open already. A zone is full once its write
+ * pointer reaches its end, a reset empties it and a finish fills it. Reads
+ * past the write pointer return zeros. The write pointers live in memory
+ * only, every zone starts empty. A zoned array has a single drive.
+ */
+void
+initZones()
+{
+	zone_descriptors = (ZoneDesc *) allocSSDArray(NSMRBands, sizeof(ZoneDesc));
+	zone_control = (ZoneControl *) malloc(sizeof(ZoneControl));
+	zone_control->nopen = 0;
+	zone_control->first_open = -1;
+	zone_control->last_open = -1;
+	zone_resets = 0;
+	zone_reset_bytes = 0;
+	zone_finishes = 0;
+	zone_write_bytes = 0;
+}
+
+static void
+openZone(unsigned long zone)
+{
+	ZoneDesc       *zone_hdr = &zone_descriptors[zone];
+
+	zone_hdr->cond = ZoneOpen;
+	zone_hdr->next_open = -1;
+	zone_hdr->last_open = zone_control->last_open;
+	if (zone_control->last_open >= 0)
+		zone_descriptors[zone_control->last_open].next_open = zone;
+	else
+		zone_control->first_open = zone;
+	zone_control->last_open = zone;
+	zone_control->nopen++;
+}
+
+/* off the open list, the caller sets the new condition */
+static void
+closeZone(unsigned long zone)
+{
+	ZoneDesc       *zone_hdr = &zone_descriptors[zone];
+
+	if (zone_hdr->last_open >= 0)
+		zone_descriptors[zone_hdr->last_open].next_open = zone_hdr->next_open;
+	else
+		zone_control->first_open = zone_hdr->next_open;
+	if (zone_hdr->next_open >= 0)
+		zone_descriptors[zone_hdr->next_open].last_open = zone_hdr->last_open;
+	else
+		zone_control->last_open = zone_hdr->last_open;
+	zone_control->nopen--;
+}
+
+int
+zoneread(int fd, char *buffer, size_t size, off_t offset)
+{
+	unsigned long	zone, zone_start, zone_size, n, valid;
+	int		returnCode;
+
+	while (size > 0) {
+		zone = GetSMRBandNumFromSSD(offset);
+		zone_start = GetSMRBandStartFromNum(zone);
+		zone_size = GetSMRActualBandSizeFromSSD(offset);
+		n = zone_start + zone_size - offset < size ? zone_start + zone_size - offset : size;
+		valid = zone_start + zone_descriptors[zone].wp > offset ? zone_start + zone_descriptors[zone].wp - offset : 0;
+		if (valid > n)
+			valid = n;
+		if (valid > 0) {
+			trackSMRSeek(&smr_drives[0], offset, valid);
+			returnCode = pread(fd, buffer, valid, offset);
+			if (returnCode < 0) {
+				printf("[ERROR] zoneread():-------read from smr: fd=%d, errorcode=%d, offset=%lu\n", fd, returnCode, offset);
+				return -1;
+			}
+			if (returnCode < valid)
+				memset(buffer + returnCode, 0, valid - returnCode);
+		}
+		memset(buffer + valid, 0, n - valid);
+		buffer += n;
+		offset += n;
+		size -= n;
+	}
+	return 0;
+}
+
+int
+zonewrite(int fd, char *buffer, size_t size, off_t offset)
+{
+	unsigned long	zone = GetSMRBandNumFromSSD(offset);
+	unsigned long	zone_start = GetSMRBandStartFromNum(zone);
+	unsigned long	zone_size = GetSMRActualBandSizeFromSSD(offset);
+	ZoneDesc       *zone_hdr = &zone_descriptors[zone];
+	int		returnCode;
+
+	if (zone_hdr->cond == ZoneFull || offset != zone_start + zone_hdr->wp || zone_hdr->wp + size > zone_size) {
+		printf("[ERROR] zonewrite():-------unaligned write: zone=%lu wp=%lu offset=%lu size=%lu\n", zone, zone_hdr->wp, offset, (unsigned long) size);
+		return -1;
+	}
+	if (zone_hdr->cond == ZoneEmpty) {
+		if (zone_control->nopen >= ZONED_MAX_OPEN) {
+			printf("[ERROR] zonewrite():-------zone=%lu exceeds %lu open zones\n", zone, ZONED_MAX_OPEN);
+			return -1;
+		}
+		openZone(zone);
+	}
+	trackSMRSeek(&smr_drives[0], offset, size);
+	returnCode = pwrite(fd, buffer, size, offset);
+	if (returnCode < 0) {
+		printf("[ERROR] zonewrite():-------write to smr: fd=%d, errorcode=%d, offset=%lu\n", fd, returnCode, offset);
+		return -1;
+	}
+	zone_hdr->wp += size;
+	zone_write_bytes += size;
+	if (zone_hdr->wp == zone_size) {
+		closeZone(zone);
+		zone_hdr->cond = ZoneFull;
+	}
+	return 0;
+}
+
+void
+zonereset(unsigned long zone)
+{
+	ZoneDesc       *zone_hdr = &zone_descriptors[zone];
+
+	if (zone_hdr->cond == ZoneOpen)
+		closeZone(zone);
+	zone_resets++;
+	zone_reset_bytes += zone_hdr->wp;
+	zone_hdr->wp = 0;
+	zone_hdr->cond = ZoneEmpty;
+}
+
+void
+zonefinish(unsigned long zone)
+{
+	ZoneDesc       *zone_hdr = &zone_descriptors[zone];
+
+	if (zone_hdr->cond == ZoneOpen)
+		closeZone(zone);
+	zone_finishes++;
+	zone_hdr->wp = GetSMRActualBandSizeFromSSD(GetSMRBandStartFromNum(zone));
+	zone_hdr->cond = ZoneFull;
+}
@@ -0,0 +1,45 @@
+#ifndef SMR_SSD_CACHE_ZONED_H
+#define SMR_SSD_CACHE_ZONED_H
+
+#define DEBUG 0
+/* ---------------------------host-managed zoned smr---------------------------- */
+
+typedef enum
+{
+	ZoneEmpty,
+	ZoneOpen,				// implicitly opened by a write
+	ZoneFull
+} ZoneCondition;
+
+/* one zone per smr band, indexed by band number */
+typedef struct
+{
+	unsigned long	wp;			// write pointer, bytes from the zone start
+	ZoneCondition	cond;
+	long		last_open;		// open zones, the least recently opened first
+	long		next_open;
+} ZoneDesc;
+
+typedef struct
+{
+	long		nopen;
+	long		first_open;		// Head of list of open zones, finished first
+	long		last_open;		// Tail of list of open zones
+} ZoneControl;
+
+extern unsigned long ZONED_SMR;
+extern unsigned long ZONED_MAX_OPEN;
+extern unsigned long zone_resets;
+extern unsigned long zone_reset_bytes;		// bytes behind the write pointer dropped by resets
+extern unsigned long zone_finishes;
+extern unsigned long zone_write_bytes;
+
+extern ZoneDesc *zone_descriptors;
+extern ZoneControl *zone_control;
+
+extern void initZones();
+extern int zoneread(int fd, char *buffer, size_t size, off_t offset);
+extern int zonewrite(int fd, char *buffer, size_t size, off_t offset);
+extern void zonereset(unsigned long zone);
+extern void zonefinish(unsigned long zone);
+#endif
@@ -2,25 +2,46 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include "ssd-cache.h"
 #include "smr-simulator/smr-simulator.h"
+#include "smr-simulator/zoned.h"
 #include "ssd_buf_table.h"
+#include "destage.h"
+#include "checkpoint.h"
+#include "staging.h"
+#include "admission.h"
+#include "strategy/band_hotness.h"
 #include "strategy/clock.h"
 #include "strategy/lru.h"
 #include "strategy/lruofband.h"
 #include "strategy/most.h"
 #include "strategy/scan.h"
 #include "strategy/WA.h"
+#include "strategy/mostbucket.h"
+#include "strategy/arc.h"
+#include "strategy/twoq.h"
+#include "strategy/costbenefit.h"
 static SSDBufferDesc *SSDBufferAlloc(SSDBufferTag ssd_buf_tag, bool * found);
 static void    *initStrategySSDBuffer(SSDEvictionStrategy strategy);
-static SSDBufferDesc *getSSDStrategyBuffer(SSDBufferTag ssd_buf_tag, SSDEvictionStrategy strategy);
-static void    *hitInSSDBuffer(SSDBufferDesc * ssd_buf_hdr, SSDEvictionStrategy strategy);
+static void	initSSDBufferDesc(long ssd_buf_id);
+static void	initStrategySSDBufferDesc(long ssd_buf_id, SSDEvictionStrategy strategy);
+static void	writeBackZoned(char *buffer, off_t *offsets, long n, unsigned long size);
+static void	reportProgress();
+static bool	admitSSDWrite(SSDBufferTag ssd_buf_tag, unsigned long nblocks);
+static void	writeAroundSSD(char *buffer, unsigned long size, off_t offset);
+static long	lowestWearBucket();
+static long	nextFreeSSDBuffer();
+static void	wearSSDBuffers(long ssd_buf_id, long n, unsigned long size);
 /*
  * init buffer hash table, strategy_control, buffer, work_mem
  */
 void 
 initSSDBuffer()
 {
+	long		i;
+
 	initStrategySSDBuffer(EvictStrategy);
 	initSSDBufTable(NSSDBufTables);
 
@@ -29,57 +50,416 @@ initSSDBuffer()
 	//printf("usedssd: %ld\n", ssd_buffer_strategy_control->n_usedssd);
 	ssd_buffer_strategy_control->first_freessd = 0;
 	ssd_buffer_strategy_control->last_freessd = NSSDBuffers - 1;
+	ssd_buffer_strategy_control->n_initssd = 0;
+	ssd_buffer_strategy_control->first_unusedssd = 0;
+	for (i = 0; i < NWEARBUCKETS; i++)
+		ssd_buffer_strategy_control->first_wearfreessd[i] = -1;
+	memset(ssd_buffer_strategy_control->wear_bitmap, 0, sizeof(ssd_buffer_strategy_control->wear_bitmap));
 
-	ssd_buffer_descriptors = (SSDBufferDesc *) malloc(sizeof(SSDBufferDesc) * NSSDBuffers);
-	SSDBufferDesc  *ssd_buf_hdr;
-	long		i;
-	ssd_buf_hdr = ssd_buffer_descriptors;
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr++, i++) {
-		ssd_buf_hdr->ssd_buf_flag = 0;
-		ssd_buf_hdr->ssd_buf_id = i;
-		ssd_buf_hdr->next_freessd = i + 1;
-	}
-	ssd_buffer_descriptors[NSSDBuffers - 1].next_freessd = -1;
+	ssd_buffer_descriptors = (SSDBufferDesc *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDesc));
+	initDestager();
+	initSSDBufferDesc(0);
 	//ssd_buffer_strategy_control->n_usedssd = 0;
 	hit_num = 0;
 	//miss_num = 0;
 	flush_ssd_blocks = 0;
+	ssd_write_blocks = 0;
+	ssd_write_calls = 0;
+	ssd_nand_write_bytes = 0;
+	if (BandOrBlock == 1)
+		STAGING_BUFFER_MB = 0;		// write_band() already writes a whole band at once
+	if (STAGING_BUFFER_MB > 0)
+		initStagingBuffer();
+	initAdmission();
+	if (BAND_HOTNESS)
+		initBandHotness();
 	//flush_fifo_times = 0;
 
 	//initStrategySSDBuffer(EvictStrategy);
 }
 
+/*
+ * zero filled memory for the descriptor arrays and hash tables. They are
+ * anonymous mappings, so a page is only faulted in when it is first touched,
+ * and with USE_HUGEPAGES they are backed by huge pages: hugetlbfs when the
+ * kernel has them reserved, transparent huge pages otherwise.
+ */
 void           *
-flushSSDBuffer(SSDBufferDesc * ssd_buf_hdr)
+allocSSDArray(unsigned long nmemb, unsigned long size)
+{
+	unsigned long	length = nmemb * size;
+	void	       *array = MAP_FAILED;
+
+	if (length == 0)
+		length = 1;
+	if (USE_HUGEPAGES && length >= HUGEPAGE_SIZE)
+		array = mmap(NULL, (length + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+			     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+	if (array == MAP_FAILED) {
+		array = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (array == MAP_FAILED) {
+			printf("[ERROR] allocSSDArray():-------mmap %lu bytes\n", length);
+			exit(-1);
+		}
+		if (USE_HUGEPAGES)
+			madvise(array, length, MADV_HUGEPAGE);
+	}
+	return array;
+}
+
+/*
+ * Free slots are the run [first_unusedssd, NSSDBuffers) of descriptors that
+ * were never used and are still zero, and the slots the strategies gave
+ * back. Only the head of the run is set up, the next one of the run when
+ * the head is taken.
+ */
+static void
+initSSDBufferDesc(long ssd_buf_id)
+{
+	SSDBufferDesc  *ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buf_id];
+
+	ssd_buf_hdr->ssd_buf_flag = 0;
+	ssd_buf_hdr->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr->next_freessd = -1;
+	initStrategySSDBufferDesc(ssd_buf_id, EvictStrategy);
+	initSSDBufferDescForDestage(ssd_buf_id);
+	ssd_buffer_strategy_control->n_initssd = ssd_buf_id + 1;
+}
+
+/*
+ * The slots given back are kept on NWEARBUCKETS lists by the log of their
+ * wear, 4 buckets per power of two, and first_freessd is the head of the
+ * lowest nonempty one, found through wear_bitmap, so the least worn slots
+ * are reused first. Never used slots come before any of them. Both ends are
+ * O(1). With WEAR_LEVELING off every slot goes on list 0, which is taken
+ * before the never used ones, as the single free list used to be.
+ *
+ * Only slots given back through putFreeSSDBuffer() are leveled, i.e. by
+ * LRUofBand, Most, Most_Bucket, CostBenefit and SCAN. CLOCK, LRU, ARC and
+ * 2Q reuse their victim's slot once the cache is full and take free slots
+ * only while it fills, so WEAR_LEVELING does not change them.
+ */
+static long
+wearBucket(unsigned long wear)
+{
+	int		log;
+
+	if (!WEAR_LEVELING)
+		return 0;
+	if (wear < 4)
+		return wear;
+	log = 63 - __builtin_clzl(wear);
+	return 4 * (log - 1) + ((wear >> (log - 2)) & 3);
+}
+
+static long
+lowestWearBucket()
+{
+	long		i;
+
+	for (i = 0; i < NWEARBUCKETS / 64; i++)
+		if (ssd_buffer_strategy_control->wear_bitmap[i] != 0)
+			return i * 64 + __builtin_ctzl(ssd_buffer_strategy_control->wear_bitmap[i]);
+	return -1;
+}
+
+/* the slot the next allocation takes, -1 if none is free */
+static long
+nextFreeSSDBuffer()
+{
+	SSDBufferStrategyControl *control = ssd_buffer_strategy_control;
+	long		bucket = lowestWearBucket();
+
+	if (bucket >= 0 && (!WEAR_LEVELING || control->first_unusedssd < 0))
+		return control->first_wearfreessd[bucket];
+	return control->first_unusedssd;
+}
+
+/*
+ * take ssd_buf_hdr, the head of the free list, off the list
+ */
+void
+takeFreeSSDBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferStrategyControl *control = ssd_buffer_strategy_control;
+	long		ssd_buf_id = ssd_buf_hdr->ssd_buf_id;
+	long		bucket;
+
+	if (ssd_buf_id == control->first_unusedssd) {
+		control->first_unusedssd = ssd_buf_id + 1 < NSSDBuffers ? ssd_buf_id + 1 : -1;
+		if (control->first_unusedssd >= 0)
+			initSSDBufferDesc(control->first_unusedssd);
+	} else {
+		bucket = lowestWearBucket();
+		if (bucket < 0 || control->first_wearfreessd[bucket] != ssd_buf_id) {
+			printf("[ERROR] takeFreeSSDBuffer():-------ssd_buf_id=%ld is not the head of the free list\n", ssd_buf_id);
+			exit(-1);
+		}
+		control->first_wearfreessd[bucket] = ssd_buf_hdr->next_freessd;
+		if (control->first_wearfreessd[bucket] < 0)
+			control->wear_bitmap[bucket / 64] &= ~(1UL << bucket % 64);
+	}
+	ssd_buf_hdr->next_freessd = -1;
+	control->first_freessd = nextFreeSSDBuffer();
+}
+
+/*
+ * give the slot of ssd_buf_hdr back to the free list of its wear
+ */
+void
+putFreeSSDBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferStrategyControl *control = ssd_buffer_strategy_control;
+	long		bucket = wearBucket(ssd_buf_hdr->ssd_buf_wear);
+
+	ssd_buf_hdr->next_freessd = control->first_wearfreessd[bucket];
+	control->first_wearfreessd[bucket] = ssd_buf_hdr->ssd_buf_id;
+	control->wear_bitmap[bucket / 64] |= 1UL << bucket % 64;
+	control->first_freessd = nextFreeSSDBuffer();
+}
+
+/*
+ * n adjacent slots from ssd_buf_id were written with size bytes in one
+ * call: each slot wears by its share, and the call costs the nand writes
+ * it is estimated at, see countSSDNandWrite()
+ */
+static void
+wearSSDBuffers(long ssd_buf_id, long n, unsigned long size)
+{
+	long		i;
+
+	for (i = 0; i < n; i++)
+		ssd_buffer_descriptors[ssd_buf_id + i].ssd_buf_wear += size / n / BLCKSZ;
+	countSSDNandWrite(size);
+}
+
+/*
+ * the nand writes of size bytes written to the ssd at once, estimated: a
+ * write smaller than an erase block pays the garbage collection write
+ * amplification of uniformly random writes with SSD_OVERPROVISION_PERCENT
+ * spare area, (1 + op) / (2 * op); one of whole erase blocks invalidates
+ * them whole and is written once
+ */
+void
+countSSDNandWrite(unsigned long size)
+{
+	if (size < SSD_ERASE_BLOCK_MB * 1024 * 1024 && SSD_OVERPROVISION_PERCENT > 0)
+		ssd_nand_write_bytes += size * (100 + SSD_OVERPROVISION_PERCENT) / (2 * SSD_OVERPROVISION_PERCENT);
+	else
+		ssd_nand_write_bytes += size;
+}
+
+/*
+ * days until the nand of the ssd cache has had SSD_PE_CYCLES program/erase
+ * cycles, writing nand_bytes every seconds and with the ssd leveling its
+ * wear over all of it
+ */
+double
+projectSSDLifetime(unsigned long nand_bytes, double seconds)
+{
+	double		capacity = (double) NSSDBuffers * (BandOrBlock == 1 ? BNDSZ : BLCKSZ);
+
+	if (nand_bytes == 0 || seconds <= 0)
+		return 0;
+	return capacity * SSD_PE_CYCLES / (nand_bytes / seconds) / 86400;
+}
+
+/* the endurance report: host and nand writes, slot wear and lifetime */
+void
+reportSSDWear(double seconds)
+{
+	unsigned long	slot_blocks = (BandOrBlock == 1 ? BNDSZ : BLCKSZ) / BLCKSZ;
+	unsigned long	max_wear = 0, total_wear = 0;
+	long		i;
+
+	for (i = 0; i < ssd_buffer_strategy_control->n_initssd; i++) {
+		total_wear += ssd_buffer_descriptors[i].ssd_buf_wear;
+		if (ssd_buffer_descriptors[i].ssd_buf_wear > max_wear)
+			max_wear = ssd_buffer_descriptors[i].ssd_buf_wear;
+	}
+	printf("wear_leveling:%lu host_writes(GB):%.3f nand_writes(GB):%.3f nand_wa:%.2f slot_rewrites max:%.1f mean:%.2f lifetime(days):%.2f\n",
+	       WEAR_LEVELING, ssd_write_blocks * (double) BLCKSZ / 1024 / 1024 / 1024, ssd_nand_write_bytes / 1024.0 / 1024 / 1024,
+	       ssd_write_blocks ? ssd_nand_write_bytes / ((double) ssd_write_blocks * BLCKSZ) : 0,
+	       (double) max_wear / slot_blocks, (double) total_wear / slot_blocks / NSSDBuffers,
+	       projectSSDLifetime(ssd_nand_write_bytes, seconds));
+}
+
+/*
+ * write the block (or band) cached in ssd_buf_id back to smr as ssd_buf_tag,
+ * called by flushSSDBuffer() and by the destager threads with the
+ * smrwrite_mutex of its smr drive held
+ */
+void
+writeBackSSDBuffer(long ssd_buf_id, SSDBufferTag ssd_buf_tag)
+{
+	writeBackSSDBuffers(&ssd_buf_id, &ssd_buf_tag, 1);
+}
+
+/*
+ * write back n buffers of one smr drive at once, the smrwrite_mutex of that
+ * drive held. A host-managed drive takes them zone by zone, so their offsets
+ * must ascend.
+ */
+void
+writeBackSSDBuffers(long *ssd_buf_ids, SSDBufferTag * ssd_buf_tags, long n)
 {
 	char		*ssd_buffer;
+	off_t		*offsets;
 	int		returnCode;
+	long		i;
+
 	if(BandOrBlock == 1){ 
                 SSD_BUFFER_SIZE=BNDSZ;
-		BLCKSZ = BNDSZ;
         }
 
-	returnCode = posix_memalign(&ssd_buffer,512,sizeof(char)*BLCKSZ);
-        if(returnCode < 0){
-                printf("[ERROR] flushSSDBuffer():--------posix memalign\n");
-                free(ssd_buffer);
+	returnCode = posix_memalign(&ssd_buffer,512,sizeof(char)*SSD_BUFFER_SIZE*n);
+        if(returnCode != 0){
+                printf("[ERROR] writeBackSSDBuffers():--------posix memalign\n");
                 exit(-1);
         }
-	returnCode = pread(ssd_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_id * SSD_BUFFER_SIZE);
-	if (returnCode < 0) {
-		printf("[ERROR] flushSSDBuffer():-------read from ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, ssd_buf_hdr->ssd_buf_id * SSD_BUFFER_SIZE);
-		exit(-1);
-	}
-	returnCode = smrwrite(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_tag.offset);
-	//returnCode = pwrite(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_tag.offset);
-	if (returnCode < 0) {
-		printf("[ERROR] flushSSDBuffer():-------write to smr: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, ssd_buf_hdr->ssd_buf_tag.offset);
-		exit(-1);
+	offsets = (off_t *) malloc(sizeof(off_t) * n);
+	for (i = 0; i < n; i++) {
+		offsets[i] = ssd_buf_tags[i].offset;
+		returnCode = pread(ssd_fd, ssd_buffer + i * SSD_BUFFER_SIZE, SSD_BUFFER_SIZE, ssd_buf_ids[i] * SSD_BUFFER_SIZE);
+		if (returnCode < 0) {
+			printf("[ERROR] writeBackSSDBuffers():-------read from ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, ssd_buf_ids[i] * SSD_BUFFER_SIZE);
+			exit(-1);
+		}
 	}
+	if (ZONED_SMR)
+		writeBackZoned(ssd_buffer, offsets, n, SSD_BUFFER_SIZE);
+	else
+		for (i = 0; i < n; i++) {
+			returnCode = smrwrite(ssd_buffer + i * SSD_BUFFER_SIZE, SSD_BUFFER_SIZE, offsets[i]);
+			//returnCode = pwrite(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_tag.offset);
+			if (returnCode < 0) {
+				printf("[ERROR] writeBackSSDBuffers():-------write to smr: errorcode=%d, offset=%lu\n", returnCode, offsets[i]);
+				exit(-1);
+			}
+		}
+	free(offsets);
 	free(ssd_buffer);
+}
+
+/*
+ * host-managed write back of n buffers of size bytes from buffer, at
+ * ascending offsets, one zone at a time. A zone whose write pointer is at or
+ * before the first byte written is appended to, the gap up to that byte
+ * zero filled; any other zone is read up to its write pointer, patched,
+ * reset and rewritten sequentially from its start. When ZONED_MAX_OPEN
+ * zones are open already, the least recently opened one is finished first.
+ */
+static void
+writeBackZoned(char *buffer, off_t *offsets, long n, unsigned long size)
+{
+	unsigned long	zone, zone_start, zone_end, wp, from, begin, end;
+	char	       *zone_buffer;
+	long		first = 0, i, k;
+
+	zone = GetSMRBandNumFromSSD(offsets[0]);
+	while (first < n) {
+		zone_start = GetSMRBandStartFromNum(zone);
+		zone_end = zone_start + GetSMRActualBandSizeFromSSD(zone_start);
+		for (k = first; k < n && offsets[k] < zone_end; k++);
+		begin = offsets[first] > zone_start ? offsets[first] : zone_start;
+		end = offsets[k - 1] + size < zone_end ? offsets[k - 1] + size : zone_end;
+		wp = zone_start + zone_descriptors[zone].wp;
+		from = begin >= wp ? wp : zone_start;
+		if (from < wp && end < wp)
+			end = wp;
+
+		if (posix_memalign((void **) &zone_buffer, 512, end - from) != 0) {
+			printf("[ERROR] writeBackZoned():-------alloc zone of %lu bytes\n", end - from);
+			exit(-1);
+		}
+		/* past the write pointer this reads zeros */
+		if (zoneread(smr_drives[0].smr_fd, zone_buffer, end - from, from) < 0)
+			exit(-1);
+		for (i = first; i < k; i++) {
+			begin = offsets[i] > zone_start ? offsets[i] : zone_start;
+			memcpy(zone_buffer + begin - from, buffer + i * size + begin - offsets[i],
+			       (offsets[i] + size < zone_end ? offsets[i] + size : zone_end) - begin);
+		}
+		if (from < wp)
+			zonereset(zone);
+		if (zone_descriptors[zone].cond != ZoneOpen && zone_control->nopen >= ZONED_MAX_OPEN)
+			zonefinish(zone_control->first_open);
+		if (zonewrite(smr_drives[0].smr_fd, zone_buffer, end - from, from) < 0)
+			exit(-1);
+		free(zone_buffer);
+
+		while (first < n && offsets[first] + size <= zone_end)
+			first++;
+		if (first < n)
+			zone = offsets[first] >= zone_end ? GetSMRBandNumFromSSD(offsets[first]) : zone + 1;
+	}
+}
+
+/*
+ * synchronous write back from an eviction path, ssd_buf_mutex held. A
+ * buffer a destager is writing back is left to it, and only written again
+ * if it was dirtied in the meantime.
+ */
+void           *
+flushSSDBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SMRDrive       *drive = &smr_drives[GetSMRDriveNumFromSSD(ssd_buf_hdr->ssd_buf_tag.offset)];
+
+	waitSSDBufferDestaged(ssd_buf_hdr);
+	if ((ssd_buf_hdr->ssd_buf_flag & SSD_BUF_DIRTY) == 0)
+		return NULL;
+	pthread_mutex_lock(&drive->smrwrite_mutex);
+	writeBackSSDBuffer(ssd_buf_hdr->ssd_buf_id, ssd_buf_hdr->ssd_buf_tag);
+	pthread_mutex_unlock(&drive->smrwrite_mutex);
+	markSSDBufferClean(ssd_buf_hdr);
+	sync_flush_blocks++;
 	return NULL;
 }
 
+/*
+ * may a write of nblocks to ssd_buf_tag take an ssd slot? The blocks of a
+ * miss count as admitted or bypassed, and all of them towards the hotness
+ * of their band.
+ */
+static bool
+admitSSDWrite(SSDBufferTag ssd_buf_tag, unsigned long nblocks)
+{
+	bool		found;
+
+	if (BAND_HOTNESS)
+		touchBandHotness(GetSMRBandNumFromSSD(ssd_buf_tag.offset), nblocks);
+	if (AdmissionPolicy == AdmitAll)
+		return 1;
+	found = ssdbuftableLookup(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag)) >= 0;
+	if (!admitSSDBuffer(ssd_buf_tag, found)) {
+		bypassed_blocks += nblocks;
+		return 0;
+	}
+	if (!found)
+		admitted_blocks += nblocks;
+	return 1;
+}
+
+/*
+ * a write the admission policy kept out of the cache goes straight to its
+ * smr drive, ssd_buf_mutex held; it is a miss, so no slot has an older copy
+ * and no destager is still writing one back
+ */
+static void
+writeAroundSSD(char *buffer, unsigned long size, off_t offset)
+{
+	SMRDrive       *drive = &smr_drives[GetSMRDriveNumFromSSD(offset)];
+
+	pthread_mutex_lock(&drive->smrwrite_mutex);
+	if (ZONED_SMR)
+		writeBackZoned(buffer, &offset, 1, size);
+	else if (smrwrite(buffer, size, offset) < 0) {
+		printf("[ERROR] writeAroundSSD():-------write to smr: offset=%lu\n", offset);
+		exit(-1);
+	}
+	pthread_mutex_unlock(&drive->smrwrite_mutex);
+}
+
 static SSDBufferDesc *
 SSDBufferAlloc(SSDBufferTag ssd_buf_tag, bool * found)
 {
@@ -112,13 +492,74 @@ SSDBufferAlloc(SSDBufferTag ssd_buf_tag, bool * found)
 	 * { unsigned long old_hash = ssdbuftableHashcode(&old_tag);
 	 * ssdbuftableDelete(&old_tag, old_hash); }
 	 */
+	waitSSDBufferDestaged(ssd_buf_hdr);
 	ssdbuftableInsert(&ssd_buf_tag, ssd_buf_hash, ssd_buf_hdr->ssd_buf_id);
-	ssd_buf_hdr->ssd_buf_flag &= ~(SSD_BUF_VALID | SSD_BUF_DIRTY);
+	markSSDBufferClean(ssd_buf_hdr);
+	ssd_buf_hdr->ssd_buf_flag &= ~SSD_BUF_VALID;
 	ssd_buf_hdr->ssd_buf_tag = ssd_buf_tag;
+	journalSSDBuffer(JOURNAL_INSERT, ssd_buf_hdr);
 	*found = 0;
 	return ssd_buf_hdr;
 }
 
+/*
+ * warm restart: give the restored buffers to the strategy in ssd_buf_ids
+ * order, as if SSDBufferAlloc() had allocated them. The free list is rebuilt
+ * so the strategy takes exactly these slots. The caller has already put
+ * their tags in the hash table.
+ */
+void
+rebuildSSDBuffer(long *ssd_buf_ids, long n, off_t * offsets, unsigned *flags)
+{
+	SSDBufferDesc  *ssd_buf_hdr;
+	SSDBufferTag	ssd_buf_tag;
+	bool	       *restored = (bool *) calloc(NSSDBuffers, sizeof(bool));
+	long		i, last = -1;
+
+	/* the free list is rebuilt over all descriptors, as wear bucket 0 */
+	while (ssd_buffer_strategy_control->n_initssd < NSSDBuffers)
+		initSSDBufferDesc(ssd_buffer_strategy_control->n_initssd);
+	ssd_buffer_strategy_control->first_unusedssd = -1;
+	for (i = 0; i < NWEARBUCKETS; i++)
+		ssd_buffer_strategy_control->first_wearfreessd[i] = -1;
+	memset(ssd_buffer_strategy_control->wear_bitmap, 0, sizeof(ssd_buffer_strategy_control->wear_bitmap));
+	for (i = 0; i < n; i++) {
+		restored[ssd_buf_ids[i]] = 1;
+		if (last >= 0)
+			ssd_buffer_descriptors[last].next_freessd = ssd_buf_ids[i];
+		else
+			ssd_buffer_strategy_control->first_wearfreessd[0] = ssd_buf_ids[i];
+		last = ssd_buf_ids[i];
+	}
+	for (i = 0; i < NSSDBuffers; i++) {
+		if (restored[i])
+			continue;
+		if (last >= 0)
+			ssd_buffer_descriptors[last].next_freessd = i;
+		else
+			ssd_buffer_strategy_control->first_wearfreessd[0] = i;
+		last = i;
+	}
+	ssd_buffer_descriptors[last].next_freessd = -1;
+	ssd_buffer_strategy_control->last_freessd = last;
+	ssd_buffer_strategy_control->wear_bitmap[0] = 1;
+	ssd_buffer_strategy_control->first_freessd = nextFreeSSDBuffer();
+	free(restored);
+
+	for (i = 0; i < n; i++) {
+		ssd_buf_tag.offset = offsets[ssd_buf_ids[i]];
+		ssd_buf_hdr = getSSDStrategyBuffer(ssd_buf_tag, EvictStrategy);
+		if (ssd_buf_hdr->ssd_buf_id != ssd_buf_ids[i]) {
+			printf("[ERROR] rebuildSSDBuffer():-------strategy took ssd_buf_id=%ld, expected %ld\n", ssd_buf_hdr->ssd_buf_id, ssd_buf_ids[i]);
+			exit(-1);
+		}
+		ssd_buf_hdr->ssd_buf_tag = ssd_buf_tag;
+		ssd_buf_hdr->ssd_buf_flag = SSD_BUF_VALID;
+		if (flags[ssd_buf_ids[i]] & SSD_BUF_DIRTY)
+			markSSDBufferDirty(ssd_buf_hdr);
+	}
+}
+
 static void    *
 initStrategySSDBuffer(SSDEvictionStrategy strategy)
 {
@@ -134,9 +575,42 @@ initStrategySSDBuffer(SSDEvictionStrategy strategy)
 		initSSDBufferForSCAN();
 	else if (strategy == WA)
 		initSSDBufferForWA();
+	else if (strategy == Most_Bucket)
+		initSSDBufferForMostBucket();
+	else if (strategy == ARC)
+		initSSDBufferForARC();
+	else if (strategy == TwoQ)
+		initSSDBufferFor2Q();
+	else if (strategy == CostBenefit)
+		initSSDBufferForCostBenefit();
 }
 
-static SSDBufferDesc *
+static void
+initStrategySSDBufferDesc(long ssd_buf_id, SSDEvictionStrategy strategy)
+{
+	if (strategy == CLOCK)
+		initSSDBufferDescForClock(ssd_buf_id);
+	else if (strategy == LRU)
+		initSSDBufferDescForLRU(ssd_buf_id);
+	else if (strategy == LRUofBand)
+		initSSDBufferDescForLRUofBand(ssd_buf_id);
+	else if (strategy == Most || strategy == Most_Dirty)
+		initSSDBufferDescForMost(ssd_buf_id);
+	else if (strategy == SCAN)
+		initSSDBufferDescForSCAN(ssd_buf_id);
+	else if (strategy == WA)
+		initSSDBufferDescForWA(ssd_buf_id);
+	else if (strategy == Most_Bucket)
+		initSSDBufferDescForMostBucket(ssd_buf_id);
+	else if (strategy == ARC)
+		initSSDBufferDescForARC(ssd_buf_id);
+	else if (strategy == TwoQ)
+		initSSDBufferDescFor2Q(ssd_buf_id);
+	else if (strategy == CostBenefit)
+		initSSDBufferDescForCostBenefit(ssd_buf_id);
+}
+
+SSDBufferDesc  *
 getSSDStrategyBuffer(SSDBufferTag ssd_buf_tag, SSDEvictionStrategy strategy)
 {
 	//printf("ssd_cache_usedssd : %d\n", ssd_buffer_strategy_control->n_usedssd);
@@ -153,9 +627,17 @@ getSSDStrategyBuffer(SSDBufferTag ssd_buf_tag, SSDEvictionStrategy strategy)
 		return getSCANBuffer(ssd_buf_tag);
 	else if (strategy == WA)
 		return getWABuffer(ssd_buf_tag);
+	else if (strategy == Most_Bucket)
+		return getMostBucketBuffer(ssd_buf_tag);
+	else if (strategy == ARC)
+		return getARCBuffer(ssd_buf_tag);
+	else if (strategy == TwoQ)
+		return get2QBuffer(ssd_buf_tag);
+	else if (strategy == CostBenefit)
+		return getCostBenefitBuffer(ssd_buf_tag);
 }
 
-static void    *
+void           *
 hitInSSDBuffer(SSDBufferDesc * ssd_buf_hdr, SSDEvictionStrategy strategy)
 {
 	if (strategy == CLOCK)
@@ -170,6 +652,14 @@ hitInSSDBuffer(SSDBufferDesc * ssd_buf_hdr, SSDEvictionStrategy strategy)
 		hitInSCANBuffer(ssd_buf_hdr);
 	else if (strategy == WA)
 		hitInWABuffer(ssd_buf_hdr);
+	else if (strategy == Most_Bucket)
+		hitInMostBucketBuffer();
+	else if (strategy == ARC)
+		hitInARCBuffer(ssd_buf_hdr);
+	else if (strategy == TwoQ)
+		hitIn2QBuffer(ssd_buf_hdr);
+	else if (strategy == CostBenefit)
+		hitInCostBenefitBuffer(ssd_buf_hdr);
 }
 
 /*
@@ -188,6 +678,9 @@ read_block(off_t offset, char *ssd_buffer)
 	ssd_buf_tag.offset = offset;
 	if (DEBUG)
 		printf("[INFO] read():-------offset=%lu\n", offset);
+	if (STAGING_BUFFER_MB > 0 && readStagingBlock(offset, ssd_buffer))
+		return;
+	pthread_mutex_lock(&ssd_buf_mutex);
 	ssd_buf_hdr = SSDBufferAlloc(ssd_buf_tag, &found);
 	if (found) {
 		returnCode = pread(ssd_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_id * SSD_BUFFER_SIZE);
@@ -196,7 +689,7 @@ read_block(off_t offset, char *ssd_buffer)
 			exit(-1);
 		}
 	} else {
-		returnCode = smrread(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, offset);
+		returnCode = smrread(ssd_buffer, SSD_BUFFER_SIZE, offset);
 		//returnCode = pread(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, offset);
 		if (returnCode < 0) {
 			printf("[ERROR] read():-------read from smr: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
@@ -211,6 +704,7 @@ read_block(off_t offset, char *ssd_buffer)
 	}
 	ssd_buf_hdr->ssd_buf_flag &= ~SSD_BUF_VALID;
 	ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID;
+	pthread_mutex_unlock(&ssd_buf_mutex);
 }
 
 /*
@@ -229,16 +723,371 @@ write_block(off_t offset, char *ssd_buffer)
 	ssd_buf_tag.offset = offset;
 	if (DEBUG)
 		printf("[INFO] write():-------offset=%lu\n", offset);
+	if (STAGING_BUFFER_MB > 0) {
+		writeStagingBlock(offset, ssd_buffer);
+		return;
+	}
+	pthread_mutex_lock(&ssd_buf_mutex);
+	if (!admitSSDWrite(ssd_buf_tag, 1)) {
+		writeAroundSSD(ssd_buffer, BLCKSZ, offset);
+		pthread_mutex_unlock(&ssd_buf_mutex);
+		return;
+	}
 	ssd_buf_hdr = SSDBufferAlloc(ssd_buf_tag, &found);
 	flush_ssd_blocks++;
     if (flush_ssd_blocks % 10000 == 0)
-		printf("hit num:%lu   flush_ssd_blocks:%lu flush_fifo_times:%lu flush_fifo_blocks:%lu  flusd_bands:%lu\n ", hit_num, flush_ssd_blocks, flush_fifo_times, flush_fifo_blocks, flush_bands);
+		reportProgress();
 	returnCode = pwrite(ssd_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_id * SSD_BUFFER_SIZE);
 	if (returnCode < 0) {
 		printf("[ERROR] write():-------write to ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
 		exit(-1);
 	}
-	ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID | SSD_BUF_DIRTY;
+	ssd_write_blocks++;
+	ssd_write_calls++;
+	wearSSDBuffers(ssd_buf_hdr->ssd_buf_id, 1, SSD_BUFFER_SIZE);
+	markSSDBufferDirty(ssd_buf_hdr);
+	pthread_mutex_unlock(&ssd_buf_mutex);
+}
+
+static long	batch_ssd_buf_ids[SSD_IOV_MAX];	// slot given to each block of a writeSSDBlocks() batch
+
+static int
+compareBatchSSDBufId(const void *a, const void *b)
+{
+	long		x = batch_ssd_buf_ids[*(const long *) a];
+	long		y = batch_ssd_buf_ids[*(const long *) b];
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * write n blocks, ssd_buffers[i] as offsets[i], into the ssd cache at once,
+ * called by the staging buffer with at most SSD_IOV_MAX blocks. Every block
+ * gets its slot first, then the slots are written in ssd_buf_id order with one
+ * pwritev() per run of adjacent slots.
+ *
+ * Allocating a later block may evict the slot just given to an earlier one of
+ * the same batch; that slot was still clean, so the earlier block is only
+ * allocated again in the next round. Slots are marked valid as soon as they
+ * are given out, so such an eviction also drops the earlier block's hash
+ * entry. Most_Bucket frees slots without clearing their tags, so a block is
+ * only written if the hash table still maps it to its slot. A round that
+ * writes nothing, as when Most_Bucket keeps evicting the band being written,
+ * is followed by rounds of one block each. Blocks the admission policy
+ * rejects are written around the cache before the first round.
+ */
+void
+writeSSDBlocks(off_t *offsets, char **ssd_buffers, long n)
+{
+	static long	pending[SSD_IOV_MAX];
+	static long	order[SSD_IOV_MAX];
+	static struct iovec iov[SSD_IOV_MAX];
+	SSDBufferTag	ssd_buf_tag;
+	SSDBufferDesc  *ssd_buf_hdr;
+	bool		found;
+	long		npending, nalloc, nwrite, i, k;
+	ssize_t		returnCode;
+
+	if (n > SSD_IOV_MAX) {
+		printf("[ERROR] writeSSDBlocks():-------%ld blocks exceed SSD_IOV_MAX\n", n);
+		exit(-1);
+	}
+	pthread_mutex_lock(&ssd_buf_mutex);
+	for (i = 0, npending = 0; i < n; i++) {
+		ssd_buf_tag.offset = offsets[i];
+		if (admitSSDWrite(ssd_buf_tag, 1))
+			pending[npending++] = i;
+		else
+			writeAroundSSD(ssd_buffers[i], BLCKSZ, offsets[i]);
+	}
+	nalloc = npending;
+
+	while (npending > 0) {
+		if (nalloc > npending)
+			nalloc = npending;
+		for (i = 0; i < nalloc; i++) {
+			ssd_buf_tag.offset = offsets[pending[i]];
+			ssd_buf_hdr = SSDBufferAlloc(ssd_buf_tag, &found);
+			ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID;
+			batch_ssd_buf_ids[pending[i]] = ssd_buf_hdr->ssd_buf_id;
+			flush_ssd_blocks++;
+			if (flush_ssd_blocks % 10000 == 0)
+				reportProgress();
+		}
+		nwrite = 0;
+		for (i = 0, k = 0; i < nalloc; i++) {
+			ssd_buf_tag.offset = offsets[pending[i]];
+			if (ssdbuftableLookup(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag)) == batch_ssd_buf_ids[pending[i]])
+				order[nwrite++] = pending[i];
+			else
+				pending[k++] = pending[i];
+		}
+		for (; i < npending; i++)
+			pending[k++] = pending[i];
+		npending = k;
+		if (nwrite == 0)
+			nalloc = 1;
+		qsort(order, nwrite, sizeof(long), compareBatchSSDBufId);
+
+		for (i = 0; i < nwrite; i = k) {
+			for (k = i; k < nwrite && batch_ssd_buf_ids[order[k]] == batch_ssd_buf_ids[order[i]] + (k - i); k++) {
+				iov[k - i].iov_base = ssd_buffers[order[k]];
+				iov[k - i].iov_len = SSD_BUFFER_SIZE;
+			}
+			returnCode = pwritev(ssd_fd, iov, k - i, batch_ssd_buf_ids[order[i]] * SSD_BUFFER_SIZE);
+			if (returnCode < 0) {
+				printf("[ERROR] writeSSDBlocks():-------write to ssd: fd=%d, errorcode=%ld, ssd_buf_id=%ld\n", ssd_fd, (long) returnCode, batch_ssd_buf_ids[order[i]]);
+				exit(-1);
+			}
+			ssd_write_calls++;
+			ssd_write_blocks += k - i;
+			wearSSDBuffers(batch_ssd_buf_ids[order[i]], k - i, (k - i) * SSD_BUFFER_SIZE);
+			for (; i < k; i++)
+				markSSDBufferDirty(&ssd_buffer_descriptors[batch_ssd_buf_ids[order[i]]]);
+		}
+	}
+	pthread_mutex_unlock(&ssd_buf_mutex);
+}
+
+/* the progress line, every 10000 blocks written to the ssd cache */
+static void
+reportProgress()
+{
+	collectSMRDriveStats();
+	printf("hit num:%lu   flush_ssd_blocks:%lu flush_fifo_times:%lu flush_fifo_blocks:%lu  flusd_bands:%lu\n ", hit_num, flush_ssd_blocks, flush_fifo_times, flush_fifo_blocks, flush_bands);
+}
+
+/* flush_ssd_blocks += n, with the progress line every 10000 blocks */
+static void
+countSSDBlocks(long n)
+{
+	flush_ssd_blocks += n;
+	if (flush_ssd_blocks / 10000 != (flush_ssd_blocks - n) / 10000)
+		reportProgress();
+}
+
+/*
+ * read or write the part of the band at band_tag that [offset, offset + size)
+ * covers, in one SSDBufferAlloc() and one ssd call. A missing band is read
+ * from smr into band_buffer and written to its slot whole. The other blocks
+ * of the part count as hits, as they did one block at a time. A write the
+ * admission policy rejects goes to smr instead.
+ */
+static void
+accessBandExtent(off_t offset, unsigned long size, char *buffer, char *band_buffer, bool is_write)
+{
+	SSDBufferTag	band_tag;
+	SSDBufferDesc  *ssd_buf_hdr;
+	bool		found;
+	ssize_t		returnCode;
+	unsigned long	offset_in_band;
+
+	band_tag.offset = offset / BNDSZ * BNDSZ;
+	offset_in_band = offset - band_tag.offset;
+	if (is_write && !admitSSDWrite(band_tag, size / BLCKSZ)) {
+		writeAroundSSD(buffer, size, offset);
+		return;
+	}
+	ssd_buf_hdr = SSDBufferAlloc(band_tag, &found);
+	hit_num += size / BLCKSZ - 1;
+	if (found) {
+		if (is_write)
+			returnCode = pwrite(ssd_fd, buffer, size, ssd_buf_hdr->ssd_buf_id * BNDSZ + offset_in_band);
+		else
+			returnCode = pread(ssd_fd, buffer, size, ssd_buf_hdr->ssd_buf_id * BNDSZ + offset_in_band);
+		if (returnCode < 0) {
+			printf("[ERROR] accessBandExtent():-------ssd: fd=%d, errorcode=%ld, offset=%lu\n", ssd_fd, (long) returnCode, offset);
+			exit(-1);
+		}
+		if (is_write) {
+			ssd_write_blocks += size / BLCKSZ;
+			ssd_write_calls++;
+			wearSSDBuffers(ssd_buf_hdr->ssd_buf_id, 1, size);
+		}
+	} else {
+		if (smrread(band_buffer, BNDSZ, band_tag.offset) < 0) {
+			printf("[ERROR] accessBandExtent():-------read from smr: offset=%lu\n", band_tag.offset);
+			exit(-1);
+		}
+		if (is_write)
+			memcpy(band_buffer + offset_in_band, buffer, size);
+		else
+			memcpy(buffer, band_buffer + offset_in_band, size);
+		returnCode = pwrite(ssd_fd, band_buffer, BNDSZ, ssd_buf_hdr->ssd_buf_id * BNDSZ);
+		if (returnCode < 0) {
+			printf("[ERROR] accessBandExtent():-------write to ssd: fd=%d, errorcode=%ld, offset=%lu\n", ssd_fd, (long) returnCode, offset);
+			exit(-1);
+		}
+		ssd_write_blocks += BNDSZ / BLCKSZ;
+		ssd_write_calls++;
+		wearSSDBuffers(ssd_buf_hdr->ssd_buf_id, 1, BNDSZ);
+	}
+	if (is_write) {
+		countSSDBlocks(size / BLCKSZ);
+		markSSDBufferDirty(ssd_buf_hdr);
+	} else {
+		if (!found)
+			countSSDBlocks(1);
+		ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID;
+	}
+}
+
+/* band mode read_extent() and write_extent(), band by band */
+static void
+accessBandExtents(off_t offset, unsigned long size, char *buffer, bool is_write)
+{
+	char	       *band_buffer;
+	unsigned long	part;
+
+	SSD_BUFFER_SIZE = BNDSZ;
+	if (posix_memalign((void **) &band_buffer, 512, BNDSZ) != 0) {
+		printf("[ERROR] accessBandExtents():-------posix_memalign\n");
+		exit(-1);
+	}
+	pthread_mutex_lock(&ssd_buf_mutex);
+	for (; size > 0; offset += part, buffer += part, size -= part) {
+		part = offset / BNDSZ * BNDSZ + BNDSZ - offset;
+		if (part > size)
+			part = size;
+		accessBandExtent(offset, part, buffer, band_buffer, is_write);
+	}
+	pthread_mutex_unlock(&ssd_buf_mutex);
+	free(band_buffer);
+}
+
+/*
+ * write_extent--write size bytes of buffer at offset, both multiples of
+ * BLCKSZ. Blocks go to writeSSDBlocks() SSD_IOV_MAX at a time, which looks
+ * every block up in one pass and writes runs of adjacent slots with one
+ * pwritev(); with the staging buffer on they are staged one by one. In band
+ * mode every band the extent covers is looked up and written once.
+ */
+void
+write_extent(off_t offset, unsigned long size, char *buffer)
+{
+	off_t		offsets[SSD_IOV_MAX];
+	char	       *buffers[SSD_IOV_MAX];
+	long		nblocks = size / BLCKSZ, n, i;
+
+	if (BandOrBlock == 1) {
+		accessBandExtents(offset, size, buffer, 1);
+		return;
+	}
+	if (STAGING_BUFFER_MB > 0) {
+		for (i = 0; i < nblocks; i++)
+			writeStagingBlock(offset + i * BLCKSZ, buffer + i * BLCKSZ);
+		return;
+	}
+	for (; nblocks > 0; nblocks -= n, offset += n * BLCKSZ, buffer += n * BLCKSZ) {
+		n = nblocks < SSD_IOV_MAX ? nblocks : SSD_IOV_MAX;
+		for (i = 0; i < n; i++) {
+			offsets[i] = offset + i * BLCKSZ;
+			buffers[i] = buffer + i * BLCKSZ;
+		}
+		writeSSDBlocks(offsets, buffers, n);
+	}
+}
+
+/*
+ * at most SSD_IOV_MAX blocks of read_extent(), staged blocks already copied
+ * (staged[i] set). Every other block gets its slot first; hits are read in
+ * slot order with one preadv() per run of adjacent slots, before any slot is
+ * written. Misses are read from smr one run of adjacent offsets at a time and
+ * then written to their slots, in slot order, by pwritev(). A block whose
+ * slot a later block of the same batch evicted is not written. Staged blocks
+ * count as hits.
+ */
+static void
+readSSDBlocks(off_t offset, long n, char *buffer, bool *staged)
+{
+	long		hits[SSD_IOV_MAX], misses[SSD_IOV_MAX];
+	struct iovec	iov[SSD_IOV_MAX];
+	SSDBufferTag	ssd_buf_tag;
+	SSDBufferDesc  *ssd_buf_hdr;
+	bool		found;
+	long		nhits = 0, nmisses = 0, nwrite, i, k;
+	ssize_t		returnCode;
+
+	pthread_mutex_lock(&ssd_buf_mutex);
+	for (i = 0; i < n; i++) {
+		if (staged[i]) {
+			hit_num++;
+			continue;
+		}
+		ssd_buf_tag.offset = offset + i * BLCKSZ;
+		ssd_buf_hdr = SSDBufferAlloc(ssd_buf_tag, &found);
+		ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID;
+		batch_ssd_buf_ids[i] = ssd_buf_hdr->ssd_buf_id;
+		if (found)
+			hits[nhits++] = i;
+		else
+			misses[nmisses++] = i;
+	}
+
+	qsort(hits, nhits, sizeof(long), compareBatchSSDBufId);
+	for (i = 0; i < nhits; i = k) {
+		for (k = i; k < nhits && batch_ssd_buf_ids[hits[k]] == batch_ssd_buf_ids[hits[i]] + (k - i); k++) {
+			iov[k - i].iov_base = buffer + hits[k] * BLCKSZ;
+			iov[k - i].iov_len = BLCKSZ;
+		}
+		returnCode = preadv(ssd_fd, iov, k - i, batch_ssd_buf_ids[hits[i]] * BLCKSZ);
+		if (returnCode < 0) {
+			printf("[ERROR] readSSDBlocks():-------read from ssd: fd=%d, errorcode=%ld, ssd_buf_id=%ld\n", ssd_fd, (long) returnCode, batch_ssd_buf_ids[hits[i]]);
+			exit(-1);
+		}
+	}
+
+	for (i = 0; i < nmisses; i = k) {
+		for (k = i + 1; k < nmisses && misses[k] == misses[i] + (k - i); k++);
+		if (smrread(buffer + misses[i] * BLCKSZ, (k - i) * BLCKSZ, offset + misses[i] * BLCKSZ) < 0) {
+			printf("[ERROR] readSSDBlocks():-------read from smr: offset=%lu\n", offset + misses[i] * BLCKSZ);
+			exit(-1);
+		}
+	}
+	countSSDBlocks(nmisses);
+	for (i = 0, nwrite = 0; i < nmisses; i++) {
+		ssd_buf_tag.offset = offset + misses[i] * BLCKSZ;
+		if (ssdbuftableLookup(&ssd_buf_tag, ssdbuftableHashcode(&ssd_buf_tag)) == batch_ssd_buf_ids[misses[i]])
+			misses[nwrite++] = misses[i];
+	}
+	qsort(misses, nwrite, sizeof(long), compareBatchSSDBufId);
+	for (i = 0; i < nwrite; i = k) {
+		for (k = i; k < nwrite && batch_ssd_buf_ids[misses[k]] == batch_ssd_buf_ids[misses[i]] + (k - i); k++) {
+			iov[k - i].iov_base = buffer + misses[k] * BLCKSZ;
+			iov[k - i].iov_len = BLCKSZ;
+		}
+		returnCode = pwritev(ssd_fd, iov, k - i, batch_ssd_buf_ids[misses[i]] * BLCKSZ);
+		if (returnCode < 0) {
+			printf("[ERROR] readSSDBlocks():-------write to ssd: fd=%d, errorcode=%ld, ssd_buf_id=%ld\n", ssd_fd, (long) returnCode, batch_ssd_buf_ids[misses[i]]);
+			exit(-1);
+		}
+		ssd_write_blocks += k - i;
+		ssd_write_calls++;
+		wearSSDBuffers(batch_ssd_buf_ids[misses[i]], k - i, (k - i) * BLCKSZ);
+	}
+	pthread_mutex_unlock(&ssd_buf_mutex);
+}
+
+/*
+ * read_extent--read size bytes at offset into buffer, both multiples of
+ * BLCKSZ, the counterpart of write_extent()
+ */
+void
+read_extent(off_t offset, unsigned long size, char *buffer)
+{
+	bool		staged[SSD_IOV_MAX];
+	long		nblocks = size / BLCKSZ, n, i;
+
+	if (BandOrBlock == 1) {
+		accessBandExtents(offset, size, buffer, 0);
+		return;
+	}
+	for (; nblocks > 0; nblocks -= n, offset += n * BLCKSZ, buffer += n * BLCKSZ) {
+		n = nblocks < SSD_IOV_MAX ? nblocks : SSD_IOV_MAX;
+		for (i = 0; i < n; i++)
+			staged[i] = STAGING_BUFFER_MB > 0 && readStagingBlock(offset + i * BLCKSZ, buffer + i * BLCKSZ);
+		readSSDBlocks(offset, n, buffer, staged);
+	}
 }
 void 
 read_band(off_t offset, char *ssd_buffer)
@@ -272,6 +1121,7 @@ read_band(off_t offset, char *ssd_buffer)
 	printf("readband_tag%ld\n", band_tag.offset);
 	if (DEBUG)
 		printf("[INFO] read():-------offset=%lu\n", offset);
+	pthread_mutex_lock(&ssd_buf_mutex);
 	ssd_buf_hdr = SSDBufferAlloc(hdr_tag, &found);
 	if (found) {
 		returnCode = pread(ssd_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_id * SSD_BUFFER_SIZE + new_offset);
@@ -280,7 +1130,7 @@ read_band(off_t offset, char *ssd_buffer)
 			exit(-1);
 		}
 	} else {
-		returnCode = smrread(smr_fd, band_buffer, BNDSZ, hdr_tag.offset);
+		returnCode = smrread(band_buffer, BNDSZ, hdr_tag.offset);
 		//returnCode = pread(smr_fd, ssd_buffer, SSD_BUFFER_SIZE, offset);
 		if (returnCode < 0) {
 			printf("[ERROR] read():-------read from smr: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
@@ -298,9 +1148,11 @@ read_band(off_t offset, char *ssd_buffer)
 			printf("[ERROR] read():-------write to ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
 			exit(-1);
 		}
+		wearSSDBuffers(ssd_buf_hdr->ssd_buf_id, 1, BNDSZ);
 	}
 	ssd_buf_hdr->ssd_buf_flag &= ~SSD_BUF_VALID;
 	ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID;
+	pthread_mutex_unlock(&ssd_buf_mutex);
 }
 void 
 write_band(off_t offset, char *ssd_buffer)
@@ -331,21 +1183,38 @@ write_band(off_t offset, char *ssd_buffer)
                 printf("[ERROR] write_band():-------posix_memalign\n");
                 exit(-1);
         }
+	pthread_mutex_lock(&ssd_buf_mutex);
+	if (!admitSSDWrite(hdr_tag, 1)) {
+		writeAroundSSD(ssd_buffer, BLCKSZ, offset);
+		pthread_mutex_unlock(&ssd_buf_mutex);
+		free(band_buffer);
+		return;
+	}
 	ssd_buf_hdr = SSDBufferAlloc(hdr_tag, &found);
 	flush_ssd_blocks++;
 	if (flush_ssd_blocks % 10000 == 0)
-		printf("hit num:%lu   flush_ssd_blocks:%lu flush_fifo_times:%lu flush_fifo_blocks:%lu  flusd_bands:%lu\n ", hit_num, flush_ssd_blocks, flush_fifo_times, flush_fifo_blocks, flush_bands);
+		reportProgress();
 	if (found) {
-		returnCode = pwrite(ssd_fd, ssd_buffer, SSD_BUFFER_SIZE, ssd_buf_hdr->ssd_buf_id * BNDSZ + new_offset);
+		returnCode = pwrite(ssd_fd, ssd_buffer, BLCKSZ, ssd_buf_hdr->ssd_buf_id * BNDSZ + new_offset);
 	} else {
-		returnCode = smrread(smr_fd, band_buffer, BNDSZ, hdr_tag.offset);
+		returnCode = smrread(band_buffer, BNDSZ, hdr_tag.offset);
 
 		if (returnCode < 0) {
 			printf("[ERROR] write():-------write to ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
 			exit(-1);
 		}
 		memcpy(band_buffer + new_offset, ssd_buffer, BLCKSZ);
+		returnCode = pwrite(ssd_fd, band_buffer, BNDSZ, ssd_buf_hdr->ssd_buf_id * BNDSZ);
+	}
+	if (returnCode < 0) {
+		printf("[ERROR] write_band():-------write to ssd: fd=%d, errorcode=%d, offset=%lu\n", ssd_fd, returnCode, offset);
+		exit(-1);
 	}
-	ssd_buf_hdr->ssd_buf_flag |= SSD_BUF_VALID | SSD_BUF_DIRTY;
+	ssd_write_blocks += found ? 1 : BNDSZ / BLCKSZ;
+	ssd_write_calls++;
+	wearSSDBuffers(ssd_buf_hdr->ssd_buf_id, 1, found ? BLCKSZ : BNDSZ);
+	markSSDBufferDirty(ssd_buf_hdr);
+	pthread_mutex_unlock(&ssd_buf_mutex);
+	free(band_buffer);
 
 }
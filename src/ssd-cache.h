@@ -17,10 +17,13 @@ typedef struct
 	long 		ssd_buf_id;				// ssd buffer location in shared buffer
 	unsigned 	ssd_buf_flag;
 	long		next_freessd;           // to link free ssd
+	unsigned long	ssd_buf_wear;			// BLCKSZ units ever written to the slot
 } SSDBufferDesc;
 
 #define SSD_BUF_VALID 0x01
 #define SSD_BUF_DIRTY 0x02
+#define SSD_BUF_DESTAGING 0x04		// being written back by a destager thread, still dirty until it is done
+#define SSD_BUF_REDIRTIED 0x08		// dirtied again while being destaged, stays dirty after
 
 typedef struct SSDBufferHashBucket
 {
@@ -29,11 +32,17 @@ typedef struct SSDBufferHashBucket
 	struct SSDBufferHashBucket 	*next_item;
 } SSDBufferHashBucket;
 
+#define NWEARBUCKETS 256				// free lists by slot wear, 4 per power of two
+
 typedef struct
 {
 	long		n_usedssd;			// For eviction
-	long		first_freessd;		// Head of list of free ssds
+	long		first_freessd;		// Head of list of free ssds, the one taken next
 	long		last_freessd;		// Tail of list of free ssds
+	long		n_initssd;			// descriptors [0, n_initssd) have been set up, the rest are still zero
+	long		first_unusedssd;	// never used slot taken next, -1 once all have been used
+	long		first_wearfreessd[NWEARBUCKETS];	// free slots of each wear bucket, -1 if none
+	unsigned long	wear_bitmap[NWEARBUCKETS / 64];	// wear buckets with a free slot
 } SSDBufferStrategyControl;
 
 typedef enum
@@ -44,7 +53,11 @@ typedef enum
 	Most,
 	Most_Dirty,	
 	SCAN,
-    WA
+    WA,
+	Most_Bucket,
+	ARC,
+	TwoQ,
+	CostBenefit
 } SSDEvictionStrategy;
 
 extern size_t BNDSZ;
@@ -54,25 +67,50 @@ extern SSDBufferHashBucket	*ssd_buffer_hashtable;
 extern SSDBufferStrategyControl *ssd_buffer_strategy_control;
 extern unsigned long hit_num;
 extern unsigned long flush_ssd_blocks;
+extern unsigned long ssd_write_blocks;		// BLCKSZ units written to the ssd cache
+extern unsigned long ssd_write_calls;
+extern unsigned long ssd_nand_write_bytes;	// estimated, see countSSDNandWrite()
 //extern unsigned long write-ssd-num;
 //extern unsigned long flush_fifo_times;
 
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+#define SSD_IOV_MAX 1024				// most blocks in one writeSSDBlocks() or readSSDBlocks() batch
+
 #define GetSSDBufHashBucket(hash_code) ((SSDBufferHashBucket *) (ssd_buffer_hashtable + (unsigned) (hash_code)))
 
 extern void initSSDBuffer();
 extern void read_block(off_t offset, char* ssd_buffer);
 extern void write_block(off_t offset, char* ssd_buffer);
+extern void writeSSDBlocks(off_t *offsets, char **ssd_buffers, long n);
+extern void read_extent(off_t offset, unsigned long size, char *buffer);
+extern void write_extent(off_t offset, unsigned long size, char *buffer);
 extern void read_band(off_t offset, char* ssd_buffer);
 extern void write_band(off_t offset, char* ssd_buffer);
 
 //extern int read(unsigned offset);
 //extern int write(unsigned offset);
 extern void* flushSSDBuffer(SSDBufferDesc *ssd_buf_hdr);
+extern void writeBackSSDBuffer(long ssd_buf_id, SSDBufferTag ssd_buf_tag);
+extern void writeBackSSDBuffers(long *ssd_buf_ids, SSDBufferTag *ssd_buf_tags, long n);
+extern void takeFreeSSDBuffer(SSDBufferDesc *ssd_buf_hdr);
+extern void putFreeSSDBuffer(SSDBufferDesc *ssd_buf_hdr);
+extern void countSSDNandWrite(unsigned long size);
+extern double projectSSDLifetime(unsigned long nand_bytes, double seconds);
+extern void reportSSDWear(double seconds);
+extern SSDBufferDesc *getSSDStrategyBuffer(SSDBufferTag ssd_buf_tag, SSDEvictionStrategy strategy);
+extern void *hitInSSDBuffer(SSDBufferDesc *ssd_buf_hdr, SSDEvictionStrategy strategy);
+extern void *allocSSDArray(unsigned long nmemb, unsigned long size);
+extern void rebuildSSDBuffer(long *ssd_buf_ids, long n, off_t *offsets, unsigned *flags);
 
 extern unsigned long NSSDBuffers;
 extern unsigned long NSSDBufTables;
+extern unsigned long USE_HUGEPAGES;
+extern unsigned long WEAR_LEVELING;
+extern unsigned long SSD_ERASE_BLOCK_MB;
+extern unsigned long SSD_OVERPROVISION_PERCENT;
+extern unsigned long SSD_PE_CYCLES;
 extern size_t SSD_BUFFER_SIZE;
 extern char	smr_device[100];
-extern int 	smr_fd;
 extern int 	ssd_fd;
 extern SSDEvictionStrategy EvictStrategy;
+extern pthread_mutex_t ssd_buf_mutex;
@@ -5,16 +5,13 @@
 
 static bool isSamebuf(SSDBufferTag *, SSDBufferTag *);
 
+/*
+ * The buckets in the table are list heads only, entries hang off next_item,
+ * so an all-zero table is empty and is not touched here.
+ */
 void initSSDBufTable(size_t size)
 {
-	ssd_buffer_hashtable = (SSDBufferHashBucket *)malloc(sizeof(SSDBufferHashBucket)*size);
-	size_t i;
-	SSDBufferHashBucket *ssd_buf_hash = ssd_buffer_hashtable;
-	for (i = 0; i < size; ssd_buf_hash++, i++){
-		ssd_buf_hash->ssd_buf_id = -1;
-		ssd_buf_hash->hash_key.offset = -1;
-		ssd_buf_hash->next_item = NULL;
-	}
+	ssd_buffer_hashtable = (SSDBufferHashBucket *)allocSSDArray(size, sizeof(SSDBufferHashBucket));
 }
 
 unsigned long ssdbuftableHashcode(SSDBufferTag *ssd_buf_tag)
@@ -30,7 +27,7 @@ size_t ssdbuftableLookup(SSDBufferTag *ssd_buf_tag, unsigned long hash_code)
 {
 	if (DEBUG)
 		printf("[INFO] Lookup ssd_buf_tag: %lu\n",ssd_buf_tag->offset);
-	SSDBufferHashBucket *nowbucket = GetSSDBufHashBucket(hash_code);
+	SSDBufferHashBucket *nowbucket = GetSSDBufHashBucket(hash_code)->next_item;
 	while (nowbucket != NULL) {
 		if (isSamebuf(&nowbucket->hash_key, ssd_buf_tag)) {
 			return nowbucket->ssd_buf_id;
@@ -46,9 +43,9 @@ long ssdbuftableInsert(SSDBufferTag *ssd_buf_tag, unsigned long hash_code, long
 	if (DEBUG)
 		printf("[INFO] Insert buf_tag: %lu\n",ssd_buf_tag->offset);
 	SSDBufferHashBucket *nowbucket = GetSSDBufHashBucket(hash_code);
-	while (nowbucket->next_item != NULL && nowbucket != NULL) {
-		if (isSamebuf(&nowbucket->hash_key, ssd_buf_tag)) {
-			return nowbucket->ssd_buf_id;
+	while (nowbucket->next_item != NULL) {
+		if (isSamebuf(&nowbucket->next_item->hash_key, ssd_buf_tag)) {
+			return nowbucket->next_item->ssd_buf_id;
 		}
 		nowbucket = nowbucket->next_item;
 	}
@@ -73,9 +70,8 @@ long ssdbuftableDelete(SSDBufferTag *ssd_buf_tag, unsigned long hash_code)
 	if (DEBUG)
 		printf("[INFO] Delete buf_tag: %lu\n",ssd_buf_tag->offset);
 	SSDBufferHashBucket *nowbucket = GetSSDBufHashBucket(hash_code);
-	long del_id;
+	long del_id = -1;
 	SSDBufferHashBucket *delitem;
-	nowbucket->next_item;
 	while (nowbucket->next_item != NULL && nowbucket != NULL) {
 		if (isSamebuf(&nowbucket->next_item->hash_key, ssd_buf_tag)) {
 			del_id = nowbucket->next_item->ssd_buf_id;
@@ -83,10 +79,6 @@ long ssdbuftableDelete(SSDBufferTag *ssd_buf_tag, unsigned long hash_code)
 		}
 		nowbucket = nowbucket->next_item;
 	}
-	//printf("not found2\n");
-	if (isSamebuf(&nowbucket->hash_key, ssd_buf_tag)) {
-		del_id = nowbucket->ssd_buf_id;
-	}
 	//printf("not found3\n");
 	if (nowbucket->next_item != NULL) {
 		delitem = nowbucket->next_item;
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "staging.h"
+
+static long	nstaging;			// blocks that fit in STAGING_BUFFER_MB
+static off_t   *batch_offsets;
+static char   **batch_buffers;
+
+static long	stagingLookup(off_t offset);
+static volatile void addToStagingHead(long staging_id);
+static volatile void deleteFromStaging(long staging_id);
+static volatile void destageStagingBatch(long nbatch);
+
+/*
+ * A bounded DRAM tier in front of write_block(). Blocks are kept here until
+ * the buffer is full; a rewrite of a staged block only replaces its data, and
+ * reads of a staged block are served from memory. When the buffer is full the
+ * STAGING_BATCH_BLOCKS least recently written blocks go to the ssd cache in
+ * one writeSSDBlocks() call, which writes them in ssd slot order.
+ *
+ * Staged blocks are not in the checkpoint or the journal, so they are lost on
+ * a crash; flushStagingBuffer() must run before checkpointSSDBuffer().
+ */
+void
+initStagingBuffer()
+{
+	long		i;
+
+	nstaging = STAGING_BUFFER_MB * 1024 * 1024 / BLCKSZ;
+	if (nstaging < 1) {
+		printf("[ERROR] initStagingBuffer():-------STAGING_BUFFER_MB=%lu holds no block\n", STAGING_BUFFER_MB);
+		exit(-1);
+	}
+	if (STAGING_BATCH_BLOCKS > nstaging)
+		STAGING_BATCH_BLOCKS = nstaging;
+	if (STAGING_BATCH_BLOCKS > SSD_IOV_MAX)
+		STAGING_BATCH_BLOCKS = SSD_IOV_MAX;
+	if (STAGING_BATCH_BLOCKS < 1)
+		STAGING_BATCH_BLOCKS = 1;
+
+	staging_buffer_strategy_control = (StagingBufferStrategyControl *) malloc(sizeof(StagingBufferStrategyControl));
+	staging_buffer_strategy_control->n_usedstaging = 0;
+	staging_buffer_strategy_control->first_freestaging = 0;
+	staging_buffer_strategy_control->first_lru = -1;
+	staging_buffer_strategy_control->last_lru = -1;
+
+	staging_buffer_descriptors = (StagingBufferDesc *) malloc(sizeof(StagingBufferDesc) * nstaging);
+	staging_hashtable = (long *) malloc(sizeof(long) * nstaging);
+	for (i = 0; i < nstaging; i++) {
+		staging_buffer_descriptors[i].staging_id = i;
+		staging_buffer_descriptors[i].next_hash = -1;
+		staging_buffer_descriptors[i].next_lru = -1;
+		staging_buffer_descriptors[i].last_lru = -1;
+		staging_buffer_descriptors[i].next_freestaging = i + 1;
+		staging_hashtable[i] = -1;
+	}
+	staging_buffer_descriptors[nstaging - 1].next_freestaging = -1;
+
+	if (posix_memalign((void **) &staging_blocks, 512, nstaging * BLCKSZ) != 0) {
+		printf("[ERROR] initStagingBuffer():-------posix_memalign %lu blocks\n", nstaging);
+		exit(-1);
+	}
+	batch_offsets = (off_t *) malloc(sizeof(off_t) * STAGING_BATCH_BLOCKS);
+	batch_buffers = (char **) malloc(sizeof(char *) * STAGING_BATCH_BLOCKS);
+	pthread_mutex_init(&staging_mutex, NULL);
+	staging_write_blocks = 0;
+	staging_coalesced_blocks = 0;
+	staging_read_hits = 0;
+}
+
+static long
+stagingLookup(off_t offset)
+{
+	long		staging_id = staging_hashtable[offset / BLCKSZ % nstaging];
+
+	while (staging_id >= 0 && staging_buffer_descriptors[staging_id].staging_tag.offset != offset)
+		staging_id = staging_buffer_descriptors[staging_id].next_hash;
+	return staging_id;
+}
+
+static volatile void
+addToStagingHead(long staging_id)
+{
+	StagingBufferDesc *staging_hdr = &staging_buffer_descriptors[staging_id];
+
+	staging_hdr->last_lru = -1;
+	staging_hdr->next_lru = staging_buffer_strategy_control->first_lru;
+	if (staging_buffer_strategy_control->first_lru >= 0)
+		staging_buffer_descriptors[staging_buffer_strategy_control->first_lru].last_lru = staging_id;
+	else
+		staging_buffer_strategy_control->last_lru = staging_id;
+	staging_buffer_strategy_control->first_lru = staging_id;
+}
+
+static volatile void
+deleteFromStaging(long staging_id)
+{
+	StagingBufferDesc *staging_hdr = &staging_buffer_descriptors[staging_id];
+
+	if (staging_hdr->last_lru >= 0)
+		staging_buffer_descriptors[staging_hdr->last_lru].next_lru = staging_hdr->next_lru;
+	else
+		staging_buffer_strategy_control->first_lru = staging_hdr->next_lru;
+	if (staging_hdr->next_lru >= 0)
+		staging_buffer_descriptors[staging_hdr->next_lru].last_lru = staging_hdr->last_lru;
+	else
+		staging_buffer_strategy_control->last_lru = staging_hdr->last_lru;
+	staging_hdr->next_lru = -1;
+	staging_hdr->last_lru = -1;
+}
+
+/*
+ * write the nbatch least recently written blocks to the ssd cache and free
+ * their staging blocks, staging_mutex held
+ */
+static volatile void
+destageStagingBatch(long nbatch)
+{
+	StagingBufferDesc *staging_hdr;
+	long		staging_id, n = 0;
+	long	       *bucket;
+
+	for (staging_id = staging_buffer_strategy_control->last_lru; staging_id >= 0 && n < nbatch; staging_id = staging_buffer_descriptors[staging_id].last_lru) {
+		batch_offsets[n] = staging_buffer_descriptors[staging_id].staging_tag.offset;
+		batch_buffers[n] = staging_blocks + staging_id * BLCKSZ;
+		n++;
+	}
+	if (n == 0)
+		return;
+	writeSSDBlocks(batch_offsets, batch_buffers, n);
+
+	while (n-- > 0) {
+		staging_id = staging_buffer_strategy_control->last_lru;
+		staging_hdr = &staging_buffer_descriptors[staging_id];
+		deleteFromStaging(staging_id);
+		for (bucket = &staging_hashtable[staging_hdr->staging_tag.offset / BLCKSZ % nstaging]; *bucket != staging_id; bucket = &staging_buffer_descriptors[*bucket].next_hash);
+		*bucket = staging_hdr->next_hash;
+		staging_hdr->next_hash = -1;
+		staging_hdr->next_freestaging = staging_buffer_strategy_control->first_freestaging;
+		staging_buffer_strategy_control->first_freestaging = staging_id;
+		staging_buffer_strategy_control->n_usedstaging--;
+	}
+}
+
+bool
+readStagingBlock(off_t offset, char *ssd_buffer)
+{
+	long		staging_id;
+
+	pthread_mutex_lock(&staging_mutex);
+	staging_id = stagingLookup(offset);
+	if (staging_id >= 0) {
+		memcpy(ssd_buffer, staging_blocks + staging_id * BLCKSZ, BLCKSZ);
+		staging_read_hits++;
+	}
+	pthread_mutex_unlock(&staging_mutex);
+	return staging_id >= 0;
+}
+
+void
+writeStagingBlock(off_t offset, char *ssd_buffer)
+{
+	StagingBufferDesc *staging_hdr;
+	long		staging_id;
+	unsigned long	staging_hash = offset / BLCKSZ % nstaging;
+
+	pthread_mutex_lock(&staging_mutex);
+	staging_write_blocks++;
+	staging_id = stagingLookup(offset);
+	if (staging_id >= 0) {
+		staging_coalesced_blocks++;
+		deleteFromStaging(staging_id);
+	} else {
+		if (staging_buffer_strategy_control->first_freestaging < 0)
+			destageStagingBatch(STAGING_BATCH_BLOCKS);
+		staging_id = staging_buffer_strategy_control->first_freestaging;
+		staging_hdr = &staging_buffer_descriptors[staging_id];
+		staging_buffer_strategy_control->first_freestaging = staging_hdr->next_freestaging;
+		staging_hdr->next_freestaging = -1;
+		staging_hdr->staging_tag.offset = offset;
+		staging_hdr->next_hash = staging_hashtable[staging_hash];
+		staging_hashtable[staging_hash] = staging_id;
+		staging_buffer_strategy_control->n_usedstaging++;
+	}
+	memcpy(staging_blocks + staging_id * BLCKSZ, ssd_buffer, BLCKSZ);
+	addToStagingHead(staging_id);
+	pthread_mutex_unlock(&staging_mutex);
+}
+
+/* write every staged block to the ssd cache, at shutdown */
+void
+flushStagingBuffer()
+{
+	if (STAGING_BUFFER_MB == 0)
+		return;
+	pthread_mutex_lock(&staging_mutex);
+	while (staging_buffer_strategy_control->n_usedstaging > 0)
+		destageStagingBatch(STAGING_BATCH_BLOCKS);
+	pthread_mutex_unlock(&staging_mutex);
+}
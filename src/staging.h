@@ -0,0 +1,42 @@
+#ifndef SMR_SSD_CACHE_STAGING_H
+#define SMR_SSD_CACHE_STAGING_H
+
+#define DEBUG 0
+/* ---------------------------dram staging buffer---------------------------- */
+#include <pthread.h>
+
+typedef struct
+{
+	SSDBufferTag	staging_tag;
+	long		staging_id;			// block location in staging_blocks
+	long		next_hash;			// to link staged blocks with the same hash code
+	long		next_lru;			// to link staged blocks, most recently written first
+	long		last_lru;
+	long		next_freestaging;	// to link free staging blocks
+} StagingBufferDesc;
+
+typedef struct
+{
+	long		n_usedstaging;
+	long		first_freestaging;	// Head of list of free staging blocks
+	long		first_lru;			// most recently written
+	long		last_lru;			// destaged first
+} StagingBufferStrategyControl;
+
+extern unsigned long STAGING_BUFFER_MB;
+extern unsigned long STAGING_BATCH_BLOCKS;
+extern unsigned long staging_write_blocks;
+extern unsigned long staging_coalesced_blocks;
+extern unsigned long staging_read_hits;
+
+StagingBufferDesc *staging_buffer_descriptors;
+StagingBufferStrategyControl *staging_buffer_strategy_control;
+long	       *staging_hashtable;		// first staged block of each hash bucket, -1 if none
+char	       *staging_blocks;
+pthread_mutex_t staging_mutex;
+
+extern void initStagingBuffer();
+extern bool readStagingBlock(off_t offset, char *ssd_buffer);
+extern void writeStagingBlock(off_t offset, char *ssd_buffer);
+extern void flushStagingBuffer();
+#endif
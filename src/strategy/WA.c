@@ -6,111 +6,159 @@
 #include "most.h"
 #include "WA.h"
 #include "band_table.h"
+#include "trace2call.h"
 
 static volatile void moveFromMostToLRUofBand(long);
+static void startWATuneEpoch();
+static void tuneWAThreshold();
+
+/* the counters at the start of the autotune epoch */
+static unsigned long tune_hit_num;
+static unsigned long tune_request_blocks;
+static unsigned long tune_flush_fifo_blocks;
+static unsigned long tune_band_write_bytes;
+static double	tune_rewrite_bytes;		// smr bytes band flushes rewrote, halved every epoch
+static double	tune_destage_bytes;		// bytes the cache destaged, halved every epoch
+static double	tune_last_cost;			// of the last epoch, -1 before the first
+static int	tune_direction;			// 1 doubles WRITEAMPLIFICATION, -1 halves it
 
 void 
 initSSDBufferForWA()
 {
     initSSDBufferForLRUofBand();
     initSSDBufferForMost();
+    wa_tune_epochs = 0;
+    tune_rewrite_bytes = 0;
+    tune_destage_bytes = 0;
+    tune_last_cost = -1;
+    tune_direction = 1;
+    if (WA_AUTOTUNE)
+        startWATuneEpoch();
+}
+
+void
+initSSDBufferDescForWA(long ssd_buf_id)
+{
+    initSSDBufferDescForLRUofBand(ssd_buf_id);
+    initSSDBufferDescForMost(ssd_buf_id);
 }
 
 static volatile void
 moveFromMostToLRUofBand(long band_id_for_most)
-{   
+{
     BandDescForMost band_hdr_for_most;
-    BandDescForMost temp;
 
-    if (band_id_for_most > 0) {
-        printf("[ERROR] moveFromMostToLRUofBand():-------move from Most: band_id_for_most(%ld) > 0\n", band_id_for_most);
+    if (band_id_for_most < 0) {
+        printf("[ERROR] moveFromMostToLRUofBand():-------move from Most: band_id_for_most(%ld) < 0\n", band_id_for_most);
         exit(-1);
     }
-    
-	band_hdr_for_most = band_descriptors_for_most[0];
-	temp = band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1];
-	long		parent = 0;
-	long		child = parent * 2 + 1;
-	while (child < ssd_buffer_strategy_control_for_most->nbands) {
-		if (child < ssd_buffer_strategy_control_for_most->nbands && band_descriptors_for_most[child].current_pages < band_descriptors_for_most[child + 1].current_pages)
-			child++;
-		if (temp.current_pages >= band_descriptors_for_most[child].current_pages)
-			break;
-		else {
-			band_descriptors_for_most[parent] = band_descriptors_for_most[child];
-			long		band_hash = bandtableHashcode(band_descriptors_for_most[child].band_num);
-			bandtableDelete(band_descriptors_for_most[child].band_num, band_hash, band_hashtable_for_most);
-			bandtableInsert(band_descriptors_for_most[child].band_num, band_hash, parent, band_hashtable_for_most);
-			parent = child;
-			child = child * 2 + 1;
-		}
-	}
-	band_descriptors_for_most[parent] = temp;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].band_num = -1;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].current_pages = 0;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].first_page = -1;
-	ssd_buffer_strategy_control_for_most->nbands--;
-	long		band_hash = bandtableHashcode(temp.band_num);
-	bandtableDelete(temp.band_num, band_hash, band_hashtable_for_most);
-	bandtableInsert(temp.band_num, band_hash, parent, band_hashtable_for_most);
+
+    // delete this band from most band heap
+	band_hdr_for_most = band_descriptors_for_most[band_id_for_most];
+	removeBandFromMost(band_id_for_most);
 
 	long		band_num = band_hdr_for_most.band_num;
-	band_hash = bandtableHashcode(band_num);
-	long		band_id;
+	unsigned long	band_hash = bandtableHashcode(band_num);
 	long		first_page = band_hdr_for_most.first_page;
+	long		next_page;
 
 	SSDBufferDescForLRUofBand  *ssd_buf_hdr_for_lruofband;
 
     // add band in lruofband
-    long		temp_first_freeband = band_control->first_freeband;
-    bandtableInsert(band_num, band_hash, temp_first_freeband, band_hashtable_for_lruofband);
-    band_control->first_freeband = band_descriptors[temp_first_freeband].next_free_band;
-    band_descriptors[temp_first_freeband].next_free_band = -1;
-    band_descriptors[temp_first_freeband].current_pages = 1;
+    long		temp_first_freeband = takeFreeBand();
+    bandtableInsert(band_num, band_hash, temp_first_freeband, &band_hashtable_for_lruofband);
+    band_descriptors[temp_first_freeband].current_pages = 0;
     band_descriptors[temp_first_freeband].band_num = band_num;
-    band_descriptors[temp_first_freeband].first_page = first_page;
-    ssd_buffer_descriptors_for_lruofband[first_page].next_ssd_buf = -1;
-        
-    // insert this page into lruofband lru queue
-    ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[first_page];
-    ssd_buf_hdr_for_lruofband->next_lru = ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].ssd_buf_id;
-    ssd_buf_hdr_for_lruofband->last_lru = -1;
-    ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].last_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
-    ssd_buffer_strategy_control_for_lruofband->first_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
-		
+    band_descriptors[temp_first_freeband].first_page = -1;
+
 	while (first_page >= 0) {
-        // insert this page into lruofband band
-	    band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_lruofband);
+        next_page = ssd_buffer_descriptors_for_most[first_page].next_ssd_buf;
+        ssd_buffer_descriptors_for_most[first_page].next_ssd_buf = -1;
 
-        long		old_first_page = band_descriptors[band_id].first_page;
-        ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[old_first_page];
-        SSDBufferDescForLRUofBand *new_ssd_buf_hdr_for_lruofband;
-        new_ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[first_page];
-        new_ssd_buf_hdr_for_lruofband->next_ssd_buf = ssd_buf_hdr_for_lruofband->next_ssd_buf;
-        ssd_buf_hdr_for_lruofband->next_ssd_buf = first_page;
+        // insert this page into lruofband band
+        ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[first_page];
+        ssd_buf_hdr_for_lruofband->next_ssd_buf = band_descriptors[temp_first_freeband].first_page;
+        band_descriptors[temp_first_freeband].first_page = first_page;
+        band_descriptors[temp_first_freeband].current_pages++;
 
         // insert this page into lruofband lru queue
-		ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[first_page];
-		ssd_buf_hdr_for_lruofband->next_lru = ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].ssd_buf_id;
 		ssd_buf_hdr_for_lruofband->last_lru = -1;
-		ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].last_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
-		ssd_buffer_strategy_control_for_lruofband->first_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
-		
+		ssd_buf_hdr_for_lruofband->next_lru = ssd_buffer_strategy_control_for_lruofband->first_lru;
+		if (ssd_buffer_strategy_control_for_lruofband->first_lru >= 0)
+			ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].last_lru = first_page;
+		else
+			ssd_buffer_strategy_control_for_lruofband->last_lru = first_page;
+		ssd_buffer_strategy_control_for_lruofband->first_lru = first_page;
+
         // get next page in most band
-        first_page = ssd_buffer_descriptors_for_most[first_page].next_ssd_buf;
-		ssd_buffer_descriptors_for_most[ssd_buffer_strategy_control->first_freessd].next_ssd_buf = -1;
+        first_page = next_page;
 	}
+}
 
-    // delete this band from most band queue
-	band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_most);
-    if (band_id >= 0)
-    	bandtableDelete(band_num, band_hash, band_hashtable_for_most);
-    else {
-        printf("[ERROR] moveFromMostToLRUofBand():-------delete band from most hash table: band_num=%ld\n", band_num);
-        exit(-1);
-    }
-
+static void
+startWATuneEpoch()
+{
+	collectSMRDriveStats();
+	tune_hit_num = hit_num;
+	tune_request_blocks = request_blocks;
+	tune_flush_fifo_blocks = flush_fifo_blocks;
+	tune_band_write_bytes = flush_band_write_bytes;
+}
 
+/*
+ * With WA_AUTOTUNE, WRITEAMPLIFICATION is hill-climbed online. Every
+ * WA_TUNE_EPOCH_BLOCKS request blocks the epoch is scored by the smr
+ * writes each request block is expected to cost,
+ *
+ *	cost = (1 - hit_ratio) * (1 + rmw_amplification)
+ *
+ * with rmw_amplification the smr bytes band flushes rewrote per byte the
+ * cache destaged. The drive flushes bands long after, and in bursts, so
+ * both byte counts are sums over the past epochs halved every epoch rather
+ * than those of the epoch alone. The threshold moves by a factor of two each
+ * epoch, on in the same direction while the cost falls and back once it
+ * rises, between 1, where a band has to be full to leave Most, and
+ * BNDSZ / BLCKSZ, where its first page moves it to LRUofBand. Every change
+ * is logged with the epoch that caused it.
+ */
+static void
+tuneWAThreshold()
+{
+	unsigned long	blocks = request_blocks - tune_request_blocks, threshold;
+	unsigned long	max_threshold = BNDSZ / BLCKSZ;
+	double		hit_ratio, rmw_amplification, cost;
+
+	/* the counters were reset once the warmup was over */
+	if (request_blocks < tune_request_blocks || hit_num < tune_hit_num) {
+		startWATuneEpoch();
+		return;
+	}
+	if (blocks < WA_TUNE_EPOCH_BLOCKS)
+		return;
+	collectSMRDriveStats();
+	if (flush_fifo_blocks < tune_flush_fifo_blocks || flush_band_write_bytes < tune_band_write_bytes) {
+		startWATuneEpoch();
+		return;
+	}
+	tune_rewrite_bytes = tune_rewrite_bytes / 2 + (flush_band_write_bytes - tune_band_write_bytes);
+	tune_destage_bytes = tune_destage_bytes / 2 + (flush_fifo_blocks - tune_flush_fifo_blocks) * (double) BLCKSZ;
+	hit_ratio = (double) (hit_num - tune_hit_num) / blocks;
+	rmw_amplification = tune_destage_bytes > 0 ? tune_rewrite_bytes / tune_destage_bytes : 0;
+	cost = (1 - hit_ratio) * (1 + rmw_amplification);
+	if (tune_last_cost >= 0 && cost > tune_last_cost)
+		tune_direction = -tune_direction;
+	if ((tune_direction > 0 && WRITEAMPLIFICATION >= max_threshold) || (tune_direction < 0 && WRITEAMPLIFICATION <= 1))
+		tune_direction = -tune_direction;
+	if (tune_direction > 0)
+		threshold = WRITEAMPLIFICATION * 2 < max_threshold ? WRITEAMPLIFICATION * 2 : max_threshold;
+	else
+		threshold = WRITEAMPLIFICATION / 2 > 1 ? WRITEAMPLIFICATION / 2 : 1;
+	wa_tune_epochs++;
+	printf("wa_tune epoch:%lu hit_ratio:%.4f rmw_amplification:%.3f cost:%.4f threshold:%lu->%lu\n",
+	       wa_tune_epochs, hit_ratio, rmw_amplification, cost, WRITEAMPLIFICATION, threshold);
+	WRITEAMPLIFICATION = threshold;
+	tune_last_cost = cost;
+	startWATuneEpoch();
 }
 
 SSDBufferDesc  *
@@ -121,12 +169,16 @@ getWABuffer(SSDBufferTag ssd_buf_tag)
 	long		band_id_for_lruofband = bandtableLookup(band_num, band_hash, band_hashtable_for_lruofband);
     SSDBufferDesc *ssd_buf_hdr;
 
-    if (band_id_for_lruofband >= 0)
+    if (WA_AUTOTUNE)
+        tuneWAThreshold();
+    /* with no band left on the Most side, only LRUofBand can free a slot */
+    if (band_id_for_lruofband >= 0 ||
+        (ssd_buffer_strategy_control->first_freessd < 0 && ssd_buffer_strategy_control_for_most->nbands == 0))
         ssd_buf_hdr = getLRUofBandBuffer(ssd_buf_tag);
     else {
         ssd_buf_hdr = getMostBuffer(ssd_buf_tag);
         long band_id_for_most = bandtableLookup(band_num, band_hash, band_hashtable_for_most);
-        if (band_descriptors[band_id_for_most].current_pages * WRITEAMPLIFICATION >= BNDSZ/BLCKSZ) {
+        if (band_descriptors_for_most[band_id_for_most].current_pages * WRITEAMPLIFICATION >= BNDSZ/BLCKSZ) {
             moveFromMostToLRUofBand(band_id_for_most);
         }
     }
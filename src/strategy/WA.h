@@ -3,7 +3,11 @@
 #include <band_table.h>
 
 extern unsigned long WRITEAMPLIFICATION;
+extern unsigned long WA_AUTOTUNE;
+extern unsigned long WA_TUNE_EPOCH_BLOCKS;
+extern unsigned long wa_tune_epochs;
 
 void initSSDBufferForWA();
+void initSSDBufferDescForWA(long ssd_buf_id);
 SSDBufferDesc *getWABuffer(SSDBufferTag);
 void hitInMostBuffer();
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "ssd_buf_table.h"
+#include "arc.h"
+#include "band_table.h"
+
+static volatile void *addToARCHead(SSDBufferDescForARC * ssd_buf_hdr_for_arc, unsigned arc_list);
+static volatile void *deleteFromARC(SSDBufferDescForARC * ssd_buf_hdr_for_arc);
+static volatile void *addGhostToARCHead(SSDBufferTag ghost_tag, unsigned ghost_list);
+static volatile void *deleteGhostFromARC(long ghost_id);
+static SSDBufferDesc *evictFromARC(unsigned arc_list, bool keep_ghost);
+static SSDBufferDesc *replaceARCBuffer(bool in_b2);
+static void	initGhostDescForARC(long ghost_id);
+
+/*
+ * Adaptive Replacement Cache (Megiddo & Modha, FAST'03).
+ * T1/T2 hold cached blocks seen once/more than once, B1/B2 remember the
+ * tags of blocks recently evicted from T1/T2. Ghost tags are looked up
+ * through a band table keyed by block number.
+ */
+void
+initSSDBufferForARC()
+{
+	initBandTable(NBANDTables, &ghost_hashtable_for_arc);
+
+	ssd_buffer_strategy_control_for_arc = (SSDBufferStrategyControlForARC *) malloc(sizeof(SSDBufferStrategyControlForARC));
+	long		i;
+	for (i = 0; i < 5; i++) {
+		ssd_buffer_strategy_control_for_arc->first_lru[i] = -1;
+		ssd_buffer_strategy_control_for_arc->last_lru[i] = -1;
+		ssd_buffer_strategy_control_for_arc->nlist[i] = 0;
+	}
+	ssd_buffer_strategy_control_for_arc->target_t1 = 0;
+	ssd_buffer_strategy_control_for_arc->first_freeghost = 0;
+	ssd_buffer_strategy_control_for_arc->n_initghost = 0;
+
+	ssd_buffer_descriptors_for_arc = (SSDBufferDescForARC *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForARC));
+	ghost_descriptors_for_arc = (GhostDescForARC *) allocSSDArray(NSSDBuffers, sizeof(GhostDescForARC));
+	initGhostDescForARC(0);
+	flush_fifo_times = 0;
+}
+
+void
+initSSDBufferDescForARC(long ssd_buf_id)
+{
+	SSDBufferDescForARC *ssd_buf_hdr_for_arc = &ssd_buffer_descriptors_for_arc[ssd_buf_id];
+
+	ssd_buf_hdr_for_arc->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_arc->next_arc = -1;
+	ssd_buf_hdr_for_arc->last_arc = -1;
+	ssd_buf_hdr_for_arc->arc_list = 0;
+}
+
+/* free ghosts are set up one at a time, as they reach the head of the free list */
+static void
+initGhostDescForARC(long ghost_id)
+{
+	GhostDescForARC *ghost_hdr_for_arc = &ghost_descriptors_for_arc[ghost_id];
+
+	ghost_hdr_for_arc->ghost_id = ghost_id;
+	ghost_hdr_for_arc->next_ghost = ghost_id + 1 < NSSDBuffers ? ghost_id + 1 : -1;
+	ghost_hdr_for_arc->last_ghost = -1;
+	ghost_hdr_for_arc->ghost_list = 0;
+	ssd_buffer_strategy_control_for_arc->n_initghost = ghost_id + 1;
+}
+
+static volatile void *
+addToARCHead(SSDBufferDescForARC * ssd_buf_hdr_for_arc, unsigned arc_list)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+
+	ssd_buf_hdr_for_arc->arc_list = arc_list;
+	ssd_buf_hdr_for_arc->last_arc = -1;
+	ssd_buf_hdr_for_arc->next_arc = control->first_lru[arc_list];
+	if (control->first_lru[arc_list] >= 0)
+		ssd_buffer_descriptors_for_arc[control->first_lru[arc_list]].last_arc = ssd_buf_hdr_for_arc->ssd_buf_id;
+	else
+		control->last_lru[arc_list] = ssd_buf_hdr_for_arc->ssd_buf_id;
+	control->first_lru[arc_list] = ssd_buf_hdr_for_arc->ssd_buf_id;
+	control->nlist[arc_list]++;
+
+	return NULL;
+}
+
+static volatile void *
+deleteFromARC(SSDBufferDescForARC * ssd_buf_hdr_for_arc)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+	unsigned	arc_list = ssd_buf_hdr_for_arc->arc_list;
+
+	if (ssd_buf_hdr_for_arc->last_arc >= 0)
+		ssd_buffer_descriptors_for_arc[ssd_buf_hdr_for_arc->last_arc].next_arc = ssd_buf_hdr_for_arc->next_arc;
+	else
+		control->first_lru[arc_list] = ssd_buf_hdr_for_arc->next_arc;
+	if (ssd_buf_hdr_for_arc->next_arc >= 0)
+		ssd_buffer_descriptors_for_arc[ssd_buf_hdr_for_arc->next_arc].last_arc = ssd_buf_hdr_for_arc->last_arc;
+	else
+		control->last_lru[arc_list] = ssd_buf_hdr_for_arc->last_arc;
+	ssd_buf_hdr_for_arc->next_arc = -1;
+	ssd_buf_hdr_for_arc->last_arc = -1;
+	ssd_buf_hdr_for_arc->arc_list = 0;
+	control->nlist[arc_list]--;
+
+	return NULL;
+}
+
+static volatile void *
+addGhostToARCHead(SSDBufferTag ghost_tag, unsigned ghost_list)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+	GhostDescForARC *ghost_hdr_for_arc;
+	long		ghost_num = ghost_tag.offset / SSD_BUFFER_SIZE;
+
+	if (control->first_freeghost < 0) {
+		if (control->last_lru[ARC_B2] >= 0)
+			deleteGhostFromARC(control->last_lru[ARC_B2]);
+		else
+			deleteGhostFromARC(control->last_lru[ARC_B1]);
+	}
+	ghost_hdr_for_arc = &ghost_descriptors_for_arc[control->first_freeghost];
+	control->first_freeghost = ghost_hdr_for_arc->next_ghost;
+	if (control->first_freeghost >= 0 && control->first_freeghost == control->n_initghost)
+		initGhostDescForARC(control->n_initghost);
+
+	ghost_hdr_for_arc->ghost_tag = ghost_tag;
+	ghost_hdr_for_arc->ghost_list = ghost_list;
+	ghost_hdr_for_arc->last_ghost = -1;
+	ghost_hdr_for_arc->next_ghost = control->first_lru[ghost_list];
+	if (control->first_lru[ghost_list] >= 0)
+		ghost_descriptors_for_arc[control->first_lru[ghost_list]].last_ghost = ghost_hdr_for_arc->ghost_id;
+	else
+		control->last_lru[ghost_list] = ghost_hdr_for_arc->ghost_id;
+	control->first_lru[ghost_list] = ghost_hdr_for_arc->ghost_id;
+	control->nlist[ghost_list]++;
+	bandtableInsert(ghost_num, bandtableHashcode(ghost_num), ghost_hdr_for_arc->ghost_id, &ghost_hashtable_for_arc);
+
+	return NULL;
+}
+
+static volatile void *
+deleteGhostFromARC(long ghost_id)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+	GhostDescForARC *ghost_hdr_for_arc = &ghost_descriptors_for_arc[ghost_id];
+	unsigned	ghost_list = ghost_hdr_for_arc->ghost_list;
+	long		ghost_num = ghost_hdr_for_arc->ghost_tag.offset / SSD_BUFFER_SIZE;
+
+	if (ghost_hdr_for_arc->last_ghost >= 0)
+		ghost_descriptors_for_arc[ghost_hdr_for_arc->last_ghost].next_ghost = ghost_hdr_for_arc->next_ghost;
+	else
+		control->first_lru[ghost_list] = ghost_hdr_for_arc->next_ghost;
+	if (ghost_hdr_for_arc->next_ghost >= 0)
+		ghost_descriptors_for_arc[ghost_hdr_for_arc->next_ghost].last_ghost = ghost_hdr_for_arc->last_ghost;
+	else
+		control->last_lru[ghost_list] = ghost_hdr_for_arc->last_ghost;
+	control->nlist[ghost_list]--;
+	bandtableDelete(ghost_num, bandtableHashcode(ghost_num), &ghost_hashtable_for_arc);
+
+	ghost_hdr_for_arc->ghost_list = 0;
+	ghost_hdr_for_arc->last_ghost = -1;
+	ghost_hdr_for_arc->next_ghost = control->first_freeghost;
+	control->first_freeghost = ghost_id;
+
+	return NULL;
+}
+
+/*
+ * evict the LRU block of T1 or T2, remembering its tag in B1 or B2 if keep_ghost
+ */
+static SSDBufferDesc *
+evictFromARC(unsigned arc_list, bool keep_ghost)
+{
+	SSDBufferDesc  *ssd_buf_hdr;
+	SSDBufferDescForARC *ssd_buf_hdr_for_arc;
+
+	flush_fifo_times++;
+	ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control_for_arc->last_lru[arc_list]];
+	ssd_buf_hdr_for_arc = &ssd_buffer_descriptors_for_arc[ssd_buf_hdr->ssd_buf_id];
+	deleteFromARC(ssd_buf_hdr_for_arc);
+
+	unsigned char	old_flag = ssd_buf_hdr->ssd_buf_flag;
+	SSDBufferTag	old_tag = ssd_buf_hdr->ssd_buf_tag;
+	if (DEBUG)
+		printf("[INFO] SSDBufferAlloc(): old_flag&SSD_BUF_DIRTY=%d\n", old_flag & SSD_BUF_DIRTY);
+	if ((old_flag & SSD_BUF_DIRTY) != 0) {
+		flushSSDBuffer(ssd_buf_hdr);
+	}
+	if ((old_flag & SSD_BUF_VALID) != 0) {
+		unsigned long	old_hash = ssdbuftableHashcode(&old_tag);
+		ssdbuftableDelete(&old_tag, old_hash);
+	}
+	if (keep_ghost)
+		addGhostToARCHead(old_tag, arc_list == ARC_T1 ? ARC_B1 : ARC_B2);
+
+	return ssd_buf_hdr;
+}
+
+/*
+ * take a free buffer, or run ARC's REPLACE when the cache is full
+ */
+static SSDBufferDesc *
+replaceARCBuffer(bool in_b2)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+	SSDBufferDesc  *ssd_buf_hdr;
+
+	if (ssd_buffer_strategy_control->first_freessd >= 0) {
+		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
+		takeFreeSSDBuffer(ssd_buf_hdr);
+		ssd_buffer_strategy_control->n_usedssd++;
+		return ssd_buf_hdr;
+	}
+	if (control->nlist[ARC_T1] > 0 && ((in_b2 && control->nlist[ARC_T1] == control->target_t1) || control->nlist[ARC_T1] > control->target_t1 || control->nlist[ARC_T2] == 0))
+		return evictFromARC(ARC_T1, 1);
+	else
+		return evictFromARC(ARC_T2, 1);
+}
+
+SSDBufferDesc  *
+getARCBuffer(SSDBufferTag ssd_buf_tag)
+{
+	SSDBufferStrategyControlForARC *control = ssd_buffer_strategy_control_for_arc;
+	SSDBufferDesc  *ssd_buf_hdr;
+	long		ghost_num = ssd_buf_tag.offset / SSD_BUFFER_SIZE;
+	long		ghost_id = bandtableLookup(ghost_num, bandtableHashcode(ghost_num), ghost_hashtable_for_arc);
+	long		delta;
+
+	if (ghost_id >= 0 && ghost_descriptors_for_arc[ghost_id].ghost_list == ARC_B1) {
+		delta = control->nlist[ARC_B2] / control->nlist[ARC_B1];
+		if (delta < 1)
+			delta = 1;
+		control->target_t1 += delta;
+		if (control->target_t1 > NSSDBuffers)
+			control->target_t1 = NSSDBuffers;
+		deleteGhostFromARC(ghost_id);
+		ssd_buf_hdr = replaceARCBuffer(0);
+		addToARCHead(&ssd_buffer_descriptors_for_arc[ssd_buf_hdr->ssd_buf_id], ARC_T2);
+		return ssd_buf_hdr;
+	}
+	if (ghost_id >= 0 && ghost_descriptors_for_arc[ghost_id].ghost_list == ARC_B2) {
+		delta = control->nlist[ARC_B1] / control->nlist[ARC_B2];
+		if (delta < 1)
+			delta = 1;
+		control->target_t1 -= delta;
+		if (control->target_t1 < 0)
+			control->target_t1 = 0;
+		deleteGhostFromARC(ghost_id);
+		ssd_buf_hdr = replaceARCBuffer(1);
+		addToARCHead(&ssd_buffer_descriptors_for_arc[ssd_buf_hdr->ssd_buf_id], ARC_T2);
+		return ssd_buf_hdr;
+	}
+
+	if (control->nlist[ARC_T1] + control->nlist[ARC_B1] >= NSSDBuffers) {
+		if (control->nlist[ARC_T1] < NSSDBuffers) {
+			deleteGhostFromARC(control->last_lru[ARC_B1]);
+			ssd_buf_hdr = replaceARCBuffer(0);
+		} else
+			ssd_buf_hdr = evictFromARC(ARC_T1, 0);
+	} else {
+		if (control->nlist[ARC_T1] + control->nlist[ARC_T2] + control->nlist[ARC_B1] + control->nlist[ARC_B2] >= 2 * NSSDBuffers)
+			deleteGhostFromARC(control->last_lru[ARC_B2]);
+		ssd_buf_hdr = replaceARCBuffer(0);
+	}
+	addToARCHead(&ssd_buffer_descriptors_for_arc[ssd_buf_hdr->ssd_buf_id], ARC_T1);
+	return ssd_buf_hdr;
+}
+
+void           *
+hitInARCBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferDescForARC *ssd_buf_hdr_for_arc = &ssd_buffer_descriptors_for_arc[ssd_buf_hdr->ssd_buf_id];
+
+	deleteFromARC(ssd_buf_hdr_for_arc);
+	addToARCHead(ssd_buf_hdr_for_arc, ARC_T2);
+
+	return NULL;
+}
@@ -0,0 +1,47 @@
+#define DEBUG 0
+/* ---------------------------arc---------------------------- */
+#include <band_table.h>
+
+#define ARC_T1 1
+#define ARC_T2 2
+#define ARC_B1 3
+#define ARC_B2 4
+
+typedef struct
+{
+	long 		ssd_buf_id;				// ssd buffer location in shared buffer
+    long        next_arc;               // to link used ssd in T1 or T2
+    long        last_arc;               // to link used ssd in T1 or T2
+    unsigned    arc_list;               // ARC_T1 or ARC_T2, 0 if free
+} SSDBufferDescForARC;
+
+typedef struct
+{
+	SSDBufferTag	ghost_tag;          // tag of an evicted block
+	long		ghost_id;
+	long		next_ghost;             // to link ghosts in B1 or B2, or free ghosts
+	long		last_ghost;
+	unsigned	ghost_list;             // ARC_B1 or ARC_B2, 0 if free
+} GhostDescForARC;
+
+typedef struct
+{
+	long		first_lru[5];           // MRU end of each list, indexed by ARC_T1..ARC_B2
+	long		last_lru[5];            // LRU end of each list
+	long		nlist[5];               // # of entries in each list
+	long		target_t1;              // adaptive target size p of T1
+	long		first_freeghost;
+	long		n_initghost;            // ghosts [0, n_initghost) have been set up
+} SSDBufferStrategyControlForARC;
+
+SSDBufferDescForARC	*ssd_buffer_descriptors_for_arc;
+GhostDescForARC		*ghost_descriptors_for_arc;
+SSDBufferStrategyControlForARC *ssd_buffer_strategy_control_for_arc;
+BandHashBucket *ghost_hashtable_for_arc;
+
+extern unsigned long flush_fifo_times;
+
+extern void initSSDBufferForARC();
+extern void initSSDBufferDescForARC(long ssd_buf_id);
+extern SSDBufferDesc *getARCBuffer(SSDBufferTag);
+extern void *hitInARCBuffer(SSDBufferDesc *);
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "sketch.h"
+#include "band_hotness.h"
+
+#define BAND_HOTNESS_MAX_COUNT 255		// 8-bit counters
+
+static CountMinSketch band_sketch;
+
+/*
+ * How often, and how lately, each smr band has been written: every block
+ * written to the ssd cache counts towards its band in a count-min sketch
+ * (see sketch.c) that is halved every BAND_HOTNESS_HALF_LIFE blocks, so a
+ * band that stops being written cools down by half each period. A lookup is
+ * SKETCH_DEPTH counter reads, and the memory is SKETCH_DEPTH *
+ * BAND_HOTNESS_WIDTH bytes whatever NSMRBands is.
+ *
+ * With BAND_HOTNESS set, LRUofBand evicts the coldest of the bands of its
+ * BAND_HOTNESS_CANDIDATES least recently used blocks, and Most the band with
+ * the most pages per unit of hotness among the first BAND_HOTNESS_CANDIDATES
+ * bands of its heap; WA gets both. "make bench" times a touch and a lookup.
+ */
+void
+initBandHotness()
+{
+	initSketch(&band_sketch, BAND_HOTNESS_WIDTH, BAND_HOTNESS_MAX_COUNT, BAND_HOTNESS_HALF_LIFE);
+	band_hotness_touches = 0;
+	band_hotness_queries = 0;
+	band_hotness_halvings = 0;
+}
+
+/* nblocks of band band_num were written */
+void
+touchBandHotness(long band_num, unsigned long nblocks)
+{
+	unsigned long	halvings = band_sketch.halvings;
+
+	incrementSketch(&band_sketch, band_num, nblocks);
+	band_hotness_touches++;
+	band_hotness_halvings += band_sketch.halvings - halvings;
+}
+
+/* the decayed # of blocks written to band band_num, an overestimate at most */
+unsigned long
+getBandHotness(long band_num)
+{
+	band_hotness_queries++;
+	return estimateSketch(&band_sketch, band_num);
+}
+
+void
+reportBandHotness()
+{
+	printf("band_hotness width:%lu memory(KB):%.1f half_life(blocks):%lu touches:%lu queries:%lu halvings:%lu\n",
+	       band_sketch.width, SKETCH_DEPTH * band_sketch.width / 1024.0, band_sketch.sample,
+	       band_hotness_touches, band_hotness_queries, band_hotness_halvings);
+}
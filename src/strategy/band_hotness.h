@@ -0,0 +1,19 @@
+#ifndef BANDHOTNESS_H
+#define BANDHOTNESS_H
+
+#define DEBUG 0
+/*-----------------------------------band hotness----------------------------*/
+
+extern unsigned long BAND_HOTNESS;
+extern unsigned long BAND_HOTNESS_WIDTH;
+extern unsigned long BAND_HOTNESS_HALF_LIFE;
+extern unsigned long BAND_HOTNESS_CANDIDATES;
+extern unsigned long band_hotness_touches;
+extern unsigned long band_hotness_queries;
+extern unsigned long band_hotness_halvings;
+
+extern void initBandHotness();
+extern void touchBandHotness(long band_num, unsigned long nblocks);
+extern unsigned long getBandHotness(long band_num);
+extern void reportBandHotness();
+#endif    /*  BANDHOTNESS_H*/
@@ -1,19 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include "../ssd-cache.h"
 #include "band_table.h"
 
 static bool isSameband(long band_id1,long band_id2);
 
+/* bucket heads only link the entries, an all-zero table is empty */
 void initBandTable(size_t size, BandHashBucket ** band_hashtable)
 {
-	*band_hashtable = (BandHashBucket *)malloc(sizeof(BandHashBucket)*size);
-	size_t i;
-	BandHashBucket *band_hash = *band_hashtable;
-	for(i = 0;i < size; band_hash++,i++){
-		band_hash->band_num = -1;
-		band_hash->band_id = -1;
-		band_hash->next_item = NULL;	
-	}	
+	*band_hashtable = (BandHashBucket *)allocSSDArray(size, sizeof(BandHashBucket));
 }
 
 unsigned long bandtableHashcode(long band_num)
@@ -24,7 +19,7 @@ unsigned long bandtableHashcode(long band_num)
 
 size_t bandtableLookup(long band_num,unsigned long hash_code, BandHashBucket * band_hashtable)
 {
-	BandHashBucket *nowbucket = GetBandHashBucket(hash_code, band_hashtable);
+	BandHashBucket *nowbucket = GetBandHashBucket(hash_code, band_hashtable)->next_item;
 	while(nowbucket != NULL){
 		if(isSameband(nowbucket->band_num,band_num))
 			return nowbucket->band_id;	
@@ -57,7 +52,7 @@ long bandtableInsert(long band_num,unsigned long hash_code,long band_id, BandHas
 long bandtableDelete(long band_num,unsigned long hash_code, BandHashBucket ** band_hashtable)
 {
 	BandHashBucket *nowbucket = GetBandHashBucket(hash_code, *band_hashtable);
-	long del_val;
+	long del_val = -1;
 	BandHashBucket *delitem;
 	while(nowbucket->next_item != NULL && nowbucket != NULL){
 		if(isSameband(nowbucket->next_item->band_num,band_num)){
@@ -14,17 +14,19 @@ initSSDBufferForClock()
 	ssd_buffer_strategy_control_for_clock = (SSDBufferStrategyControlForClock *) malloc(sizeof(SSDBufferStrategyControlForClock));
 	ssd_buffer_strategy_control_for_clock->next_victimssd = 0;
 
-	ssd_buffer_descriptors_for_clock = (SSDBufferDescForClock *) malloc(sizeof(SSDBufferDescForClock) * NSSDBuffers);
-	SSDBufferDescForClock *ssd_buf_hdr_for_clock;
-	long		i;
-	ssd_buf_hdr_for_clock = ssd_buffer_descriptors_for_clock;
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_clock++, i++) {
-		ssd_buf_hdr_for_clock->ssd_buf_id = i;
-		ssd_buf_hdr_for_clock->usage_count = 0;
-	}
+	ssd_buffer_descriptors_for_clock = (SSDBufferDescForClock *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForClock));
 	flush_fifo_times = 0;
 }
 
+void
+initSSDBufferDescForClock(long ssd_buf_id)
+{
+	SSDBufferDescForClock *ssd_buf_hdr_for_clock = &ssd_buffer_descriptors_for_clock[ssd_buf_id];
+
+	ssd_buf_hdr_for_clock->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_clock->usage_count = 0;
+}
+
 SSDBufferDesc  *
 getCLOCKBuffer()
 {
@@ -33,8 +35,7 @@ getCLOCKBuffer()
 
 	if (ssd_buffer_strategy_control->first_freessd >= 0) {
 		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
-		ssd_buffer_strategy_control->first_freessd = ssd_buf_hdr->next_freessd;
-		ssd_buf_hdr->next_freessd = -1;
+		takeFreeSSDBuffer(ssd_buf_hdr);
 		ssd_buffer_strategy_control->n_usedssd++;
 		return ssd_buf_hdr;
 	}
@@ -53,10 +54,10 @@ getCLOCKBuffer()
 			SSDBufferTag	old_tag = ssd_buf_hdr->ssd_buf_tag;
 			if (DEBUG)
 				printf("[INFO] SSDBufferAlloc(): old_flag&SSD_BUF_DIRTY=%d\n", old_flag & SSD_BUF_DIRTY);
-			if (old_flag & SSD_BUF_DIRTY != 0) {
+			if ((old_flag & SSD_BUF_DIRTY) != 0) {
 				flushSSDBuffer(ssd_buf_hdr);
 			}
-			if (old_flag & SSD_BUF_VALID != 0) {
+			if ((old_flag & SSD_BUF_VALID) != 0) {
 				unsigned long	old_hash = ssdbuftableHashcode(&old_tag);
 				ssdbuftableDelete(&old_tag, old_hash);
 			}
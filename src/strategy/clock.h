@@ -18,5 +18,6 @@ SSDBufferStrategyControlForClock *ssd_buffer_strategy_control_for_clock;
 extern unsigned long flush_fifo_times;
 
 extern void initSSDBufferForClock();
+extern void initSSDBufferDescForClock(long ssd_buf_id);
 extern SSDBufferDesc *getCLOCKBuffer();
 extern void *hitInCLOCKBuffer(SSDBufferDesc *);
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "ssd_buf_table.h"
+#include "costbenefit.h"
+#include "band_table.h"
+
+static double scoreBand(long band_id);
+static volatile void siftUpForCostBenefit(long heap_pos);
+static volatile void siftDownForCostBenefit(long heap_pos);
+static volatile void pushBand(long band_id);
+static long popOldestBand();
+static volatile void addToBand(SSDBufferTag ssd_buf_tag, long freessd);
+static volatile void deleteBand();
+static void initBandDescForCostBenefit(long band_id);
+static void addToBandTail(long band_id, long ssd_buf_id);
+
+static long *candidate_bands;	// bands scored by one eviction
+
+/*
+ * Evict the band whose flush saves the most: dirty pages written back per
+ * band RMW, weighted up by age and down by access frequency. The pages of
+ * a band are listed least recently used first, and the bands are kept in a
+ * heap by the last access of their least recently used page, so the top is
+ * the band LRUofBand would evict. Hits and inserts only relink the page and
+ * bump the band's counters; a band whose key went stale is put back in
+ * order when it reaches the top. An eviction takes COSTBENEFIT_CANDIDATES
+ * bands off the top of the heap, scores them, evicts the best and puts the
+ * others back, so scores are only computed at eviction time and only for
+ * bands holding the oldest pages.
+ */
+void
+initSSDBufferForCostBenefit()
+{
+	initBandTable(NBANDTables, &band_hashtable_for_costbenefit);
+
+	ssd_buffer_descriptors_for_costbenefit = (SSDBufferDescForCostBenefit *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForCostBenefit));
+	band_descriptors_for_costbenefit = (BandDescForCostBenefit *) allocSSDArray(NSMRBands, sizeof(BandDescForCostBenefit));
+
+	band_heap_for_costbenefit = (long *) malloc(sizeof(long) * NSMRBands);
+	if (COSTBENEFIT_CANDIDATES < 1)
+		COSTBENEFIT_CANDIDATES = 1;
+	candidate_bands = (long *) malloc(sizeof(long) * COSTBENEFIT_CANDIDATES);
+
+	ssd_buffer_strategy_control_for_costbenefit = (SSDBufferStrategyControlForCostBenefit *) malloc(sizeof(SSDBufferStrategyControlForCostBenefit));
+	ssd_buffer_strategy_control_for_costbenefit->nbands = 0;
+	ssd_buffer_strategy_control_for_costbenefit->first_freeband = 0;
+	ssd_buffer_strategy_control_for_costbenefit->n_initband = 0;
+	initBandDescForCostBenefit(0);
+	ssd_buffer_strategy_control_for_costbenefit->access_clock = 0;
+	flush_fifo_times = 0;
+}
+
+void
+initSSDBufferDescForCostBenefit(long ssd_buf_id)
+{
+	SSDBufferDescForCostBenefit *ssd_buf_hdr_for_costbenefit = &ssd_buffer_descriptors_for_costbenefit[ssd_buf_id];
+
+	ssd_buf_hdr_for_costbenefit->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_costbenefit->next_ssd_buf = -1;
+	ssd_buf_hdr_for_costbenefit->last_ssd_buf = -1;
+	ssd_buf_hdr_for_costbenefit->band_id = -1;
+	ssd_buf_hdr_for_costbenefit->last_access = 0;
+}
+
+static void
+initBandDescForCostBenefit(long band_id)
+{
+	BandDescForCostBenefit *band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+
+	band_hdr_for_costbenefit->band_num = -1;
+	band_hdr_for_costbenefit->current_pages = 0;
+	band_hdr_for_costbenefit->dirty_pages = 0;
+	band_hdr_for_costbenefit->first_page = -1;
+	band_hdr_for_costbenefit->last_page = -1;
+	band_hdr_for_costbenefit->heap_pos = -1;
+	band_hdr_for_costbenefit->last_access = 0;
+	band_hdr_for_costbenefit->access_count = 0;
+	band_hdr_for_costbenefit->heap_key = 0;
+	band_hdr_for_costbenefit->next_free_band = band_id + 1 < NSMRBands ? band_id + 1 : -1;
+	ssd_buffer_strategy_control_for_costbenefit->n_initband = band_id + 1;
+}
+
+/*
+ * benefit/cost of evicting a band: a dirty band costs one RMW of the whole
+ * band and writes back dirty_pages, a clean band only frees its pages.
+ */
+static double
+scoreBand(long band_id)
+{
+	BandDescForCostBenefit *band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+	double		age = ssd_buffer_strategy_control_for_costbenefit->access_clock - band_hdr_for_costbenefit->last_access + 1;
+	double		benefit, cost;
+
+	if (band_hdr_for_costbenefit->dirty_pages > 0) {
+		benefit = band_hdr_for_costbenefit->dirty_pages;
+		cost = GetSMRActualBandSizeFromSSD(ssd_buffer_descriptors[band_hdr_for_costbenefit->first_page].ssd_buf_tag.offset) / BLCKSZ;
+	} else {
+		benefit = band_hdr_for_costbenefit->current_pages;
+		cost = 1;
+	}
+	return benefit / cost * age / (band_hdr_for_costbenefit->access_count + 1);
+}
+
+static volatile void
+siftUpForCostBenefit(long heap_pos)
+{
+	long		band_id = band_heap_for_costbenefit[heap_pos];
+	unsigned long	heap_key = band_descriptors_for_costbenefit[band_id].heap_key;
+	long		parent;
+
+	while (heap_pos > 0) {
+		parent = (heap_pos - 1) / 2;
+		if (band_descriptors_for_costbenefit[band_heap_for_costbenefit[parent]].heap_key <= heap_key)
+			break;
+		band_heap_for_costbenefit[heap_pos] = band_heap_for_costbenefit[parent];
+		band_descriptors_for_costbenefit[band_heap_for_costbenefit[heap_pos]].heap_pos = heap_pos;
+		heap_pos = parent;
+	}
+	band_heap_for_costbenefit[heap_pos] = band_id;
+	band_descriptors_for_costbenefit[band_id].heap_pos = heap_pos;
+}
+
+static volatile void
+siftDownForCostBenefit(long heap_pos)
+{
+	long		nbands = ssd_buffer_strategy_control_for_costbenefit->nbands;
+	long		band_id = band_heap_for_costbenefit[heap_pos];
+	unsigned long	heap_key = band_descriptors_for_costbenefit[band_id].heap_key;
+	long		child;
+
+	while ((child = heap_pos * 2 + 1) < nbands) {
+		if (child + 1 < nbands && band_descriptors_for_costbenefit[band_heap_for_costbenefit[child + 1]].heap_key < band_descriptors_for_costbenefit[band_heap_for_costbenefit[child]].heap_key)
+			child++;
+		if (heap_key <= band_descriptors_for_costbenefit[band_heap_for_costbenefit[child]].heap_key)
+			break;
+		band_heap_for_costbenefit[heap_pos] = band_heap_for_costbenefit[child];
+		band_descriptors_for_costbenefit[band_heap_for_costbenefit[heap_pos]].heap_pos = heap_pos;
+		heap_pos = child;
+	}
+	band_heap_for_costbenefit[heap_pos] = band_id;
+	band_descriptors_for_costbenefit[band_id].heap_pos = heap_pos;
+}
+
+static volatile void
+pushBand(long band_id)
+{
+	band_descriptors_for_costbenefit[band_id].heap_key = ssd_buffer_descriptors_for_costbenefit[band_descriptors_for_costbenefit[band_id].first_page].last_access;
+	band_heap_for_costbenefit[ssd_buffer_strategy_control_for_costbenefit->nbands] = band_id;
+	ssd_buffer_strategy_control_for_costbenefit->nbands++;
+	siftUpForCostBenefit(ssd_buffer_strategy_control_for_costbenefit->nbands - 1);
+}
+
+/*
+ * Take the band with the least recently used page off the heap. A key only
+ * goes stale by a hit on that page, which makes it older than the page the
+ * band now starts with, so the top is refreshed and sifted down until it is
+ * current; every refresh pays for at least one hit.
+ */
+static long
+popOldestBand()
+{
+	BandDescForCostBenefit *band_hdr_for_costbenefit;
+	unsigned long	heap_key;
+	long		band_id;
+	long		last;
+
+	while (1) {
+		band_id = band_heap_for_costbenefit[0];
+		band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+		heap_key = ssd_buffer_descriptors_for_costbenefit[band_hdr_for_costbenefit->first_page].last_access;
+		if (band_hdr_for_costbenefit->heap_key == heap_key)
+			break;
+		band_hdr_for_costbenefit->heap_key = heap_key;
+		siftDownForCostBenefit(0);
+	}
+	ssd_buffer_strategy_control_for_costbenefit->nbands--;
+	last = ssd_buffer_strategy_control_for_costbenefit->nbands;
+	if (last > 0) {
+		band_heap_for_costbenefit[0] = band_heap_for_costbenefit[last];
+		band_descriptors_for_costbenefit[band_heap_for_costbenefit[0]].heap_pos = 0;
+		siftDownForCostBenefit(0);
+	}
+	band_hdr_for_costbenefit->heap_pos = -1;
+	return band_id;
+}
+
+/*
+ * Score the COSTBENEFIT_CANDIDATES least recently used bands, evict the best
+ * one and put the others back. Being a candidate halves a band's access
+ * count, so frequency only protects a band while it keeps being hit.
+ */
+static volatile void
+deleteBand()
+{
+	BandDescForCostBenefit *band_hdr_for_costbenefit;
+	long		band_id = -1;
+	long		ncandidates = 0;
+	long		i;
+	double		score, best_score = 0;
+
+	while (ncandidates < COSTBENEFIT_CANDIDATES && ssd_buffer_strategy_control_for_costbenefit->nbands > 0) {
+		candidate_bands[ncandidates] = popOldestBand();
+		score = scoreBand(candidate_bands[ncandidates]);
+		band_descriptors_for_costbenefit[candidate_bands[ncandidates]].access_count /= 2;
+		if (band_id < 0 || score > best_score) {
+			band_id = candidate_bands[ncandidates];
+			best_score = score;
+		}
+		ncandidates++;
+	}
+	for (i = 0; i < ncandidates; i++)
+		if (candidate_bands[i] != band_id)
+			pushBand(candidate_bands[i]);
+	band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+
+	long		band_num = band_hdr_for_costbenefit->band_num;
+	long		first_page = band_hdr_for_costbenefit->first_page;
+
+	bandtableDelete(band_num, bandtableHashcode(band_num), &band_hashtable_for_costbenefit);
+	band_hdr_for_costbenefit->band_num = -1;
+	band_hdr_for_costbenefit->current_pages = 0;
+	band_hdr_for_costbenefit->dirty_pages = 0;
+	band_hdr_for_costbenefit->first_page = -1;
+	band_hdr_for_costbenefit->last_page = -1;
+	band_hdr_for_costbenefit->heap_pos = -1;
+	band_hdr_for_costbenefit->next_free_band = ssd_buffer_strategy_control_for_costbenefit->first_freeband;
+	ssd_buffer_strategy_control_for_costbenefit->first_freeband = band_id;
+
+	SSDBufferTag	old_tag;
+	unsigned char	old_flag;
+	unsigned long	old_hash;
+	SSDBufferDesc  *ssd_buf_hdr;
+
+	while (first_page >= 0) {
+		ssd_buf_hdr = &ssd_buffer_descriptors[first_page];
+
+		putFreeSSDBuffer(ssd_buf_hdr);
+		first_page = ssd_buffer_descriptors_for_costbenefit[first_page].next_ssd_buf;
+		ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr->ssd_buf_id].next_ssd_buf = -1;
+		ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr->ssd_buf_id].last_ssd_buf = -1;
+		ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr->ssd_buf_id].band_id = -1;
+
+		old_flag = ssd_buf_hdr->ssd_buf_flag;
+		old_tag = ssd_buf_hdr->ssd_buf_tag;
+		if ((old_flag & SSD_BUF_DIRTY) != 0) {
+			flushSSDBuffer(ssd_buf_hdr);
+		}
+		if ((old_flag & SSD_BUF_VALID) != 0) {
+			old_hash = ssdbuftableHashcode(&old_tag);
+			ssdbuftableDelete(&old_tag, old_hash);
+		}
+		ssd_buffer_strategy_control->n_usedssd--;
+	}
+}
+
+/* the page becomes the most recently used one of its band */
+static void
+addToBandTail(long band_id, long ssd_buf_id)
+{
+	BandDescForCostBenefit *band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+	SSDBufferDescForCostBenefit *ssd_buf_hdr_for_costbenefit = &ssd_buffer_descriptors_for_costbenefit[ssd_buf_id];
+
+	ssd_buf_hdr_for_costbenefit->band_id = band_id;
+	ssd_buf_hdr_for_costbenefit->last_access = ssd_buffer_strategy_control_for_costbenefit->access_clock;
+	ssd_buf_hdr_for_costbenefit->next_ssd_buf = -1;
+	ssd_buf_hdr_for_costbenefit->last_ssd_buf = band_hdr_for_costbenefit->last_page;
+	if (band_hdr_for_costbenefit->last_page >= 0)
+		ssd_buffer_descriptors_for_costbenefit[band_hdr_for_costbenefit->last_page].next_ssd_buf = ssd_buf_id;
+	else
+		band_hdr_for_costbenefit->first_page = ssd_buf_id;
+	band_hdr_for_costbenefit->last_page = ssd_buf_id;
+	band_hdr_for_costbenefit->last_access = ssd_buffer_strategy_control_for_costbenefit->access_clock;
+	band_hdr_for_costbenefit->access_count++;
+}
+
+static volatile void
+addToBand(SSDBufferTag ssd_buf_tag, long first_freessd)
+{
+	long		band_num = GetSMRBandNumFromSSD(ssd_buf_tag.offset);
+	unsigned long	band_hash = bandtableHashcode(band_num);
+	long		band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_costbenefit);
+	BandDescForCostBenefit *band_hdr_for_costbenefit;
+
+	ssd_buffer_strategy_control_for_costbenefit->access_clock++;
+	if (band_id >= 0) {
+		band_descriptors_for_costbenefit[band_id].current_pages++;
+		addToBandTail(band_id, first_freessd);
+	} else {
+		band_id = ssd_buffer_strategy_control_for_costbenefit->first_freeband;
+		if (band_id < 0) {
+			printf("[ERROR] addToBand():-------no free band descriptor for CostBenefit: band_num=%ld\n", band_num);
+			exit(-1);
+		}
+		band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+		ssd_buffer_strategy_control_for_costbenefit->first_freeband = band_hdr_for_costbenefit->next_free_band;
+		band_hdr_for_costbenefit->next_free_band = -1;
+		if (ssd_buffer_strategy_control_for_costbenefit->first_freeband >= 0 && ssd_buffer_strategy_control_for_costbenefit->first_freeband == ssd_buffer_strategy_control_for_costbenefit->n_initband)
+			initBandDescForCostBenefit(ssd_buffer_strategy_control_for_costbenefit->n_initband);
+		band_hdr_for_costbenefit->band_num = band_num;
+		band_hdr_for_costbenefit->current_pages = 1;
+		band_hdr_for_costbenefit->access_count = 0;
+		bandtableInsert(band_num, band_hash, band_id, &band_hashtable_for_costbenefit);
+		addToBandTail(band_id, first_freessd);
+		pushBand(band_id);
+	}
+}
+
+SSDBufferDesc  *
+getCostBenefitBuffer(SSDBufferTag ssd_buf_tag)
+{
+	SSDBufferDesc  *ssd_buffer_hdr;
+	long		first_freessd = ssd_buffer_strategy_control->first_freessd;
+
+	if (first_freessd < 0) {
+		flush_fifo_times++;
+		deleteBand();
+		first_freessd = ssd_buffer_strategy_control->first_freessd;
+	}
+	addToBand(ssd_buf_tag, first_freessd);
+	ssd_buffer_hdr = &ssd_buffer_descriptors[first_freessd];
+	takeFreeSSDBuffer(ssd_buffer_hdr);
+	ssd_buffer_strategy_control->n_usedssd++;
+	return ssd_buffer_hdr;
+}
+
+void
+hitInCostBenefitBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferDescForCostBenefit *ssd_buf_hdr_for_costbenefit = &ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr->ssd_buf_id];
+	BandDescForCostBenefit *band_hdr_for_costbenefit;
+	long		band_id = ssd_buf_hdr_for_costbenefit->band_id;
+
+	if (band_id < 0)
+		return;
+	band_hdr_for_costbenefit = &band_descriptors_for_costbenefit[band_id];
+	if (ssd_buf_hdr_for_costbenefit->last_ssd_buf >= 0)
+		ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr_for_costbenefit->last_ssd_buf].next_ssd_buf = ssd_buf_hdr_for_costbenefit->next_ssd_buf;
+	else
+		band_hdr_for_costbenefit->first_page = ssd_buf_hdr_for_costbenefit->next_ssd_buf;
+	if (ssd_buf_hdr_for_costbenefit->next_ssd_buf >= 0)
+		ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr_for_costbenefit->next_ssd_buf].last_ssd_buf = ssd_buf_hdr_for_costbenefit->last_ssd_buf;
+	else
+		band_hdr_for_costbenefit->last_page = ssd_buf_hdr_for_costbenefit->last_ssd_buf;
+	ssd_buffer_strategy_control_for_costbenefit->access_clock++;
+	addToBandTail(band_id, ssd_buf_hdr->ssd_buf_id);
+}
+
+/* a page of the band turned dirty (delta 1) or clean (delta -1) */
+void
+dirtyInCostBenefitBuffer(SSDBufferDesc * ssd_buf_hdr, long delta)
+{
+	long		band_id = ssd_buffer_descriptors_for_costbenefit[ssd_buf_hdr->ssd_buf_id].band_id;
+
+	if (band_id >= 0)
+		band_descriptors_for_costbenefit[band_id].dirty_pages += delta;
+}
@@ -0,0 +1,51 @@
+#define DEBUG 0
+/*----------------------------cost-benefit of band--------------------------*/
+#include <band_table.h>
+
+typedef struct
+{
+	long ssd_buf_id;//ssd buffer location in shared buffer
+	long next_ssd_buf;      // to link the pages of a band, least recently used first
+	long last_ssd_buf;
+	long band_id;           // band descriptor of the page, -1 if not cached
+	unsigned long last_access;  // access_clock of the last insert or hit of the page
+} SSDBufferDescForCostBenefit;
+
+typedef struct
+{
+	long band_num;
+	long current_pages;
+	long dirty_pages;       // kept up to date by dirtyInCostBenefitBuffer()
+	long first_page;        // least recently used page of the band
+	long last_page;         // most recently used page of the band
+	long heap_pos;          // position of this band in band_heap_for_costbenefit, -1 if not cached
+	long next_free_band;
+	unsigned long last_access;  // access_clock of the last insert or hit in this band
+	unsigned long access_count; // inserts and hits, halved each time the band is an eviction candidate
+	unsigned long heap_key;     // last_access of first_page when the band was last placed in the heap
+} BandDescForCostBenefit;
+
+typedef struct
+{
+    long        nbands;          // # of cached bands
+    long        first_freeband;  // Head of list of free band descriptors
+    long        n_initband;      // band descriptors [0, n_initband) have been set up
+    unsigned long access_clock;  // logical time, one tick per insert or hit
+} SSDBufferStrategyControlForCostBenefit;
+
+extern unsigned long NBANDTables;
+extern unsigned long NSMRBands;
+extern unsigned long COSTBENEFIT_CANDIDATES;
+extern unsigned long flush_fifo_times;
+
+SSDBufferDescForCostBenefit *ssd_buffer_descriptors_for_costbenefit;
+BandDescForCostBenefit *band_descriptors_for_costbenefit;
+long *band_heap_for_costbenefit;      // min-heap of band ids ordered by heap_key
+SSDBufferStrategyControlForCostBenefit *ssd_buffer_strategy_control_for_costbenefit;
+BandHashBucket *band_hashtable_for_costbenefit;
+
+void initSSDBufferForCostBenefit();
+void initSSDBufferDescForCostBenefit(long ssd_buf_id);
+SSDBufferDesc *getCostBenefitBuffer(SSDBufferTag);
+void hitInCostBenefitBuffer(SSDBufferDesc *);
+void dirtyInCostBenefitBuffer(SSDBufferDesc *, long delta);
@@ -18,18 +18,20 @@ initSSDBufferForLRU()
 	ssd_buffer_strategy_control_for_lru->first_lru = -1;
 	ssd_buffer_strategy_control_for_lru->last_lru = -1;
 
-	ssd_buffer_descriptors_for_lru = (SSDBufferDescForLRU *) malloc(sizeof(SSDBufferDescForLRU) * NSSDBuffers);
-	SSDBufferDescForLRU *ssd_buf_hdr_for_lru;
-	long		i;
-	ssd_buf_hdr_for_lru = ssd_buffer_descriptors_for_lru;
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_lru++, i++) {
-		ssd_buf_hdr_for_lru->ssd_buf_id = i;
-		ssd_buf_hdr_for_lru->next_lru = -1;
-		ssd_buf_hdr_for_lru->last_lru = -1;
-	}
+	ssd_buffer_descriptors_for_lru = (SSDBufferDescForLRU *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForLRU));
 	flush_fifo_times = 0;
 }
 
+void
+initSSDBufferDescForLRU(long ssd_buf_id)
+{
+	SSDBufferDescForLRU *ssd_buf_hdr_for_lru = &ssd_buffer_descriptors_for_lru[ssd_buf_id];
+
+	ssd_buf_hdr_for_lru->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_lru->next_lru = -1;
+	ssd_buf_hdr_for_lru->last_lru = -1;
+}
+
 static volatile void *
 addToLRUHead(SSDBufferDescForLRU * ssd_buf_hdr_for_lru)
 {
@@ -81,8 +83,7 @@ getLRUBuffer()
 	if (ssd_buffer_strategy_control->first_freessd >= 0) {
 		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
 		ssd_buf_hdr_for_lru = &ssd_buffer_descriptors_for_lru[ssd_buffer_strategy_control->first_freessd];
-		ssd_buffer_strategy_control->first_freessd = ssd_buf_hdr->next_freessd;
-		ssd_buf_hdr->next_freessd = -1;
+		takeFreeSSDBuffer(ssd_buf_hdr);
 		addToLRUHead(ssd_buf_hdr_for_lru);
 		ssd_buffer_strategy_control->n_usedssd++;
 		return ssd_buf_hdr;
@@ -95,10 +96,10 @@ getLRUBuffer()
 	SSDBufferTag	old_tag = ssd_buf_hdr->ssd_buf_tag;
 	if (DEBUG)
 		printf("[INFO] SSDBufferAlloc(): old_flag&SSD_BUF_DIRTY=%d\n", old_flag & SSD_BUF_DIRTY);
-	if (old_flag & SSD_BUF_DIRTY != 0) {
+	if ((old_flag & SSD_BUF_DIRTY) != 0) {
 		flushSSDBuffer(ssd_buf_hdr);
 	}
-	if (old_flag & SSD_BUF_VALID != 0) {
+	if ((old_flag & SSD_BUF_VALID) != 0) {
 		unsigned long	old_hash = ssdbuftableHashcode(&old_tag);
 		ssdbuftableDelete(&old_tag, old_hash);
 	}
@@ -20,5 +20,6 @@ SSDBufferStrategyControlForLRU *ssd_buffer_strategy_control_for_lru;
 extern unsigned long flush_fifo_times;
 
 extern void initSSDBufferForLRU();
+extern void initSSDBufferDescForLRU(long ssd_buf_id);
 extern SSDBufferDesc *getLRUBuffer();
 extern void *hitInLRUBuffer(SSDBufferDesc *);
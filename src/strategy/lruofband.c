@@ -4,12 +4,15 @@
 #include "smr-simulator/smr-simulator.h"
 #include "lruofband.h"
 #include "band_table.h"
+#include "band_hotness.h"
 
 static volatile void *addToLRUofBandHead(SSDBufferDescForLRUofBand * ssd_buf_hdr_for_lruofband);
 static volatile void *deleteFromLRUofBand(SSDBufferDescForLRUofBand * ssd_buf_hdr_for_lruofband);
 static volatile void *moveToLRUofBandHead(SSDBufferDescForLRUofBand * ssd_buf_hdr_for_lruofband);
 static volatile void *addToBand(SSDBufferTag ssd_buf_tag, long freessd);
 static volatile void *getSSDBufferofBand(SSDBufferTag ssd_buf_tag);
+static SSDBufferDesc *getLRUofBandVictim();
+static void	initBandDesc(long band_id);
 
 void 
 initSSDBufferForLRUofBand()
@@ -20,43 +23,63 @@ initSSDBufferForLRUofBand()
 	ssd_buffer_strategy_control_for_lruofband->first_lru = -1;
 	ssd_buffer_strategy_control_for_lruofband->last_lru = -1;
 
-	SSDBufferDescForLRUofBand *ssd_buf_hdr_for_lruofband;
-	ssd_buffer_descriptors_for_lruofband = (SSDBufferDescForLRUofBand *) malloc(sizeof(SSDBufferDescForLRUofBand) * NSSDBuffers);
-	long		i;
-	ssd_buf_hdr_for_lruofband = ssd_buffer_descriptors_for_lruofband;
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_lruofband++, i++) {
-		ssd_buf_hdr_for_lruofband->ssd_buf_id = i;
-		ssd_buf_hdr_for_lruofband->next_lru = -1;
-		ssd_buf_hdr_for_lruofband->last_lru = -1;
-		ssd_buf_hdr_for_lruofband->next_ssd_buf = -1;
-	}
+	ssd_buffer_descriptors_for_lruofband = (SSDBufferDescForLRUofBand *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForLRUofBand));
 
 	flush_fifo_times = 0;
 
-	band_descriptors = (BandDesc *) malloc(sizeof(BandDesc) * NSSDBuffers);
-	BandDesc       *temp_band_desc;
-	temp_band_desc = band_descriptors;
-
-	for (i = 0; i < NSSDBuffers; temp_band_desc++, i++) {
-		band_descriptors[i].band_num = -1;
-        band_descriptors[i].current_pages = 0;
-		band_descriptors[i].first_page = -1;
-		band_descriptors[i].next_free_band = i + 1;
-	}
-	band_descriptors[i].next_free_band = -1;
+	band_descriptors = (BandDesc *) allocSSDArray(NSSDBuffers, sizeof(BandDesc));
 	band_control = (BandControl *) malloc(sizeof(BandControl));
 	band_control->first_freeband = 0;
 	band_control->last_freeband = NSSDBuffers - 1;
 	band_control->n_usedband = 0;
+	band_control->n_initband = 0;
+	initBandDesc(0);
+}
+
+void
+initSSDBufferDescForLRUofBand(long ssd_buf_id)
+{
+	SSDBufferDescForLRUofBand *ssd_buf_hdr_for_lruofband = &ssd_buffer_descriptors_for_lruofband[ssd_buf_id];
+
+	ssd_buf_hdr_for_lruofband->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_lruofband->next_lru = -1;
+	ssd_buf_hdr_for_lruofband->last_lru = -1;
+	ssd_buf_hdr_for_lruofband->next_ssd_buf = -1;
+}
+
+static void
+initBandDesc(long band_id)
+{
+	band_descriptors[band_id].band_num = -1;
+	band_descriptors[band_id].current_pages = 0;
+	band_descriptors[band_id].first_page = -1;
+	band_descriptors[band_id].next_free_band = band_id + 1 < NSSDBuffers ? band_id + 1 : -1;
+	band_control->n_initband = band_id + 1;
+}
 
+/*
+ * take the head of the band free list, also used by WA
+ */
+long
+takeFreeBand()
+{
+	long		band_id = band_control->first_freeband;
+
+	band_control->first_freeband = band_descriptors[band_id].next_free_band;
+	band_descriptors[band_id].next_free_band = -1;
+	if (band_control->first_freeband >= 0 && band_control->first_freeband == band_control->n_initband)
+		initBandDesc(band_control->n_initband);
+	return band_id;
 }
 
 static volatile void *
 addToLRUofBandHead(SSDBufferDescForLRUofBand * ssd_buf_hdr_for_lruofband)
 {
-	if (ssd_buffer_strategy_control->n_usedssd == 0) {
+	if (ssd_buffer_strategy_control_for_lruofband->first_lru < 0) {
 		ssd_buffer_strategy_control_for_lruofband->first_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
 		ssd_buffer_strategy_control_for_lruofband->last_lru = ssd_buf_hdr_for_lruofband->ssd_buf_id;
+		ssd_buf_hdr_for_lruofband->next_lru = -1;
+		ssd_buf_hdr_for_lruofband->last_lru = -1;
 	} else {
 		ssd_buf_hdr_for_lruofband->next_lru = ssd_buffer_descriptors_for_lruofband[ssd_buffer_strategy_control_for_lruofband->first_lru].ssd_buf_id;
 		ssd_buf_hdr_for_lruofband->last_lru = -1;
@@ -102,10 +125,8 @@ addToBand(SSDBufferTag ssd_buf_tag, long first_freessd)
 		new_ssd_buf_for_lruofband->next_ssd_buf = ssd_buf_for_lruofband->next_ssd_buf;
 		ssd_buf_for_lruofband->next_ssd_buf = first_freessd;
 	} else {
-		long		temp_first_freeband = band_control->first_freeband;
+		long		temp_first_freeband = takeFreeBand();
 		bandtableInsert(band_num, band_hash, temp_first_freeband, &band_hashtable_for_lruofband);
-		band_control->first_freeband = band_descriptors[temp_first_freeband].next_free_band;
-		band_descriptors[temp_first_freeband].next_free_band = -1;
 		band_descriptors[temp_first_freeband].current_pages = 1;
 		band_descriptors[temp_first_freeband].band_num = band_num;
 		band_descriptors[temp_first_freeband].first_page = first_freessd;
@@ -132,18 +153,17 @@ getSSDBufferofBand(SSDBufferTag ssd_buf_tag)
 		ssd_buf_for_lruofband = &ssd_buffer_descriptors_for_lruofband[first_page];
 		ssd_buf_hdr = &ssd_buffer_descriptors[first_page];
 
-		ssd_buf_hdr->next_freessd = ssd_buffer_strategy_control->first_freessd;
-		ssd_buffer_strategy_control->first_freessd = first_page;
+		putFreeSSDBuffer(ssd_buf_hdr);
 		first_page = ssd_buf_for_lruofband->next_ssd_buf;
 
 		deleteFromLRUofBand(ssd_buf_for_lruofband);
 
 		old_flag = ssd_buf_hdr->ssd_buf_flag;
 		old_tag = ssd_buf_hdr->ssd_buf_tag;
-		if (old_flag & SSD_BUF_DIRTY != 0) {
+		if ((old_flag & SSD_BUF_DIRTY) != 0) {
 			flushSSDBuffer(ssd_buf_hdr);
 		}
-		if (old_flag & SSD_BUF_VALID != 0) {
+		if ((old_flag & SSD_BUF_VALID) != 0) {
 			old_hash = ssdbuftableHashcode(&old_tag);
 			ssdbuftableDelete(&old_tag, old_hash);
 		}
@@ -155,6 +175,29 @@ getSSDBufferofBand(SSDBufferTag ssd_buf_tag)
 	band_control->first_freeband = band_id;
 }
 
+/*
+ * a block of the band to evict: the least recently used one, or with
+ * BAND_HOTNESS the one of the BAND_HOTNESS_CANDIDATES least recently used
+ * blocks whose band is coldest
+ */
+static SSDBufferDesc *
+getLRUofBandVictim()
+{
+	long		ssd_buf_id = ssd_buffer_strategy_control_for_lruofband->last_lru;
+	long		victim = ssd_buf_id, n;
+	unsigned long	hotness, coldest = -1;
+
+	for (n = 0; BAND_HOTNESS && ssd_buf_id >= 0 && n < BAND_HOTNESS_CANDIDATES; n++) {
+		hotness = getBandHotness(GetSMRBandNumFromSSD(ssd_buffer_descriptors[ssd_buf_id].ssd_buf_tag.offset));
+		if (hotness < coldest) {
+			coldest = hotness;
+			victim = ssd_buf_id;
+		}
+		ssd_buf_id = ssd_buffer_descriptors_for_lruofband[ssd_buf_id].last_lru;
+	}
+	return &ssd_buffer_descriptors[victim];
+}
+
 SSDBufferDesc  *
 getLRUofBandBuffer(SSDBufferTag ssd_buf_tag)
 {
@@ -162,7 +205,7 @@ getLRUofBandBuffer(SSDBufferTag ssd_buf_tag)
 	SSDBufferDescForLRUofBand *ssd_buf_hdr_for_lruofband;
 	if (ssd_buffer_strategy_control->first_freessd < 0) {
 		flush_fifo_times++;
-		ssd_buffer_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control_for_lruofband->last_lru];
+		ssd_buffer_hdr = getLRUofBandVictim();
 		getSSDBufferofBand(ssd_buffer_hdr->ssd_buf_tag);
 	}
 	ssd_buffer_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
@@ -170,8 +213,7 @@ getLRUofBandBuffer(SSDBufferTag ssd_buf_tag)
 	ssd_buffer_hdr->ssd_buf_tag = ssd_buf_tag;
 	addToBand(ssd_buf_tag, ssd_buffer_strategy_control->first_freessd);
 
-	ssd_buffer_strategy_control->first_freessd = ssd_buffer_hdr->next_freessd;
-	ssd_buffer_hdr->next_freessd = -1;
+	takeFreeSSDBuffer(ssd_buffer_hdr);
 	addToLRUofBandHead(ssd_buf_hdr_for_lruofband);
 	ssd_buffer_strategy_control->n_usedssd++;
 	return ssd_buffer_hdr;
@@ -31,6 +31,8 @@ typedef struct {
 	long		first_freeband;
 	long		last_freeband;
 	long		n_usedband;
+	long		n_initband;
+	              //band descriptors [0, n_initband) have been set up
 }		BandControl;
 
 extern unsigned long NBANDTables;
@@ -43,5 +45,7 @@ BandControl    *band_control;
 BandHashBucket *band_hashtable_for_lruofband;
 
 void		initSSDBufferForLRUofBand();
+void		initSSDBufferDescForLRUofBand(long ssd_buf_id);
+long		takeFreeBand();
 SSDBufferDesc  *getLRUofBandBuffer(SSDBufferTag);
 void           *hinInLRUofBandBuffer(SSDBufferDesc *);
@@ -4,80 +4,170 @@
 #include "smr-simulator/smr-simulator.h"
 #include "most.h"
 #include "band_table.h"
+#include "band_hotness.h"
 
 static volatile void addToBand(SSDBufferTag ssd_buf_tag, long freessd);
 static volatile void deleteBand();
+static long getMostVictim();
+static void initBandDescForMost(long band_id);
+static volatile void siftUpForMost(long heap_pos);
+static volatile void siftDownForMost(long heap_pos);
 
-void 
+void
 initSSDBufferForMost()
 {
 	initBandTable(NBANDTables, &band_hashtable_for_most);
 
-	SSDBufferDescForMost *ssd_buf_hdr_for_most;
-	BandDescForMost *band_hdr_for_most;
-	ssd_buffer_descriptors_for_most = (SSDBufferDescForMost *) malloc(sizeof(SSDBufferDescForMost) * NSSDBuffers);
-	long		i;
-	ssd_buf_hdr_for_most = ssd_buffer_descriptors_for_most;
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_most++, i++) {
-		ssd_buf_hdr_for_most->ssd_buf_id = i;
-		ssd_buf_hdr_for_most->next_ssd_buf = -1;
-	}
+	ssd_buffer_descriptors_for_most = (SSDBufferDescForMost *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForMost));
+	band_descriptors_for_most = (BandDescForMost *) allocSSDArray(NSMRBands, sizeof(BandDescForMost));
 
-	band_descriptors_for_most = (BandDescForMost *) malloc(sizeof(BandDescForMost) * NSMRBands);
-	band_hdr_for_most = band_descriptors_for_most;
-	for (i = 0; i < NSMRBands; band_hdr_for_most++, i++) {
-		band_hdr_for_most->band_num = 0;
-		band_hdr_for_most->current_pages = 0;
-		band_hdr_for_most->first_page = -1;
-	}
+	band_heap_for_most = (long *) malloc(sizeof(long) * NSMRBands);
 
 	ssd_buffer_strategy_control_for_most = (SSDBufferStrategyControlForMost *) malloc(sizeof(SSDBufferStrategyControlForMost));
 	ssd_buffer_strategy_control_for_most->nbands = 0;
+	ssd_buffer_strategy_control_for_most->first_freeband = 0;
+	ssd_buffer_strategy_control_for_most->n_initband = 0;
+	initBandDescForMost(0);
+}
+
+void
+initSSDBufferDescForMost(long ssd_buf_id)
+{
+	SSDBufferDescForMost *ssd_buf_hdr_for_most = &ssd_buffer_descriptors_for_most[ssd_buf_id];
+
+	ssd_buf_hdr_for_most->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_most->next_ssd_buf = -1;
+}
+
+static void
+initBandDescForMost(long band_id)
+{
+	BandDescForMost *band_hdr_for_most = &band_descriptors_for_most[band_id];
+
+	band_hdr_for_most->band_num = -1;
+	band_hdr_for_most->current_pages = 0;
+	band_hdr_for_most->first_page = -1;
+	band_hdr_for_most->heap_pos = -1;
+	band_hdr_for_most->next_free_band = band_id + 1 < NSMRBands ? band_id + 1 : -1;
+	ssd_buffer_strategy_control_for_most->n_initband = band_id + 1;
 }
 
-void 
+void
 hitInMostBuffer()
 {
 	return;
 }
 
+/*
+ * move the band at heap_pos towards the root while it has more pages than its parent
+ */
 static volatile void
-deleteBand()
+siftUpForMost(long heap_pos)
 {
-	BandDescForMost	band_hdr_for_most;
-	BandDescForMost	temp;
-
-	band_hdr_for_most = band_descriptors_for_most[0];
-	temp = band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1];
-	long		parent = 0;
-	long		child = parent * 2 + 1;
-	while (child < ssd_buffer_strategy_control_for_most->nbands) {
-		if (child < ssd_buffer_strategy_control_for_most->nbands && band_descriptors_for_most[child].current_pages < band_descriptors_for_most[child + 1].current_pages)
+	long		band_id = band_heap_for_most[heap_pos];
+	long		current_pages = band_descriptors_for_most[band_id].current_pages;
+	long		parent;
+
+	while (heap_pos > 0) {
+		parent = (heap_pos - 1) / 2;
+		if (band_descriptors_for_most[band_heap_for_most[parent]].current_pages >= current_pages)
+			break;
+		band_heap_for_most[heap_pos] = band_heap_for_most[parent];
+		band_descriptors_for_most[band_heap_for_most[heap_pos]].heap_pos = heap_pos;
+		heap_pos = parent;
+	}
+	band_heap_for_most[heap_pos] = band_id;
+	band_descriptors_for_most[band_id].heap_pos = heap_pos;
+}
+
+/*
+ * move the band at heap_pos towards the leaves while a child has more pages
+ */
+static volatile void
+siftDownForMost(long heap_pos)
+{
+	long		nbands = ssd_buffer_strategy_control_for_most->nbands;
+	long		band_id = band_heap_for_most[heap_pos];
+	long		current_pages = band_descriptors_for_most[band_id].current_pages;
+	long		child;
+
+	while ((child = heap_pos * 2 + 1) < nbands) {
+		if (child + 1 < nbands && band_descriptors_for_most[band_heap_for_most[child]].current_pages < band_descriptors_for_most[band_heap_for_most[child + 1]].current_pages)
 			child++;
-		if (temp.current_pages >= band_descriptors_for_most[child].current_pages)
+		if (current_pages >= band_descriptors_for_most[band_heap_for_most[child]].current_pages)
 			break;
-		else {
-			band_descriptors_for_most[parent] = band_descriptors_for_most[child];
-			long		band_hash = bandtableHashcode(band_descriptors_for_most[child].band_num);
-			bandtableDelete(band_descriptors_for_most[child].band_num, band_hash, &band_hashtable_for_most);
-			bandtableInsert(band_descriptors_for_most[child].band_num, band_hash, parent, &band_hashtable_for_most);
-			parent = child;
-			child = child * 2 + 1;
-		}
+		band_heap_for_most[heap_pos] = band_heap_for_most[child];
+		band_descriptors_for_most[band_heap_for_most[heap_pos]].heap_pos = heap_pos;
+		heap_pos = child;
+	}
+	band_heap_for_most[heap_pos] = band_id;
+	band_descriptors_for_most[band_id].heap_pos = heap_pos;
+}
+
+/*
+ * take a band out of the heap and the band hash table and give its descriptor back;
+ * the band's pages are left to the caller
+ */
+void
+removeBandFromMost(long band_id)
+{
+	BandDescForMost *band_hdr_for_most = &band_descriptors_for_most[band_id];
+	long		heap_pos = band_hdr_for_most->heap_pos;
+	long		last;
+	long		moved_band_id;
+
+	if (heap_pos < 0) {
+		printf("[ERROR] removeBandFromMost():-------band is not cached: band_id=%ld\n", band_id);
+		exit(-1);
 	}
-	band_descriptors_for_most[parent] = temp;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].band_num = -1;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].current_pages = 0;
-	band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].first_page = -1;
 	ssd_buffer_strategy_control_for_most->nbands--;
-	long		band_hash = bandtableHashcode(temp.band_num);
-	bandtableDelete(temp.band_num, band_hash, &band_hashtable_for_most);
-	bandtableInsert(temp.band_num, band_hash, parent, &band_hashtable_for_most);
+	last = ssd_buffer_strategy_control_for_most->nbands;
+	if (heap_pos != last) {
+		moved_band_id = band_heap_for_most[last];
+		band_heap_for_most[heap_pos] = moved_band_id;
+		band_descriptors_for_most[moved_band_id].heap_pos = heap_pos;
+		siftDownForMost(heap_pos);
+		siftUpForMost(band_descriptors_for_most[moved_band_id].heap_pos);
+	}
 
-	long		band_num = band_hdr_for_most.band_num;
-	band_hash = bandtableHashcode(band_num);
-	long		band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_most);
-	long		first_page = band_hdr_for_most.first_page;
+	bandtableDelete(band_hdr_for_most->band_num, bandtableHashcode(band_hdr_for_most->band_num), &band_hashtable_for_most);
+	band_hdr_for_most->band_num = -1;
+	band_hdr_for_most->current_pages = 0;
+	band_hdr_for_most->first_page = -1;
+	band_hdr_for_most->heap_pos = -1;
+	band_hdr_for_most->next_free_band = ssd_buffer_strategy_control_for_most->first_freeband;
+	ssd_buffer_strategy_control_for_most->first_freeband = band_id;
+}
+
+/*
+ * the band to evict: the one with the most pages, or with BAND_HOTNESS the
+ * one with the most pages per unit of hotness among the first
+ * BAND_HOTNESS_CANDIDATES of the heap, the largest bands but for a few
+ */
+static long
+getMostVictim()
+{
+	long		heap_pos, band_id, victim = band_heap_for_most[0];
+	double		pages_per_hotness, best = -1;
+
+	for (heap_pos = 0; BAND_HOTNESS && heap_pos < ssd_buffer_strategy_control_for_most->nbands && heap_pos < BAND_HOTNESS_CANDIDATES; heap_pos++) {
+		band_id = band_heap_for_most[heap_pos];
+		pages_per_hotness = band_descriptors_for_most[band_id].current_pages / (1.0 + getBandHotness(band_descriptors_for_most[band_id].band_num));
+		if (pages_per_hotness > best) {
+			best = pages_per_hotness;
+			victim = band_id;
+		}
+	}
+	return victim;
+}
+
+static volatile void
+deleteBand()
+{
+	long		band_id = getMostVictim();
+	long		first_page = band_descriptors_for_most[band_id].first_page;
+
+	removeBandFromMost(band_id);
 
 	SSDBufferTag	old_tag;
 	unsigned char	old_flag;
@@ -87,23 +177,21 @@ deleteBand()
 	while (first_page >= 0) {
 		ssd_buf_hdr = &ssd_buffer_descriptors[first_page];
 
-		ssd_buf_hdr->next_freessd = ssd_buffer_strategy_control->first_freessd;
-		ssd_buffer_strategy_control->first_freessd = first_page;
+		putFreeSSDBuffer(ssd_buf_hdr);
 		first_page = ssd_buffer_descriptors_for_most[first_page].next_ssd_buf;
-		ssd_buffer_descriptors_for_most[ssd_buffer_strategy_control->first_freessd].next_ssd_buf = -1;
+		ssd_buffer_descriptors_for_most[ssd_buf_hdr->ssd_buf_id].next_ssd_buf = -1;
 
 		old_flag = ssd_buf_hdr->ssd_buf_flag;
 		old_tag = ssd_buf_hdr->ssd_buf_tag;
-		if (old_flag & SSD_BUF_DIRTY != 0) {
+		if ((old_flag & SSD_BUF_DIRTY) != 0) {
 			flushSSDBuffer(ssd_buf_hdr);
 		}
-		if (old_flag & SSD_BUF_VALID != 0) {
+		if ((old_flag & SSD_BUF_VALID) != 0) {
 			old_hash = ssdbuftableHashcode(&old_tag);
 			ssdbuftableDelete(&old_tag, old_hash);
 		}
 		ssd_buffer_strategy_control->n_usedssd--;
 	}
-	bandtableDelete(band_num, band_hash, &band_hashtable_for_most);
 }
 
 static volatile void
@@ -114,43 +202,39 @@ addToBand(SSDBufferTag ssd_buf_tag, long first_freessd)
 	long		band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_most);
 
 	SSDBufferDescForMost *ssd_buf_for_most;
+	SSDBufferDescForMost *new_ssd_buf_for_most;
 	BandDescForMost *band_hdr_for_most;
 
 	if (band_id >= 0) {
-		//printf("hit band %ld\n", band_num);
-		long		first_page = band_descriptors_for_most[band_id].first_page;
-		ssd_buf_for_most = &ssd_buffer_descriptors_for_most[first_page];
-		SSDBufferDescForMost *new_ssd_buf_for_most;
+		band_hdr_for_most = &band_descriptors_for_most[band_id];
+		ssd_buf_for_most = &ssd_buffer_descriptors_for_most[band_hdr_for_most->first_page];
 		new_ssd_buf_for_most = &ssd_buffer_descriptors_for_most[first_freessd];
 		new_ssd_buf_for_most->next_ssd_buf = ssd_buf_for_most->next_ssd_buf;
 		ssd_buf_for_most->next_ssd_buf = first_freessd;
 
-		band_descriptors_for_most[band_id].current_pages++;
-		BandDescForMost	temp;
-		long		parent = (band_id - 1) / 2;
-		long		child = band_id;
-		while (parent >= 0 && band_descriptors_for_most[child].current_pages > band_descriptors_for_most[parent].current_pages) {
-			temp = band_descriptors_for_most[child];
-			band_descriptors_for_most[child] = band_descriptors_for_most[parent];
-			band_hash = bandtableHashcode(band_descriptors_for_most[parent].band_num);
-			bandtableDelete(band_descriptors_for_most[parent].band_num, band_hash, &band_hashtable_for_most);
-			bandtableInsert(band_descriptors_for_most[parent].band_num, band_hash, child, &band_hashtable_for_most);
-			band_descriptors_for_most[parent] = temp;
-			band_hash = bandtableHashcode(temp.band_num);
-			bandtableDelete(temp.band_num, band_hash, &band_hashtable_for_most);
-			bandtableInsert(temp.band_num, band_hash, parent, &band_hashtable_for_most);
-			child = parent;
-			parent = (child - 1) / 2;
-		}
+		band_hdr_for_most->current_pages++;
+		siftUpForMost(band_hdr_for_most->heap_pos);
 	} else {
-		ssd_buffer_strategy_control_for_most->nbands++;
-		band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].band_num = band_num;
-		band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].current_pages = 1;
-		band_descriptors_for_most[ssd_buffer_strategy_control_for_most->nbands - 1].first_page = first_freessd;
-		bandtableInsert(band_num, band_hash, ssd_buffer_strategy_control_for_most->nbands - 1, &band_hashtable_for_most);
-		SSDBufferDescForMost *new_ssd_buf_for_most;
+		band_id = ssd_buffer_strategy_control_for_most->first_freeband;
+		if (band_id < 0) {
+			printf("[ERROR] addToBand():-------no free band descriptor for Most: band_num=%ld\n", band_num);
+			exit(-1);
+		}
+		band_hdr_for_most = &band_descriptors_for_most[band_id];
+		ssd_buffer_strategy_control_for_most->first_freeband = band_hdr_for_most->next_free_band;
+		band_hdr_for_most->next_free_band = -1;
+		if (ssd_buffer_strategy_control_for_most->first_freeband >= 0 && ssd_buffer_strategy_control_for_most->first_freeband == ssd_buffer_strategy_control_for_most->n_initband)
+			initBandDescForMost(ssd_buffer_strategy_control_for_most->n_initband);
+		band_hdr_for_most->band_num = band_num;
+		band_hdr_for_most->current_pages = 1;
+		band_hdr_for_most->first_page = first_freessd;
+		bandtableInsert(band_num, band_hash, band_id, &band_hashtable_for_most);
 		new_ssd_buf_for_most = &ssd_buffer_descriptors_for_most[first_freessd];
 		new_ssd_buf_for_most->next_ssd_buf = -1;
+
+		band_heap_for_most[ssd_buffer_strategy_control_for_most->nbands] = band_id;
+		ssd_buffer_strategy_control_for_most->nbands++;
+		siftUpForMost(ssd_buffer_strategy_control_for_most->nbands - 1);
 	}
 }
 
@@ -167,8 +251,7 @@ getMostBuffer(SSDBufferTag ssd_buf_tag)
 	}
 	addToBand(ssd_buf_tag, first_freessd);
 	ssd_buffer_hdr = &ssd_buffer_descriptors[first_freessd];
-	ssd_buffer_strategy_control->first_freessd = ssd_buffer_hdr->next_freessd;
-	ssd_buffer_hdr->next_freessd = -1;
+	takeFreeSSDBuffer(ssd_buffer_hdr);
 	ssd_buffer_strategy_control->n_usedssd++;
 	return ssd_buffer_hdr;
 }
@@ -10,14 +10,18 @@ typedef struct
 
 typedef struct
 {
-	unsigned long band_num;
-	unsigned long current_pages;
-	unsigned long first_page;
+	long band_num;
+	long current_pages;
+	long first_page;
+	long heap_pos;          // position of this band in band_heap_for_most, -1 if not cached
+	long next_free_band;
 } BandDescForMost;
 
 typedef struct
 {
     long        nbands;          // # of cached bands
+    long        first_freeband;  // Head of list of free band descriptors
+    long        n_initband;      // band descriptors [0, n_initband) have been set up
 } SSDBufferStrategyControlForMost;
 
 extern unsigned long NBANDTables;
@@ -25,9 +29,12 @@ extern unsigned long NSMRBands;
 
 SSDBufferDescForMost *ssd_buffer_descriptors_for_most;
 BandDescForMost *band_descriptors_for_most;
+long *band_heap_for_most;         // max-heap of band ids ordered by current_pages
 SSDBufferStrategyControlForMost *ssd_buffer_strategy_control_for_most;
 BandHashBucket *band_hashtable_for_most;
 
 void initSSDBufferForMost();
+void initSSDBufferDescForMost(long ssd_buf_id);
 SSDBufferDesc *getMostBuffer(SSDBufferTag);
 void hitInMostBuffer();
+void removeBandFromMost(long band_id);
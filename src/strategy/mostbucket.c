@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "ssd_buf_table.h"
+#include "mostbucket.h"
+#include "band_table.h"
+
+static volatile void addToBucket(long band_id);
+static volatile void deleteFromBucket(long band_id);
+static volatile void addToBand(SSDBufferTag ssd_buf_tag, long freessd);
+static volatile void deleteBand();
+static void initBandDescForMostBucket(long band_id);
+
+/*
+ * Same victim choice as Most (the band with the largest current_pages),
+ * but bands are kept in buckets indexed by current_pages instead of a heap.
+ */
+void
+initSSDBufferForMostBucket()
+{
+	initBandTable(NBANDTables, &band_hashtable_for_mostbucket);
+
+	ssd_buffer_descriptors_for_mostbucket = (SSDBufferDescForMostBucket *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForMostBucket));
+	band_descriptors_for_mostbucket = (BandDescForMostBucket *) allocSSDArray(NSMRBands, sizeof(BandDescForMostBucket));
+
+	ssd_buffer_strategy_control_for_mostbucket = (SSDBufferStrategyControlForMostBucket *) malloc(sizeof(SSDBufferStrategyControlForMostBucket));
+	ssd_buffer_strategy_control_for_mostbucket->nbands = 0;
+	ssd_buffer_strategy_control_for_mostbucket->first_freeband = 0;
+	ssd_buffer_strategy_control_for_mostbucket->n_initband = 0;
+	initBandDescForMostBucket(0);
+	ssd_buffer_strategy_control_for_mostbucket->nbuckets = BNDSZ / BLCKSZ + 1;
+	ssd_buffer_strategy_control_for_mostbucket->max_pages = 0;
+
+	long		i;
+	band_buckets_for_mostbucket = (BandBucketForMost *) malloc(sizeof(BandBucketForMost) * ssd_buffer_strategy_control_for_mostbucket->nbuckets);
+	for (i = 0; i < ssd_buffer_strategy_control_for_mostbucket->nbuckets; i++) {
+		band_buckets_for_mostbucket[i].first_band = -1;
+		band_buckets_for_mostbucket[i].last_band = -1;
+	}
+}
+
+void
+initSSDBufferDescForMostBucket(long ssd_buf_id)
+{
+	SSDBufferDescForMostBucket *ssd_buf_hdr_for_mostbucket = &ssd_buffer_descriptors_for_mostbucket[ssd_buf_id];
+
+	ssd_buf_hdr_for_mostbucket->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_mostbucket->next_ssd_buf = -1;
+}
+
+static void
+initBandDescForMostBucket(long band_id)
+{
+	BandDescForMostBucket *band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+
+	band_hdr_for_mostbucket->band_num = -1;
+	band_hdr_for_mostbucket->current_pages = 0;
+	band_hdr_for_mostbucket->first_page = -1;
+	band_hdr_for_mostbucket->next_band = -1;
+	band_hdr_for_mostbucket->last_band = -1;
+	band_hdr_for_mostbucket->next_free_band = band_id + 1 < NSMRBands ? band_id + 1 : -1;
+	ssd_buffer_strategy_control_for_mostbucket->n_initband = band_id + 1;
+}
+
+void
+hitInMostBucketBuffer()
+{
+	return;
+}
+
+static volatile void
+addToBucket(long band_id)
+{
+	BandDescForMostBucket *band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+	long		current_pages = band_hdr_for_mostbucket->current_pages;
+	BandBucketForMost *bucket;
+
+	if (current_pages >= ssd_buffer_strategy_control_for_mostbucket->nbuckets) {
+		printf("[ERROR] addToBucket():-------current_pages(%ld) exceeds pages per band: band_num=%ld\n", current_pages, band_hdr_for_mostbucket->band_num);
+		exit(-1);
+	}
+	bucket = &band_buckets_for_mostbucket[current_pages];
+	band_hdr_for_mostbucket->last_band = -1;
+	band_hdr_for_mostbucket->next_band = bucket->first_band;
+	if (bucket->first_band >= 0)
+		band_descriptors_for_mostbucket[bucket->first_band].last_band = band_id;
+	else
+		bucket->last_band = band_id;
+	bucket->first_band = band_id;
+	if (current_pages > ssd_buffer_strategy_control_for_mostbucket->max_pages)
+		ssd_buffer_strategy_control_for_mostbucket->max_pages = current_pages;
+}
+
+static volatile void
+deleteFromBucket(long band_id)
+{
+	BandDescForMostBucket *band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+	BandBucketForMost *bucket = &band_buckets_for_mostbucket[band_hdr_for_mostbucket->current_pages];
+
+	if (band_hdr_for_mostbucket->last_band >= 0)
+		band_descriptors_for_mostbucket[band_hdr_for_mostbucket->last_band].next_band = band_hdr_for_mostbucket->next_band;
+	else
+		bucket->first_band = band_hdr_for_mostbucket->next_band;
+	if (band_hdr_for_mostbucket->next_band >= 0)
+		band_descriptors_for_mostbucket[band_hdr_for_mostbucket->next_band].last_band = band_hdr_for_mostbucket->last_band;
+	else
+		bucket->last_band = band_hdr_for_mostbucket->last_band;
+	band_hdr_for_mostbucket->next_band = -1;
+	band_hdr_for_mostbucket->last_band = -1;
+}
+
+static volatile void
+deleteBand()
+{
+	long		max_pages = ssd_buffer_strategy_control_for_mostbucket->max_pages;
+	long		band_id = band_buckets_for_mostbucket[max_pages].last_band;
+	BandDescForMostBucket *band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+	long		band_num = band_hdr_for_mostbucket->band_num;
+	long		first_page = band_hdr_for_mostbucket->first_page;
+
+	deleteFromBucket(band_id);
+	while (max_pages > 0 && band_buckets_for_mostbucket[max_pages].first_band < 0)
+		max_pages--;
+	ssd_buffer_strategy_control_for_mostbucket->max_pages = max_pages;
+	ssd_buffer_strategy_control_for_mostbucket->nbands--;
+
+	bandtableDelete(band_num, bandtableHashcode(band_num), &band_hashtable_for_mostbucket);
+	band_hdr_for_mostbucket->band_num = -1;
+	band_hdr_for_mostbucket->current_pages = 0;
+	band_hdr_for_mostbucket->first_page = -1;
+	band_hdr_for_mostbucket->next_free_band = ssd_buffer_strategy_control_for_mostbucket->first_freeband;
+	ssd_buffer_strategy_control_for_mostbucket->first_freeband = band_id;
+
+	SSDBufferTag	old_tag;
+	unsigned char	old_flag;
+	unsigned long	old_hash;
+	SSDBufferDesc  *ssd_buf_hdr;
+
+	while (first_page >= 0) {
+		ssd_buf_hdr = &ssd_buffer_descriptors[first_page];
+
+		putFreeSSDBuffer(ssd_buf_hdr);
+		first_page = ssd_buffer_descriptors_for_mostbucket[first_page].next_ssd_buf;
+		ssd_buffer_descriptors_for_mostbucket[ssd_buf_hdr->ssd_buf_id].next_ssd_buf = -1;
+
+		old_flag = ssd_buf_hdr->ssd_buf_flag;
+		old_tag = ssd_buf_hdr->ssd_buf_tag;
+		if ((old_flag & SSD_BUF_DIRTY) != 0) {
+			flushSSDBuffer(ssd_buf_hdr);
+		}
+		if ((old_flag & SSD_BUF_VALID) != 0) {
+			old_hash = ssdbuftableHashcode(&old_tag);
+			ssdbuftableDelete(&old_tag, old_hash);
+		}
+		ssd_buffer_strategy_control->n_usedssd--;
+	}
+}
+
+static volatile void
+addToBand(SSDBufferTag ssd_buf_tag, long first_freessd)
+{
+	long		band_num = GetSMRBandNumFromSSD(ssd_buf_tag.offset);
+	unsigned long	band_hash = bandtableHashcode(band_num);
+	long		band_id = bandtableLookup(band_num, band_hash, band_hashtable_for_mostbucket);
+
+	SSDBufferDescForMostBucket *ssd_buf_for_mostbucket;
+	SSDBufferDescForMostBucket *new_ssd_buf_for_mostbucket;
+	BandDescForMostBucket *band_hdr_for_mostbucket;
+
+	if (band_id >= 0) {
+		band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+		ssd_buf_for_mostbucket = &ssd_buffer_descriptors_for_mostbucket[band_hdr_for_mostbucket->first_page];
+		new_ssd_buf_for_mostbucket = &ssd_buffer_descriptors_for_mostbucket[first_freessd];
+		new_ssd_buf_for_mostbucket->next_ssd_buf = ssd_buf_for_mostbucket->next_ssd_buf;
+		ssd_buf_for_mostbucket->next_ssd_buf = first_freessd;
+
+		deleteFromBucket(band_id);
+		band_hdr_for_mostbucket->current_pages++;
+		addToBucket(band_id);
+	} else {
+		band_id = ssd_buffer_strategy_control_for_mostbucket->first_freeband;
+		if (band_id < 0) {
+			printf("[ERROR] addToBand():-------no free band descriptor for Most_Bucket: band_num=%ld\n", band_num);
+			exit(-1);
+		}
+		band_hdr_for_mostbucket = &band_descriptors_for_mostbucket[band_id];
+		ssd_buffer_strategy_control_for_mostbucket->first_freeband = band_hdr_for_mostbucket->next_free_band;
+		band_hdr_for_mostbucket->next_free_band = -1;
+		if (ssd_buffer_strategy_control_for_mostbucket->first_freeband >= 0 && ssd_buffer_strategy_control_for_mostbucket->first_freeband == ssd_buffer_strategy_control_for_mostbucket->n_initband)
+			initBandDescForMostBucket(ssd_buffer_strategy_control_for_mostbucket->n_initband);
+		band_hdr_for_mostbucket->band_num = band_num;
+		band_hdr_for_mostbucket->current_pages = 1;
+		band_hdr_for_mostbucket->first_page = first_freessd;
+		bandtableInsert(band_num, band_hash, band_id, &band_hashtable_for_mostbucket);
+		new_ssd_buf_for_mostbucket = &ssd_buffer_descriptors_for_mostbucket[first_freessd];
+		new_ssd_buf_for_mostbucket->next_ssd_buf = -1;
+
+		addToBucket(band_id);
+		ssd_buffer_strategy_control_for_mostbucket->nbands++;
+	}
+}
+
+SSDBufferDesc  *
+getMostBucketBuffer(SSDBufferTag ssd_buf_tag)
+{
+	SSDBufferDesc  *ssd_buffer_hdr;
+	long		first_freessd = ssd_buffer_strategy_control->first_freessd;
+
+	if (first_freessd < 0) {
+		deleteBand();
+		first_freessd = ssd_buffer_strategy_control->first_freessd;
+	}
+	addToBand(ssd_buf_tag, first_freessd);
+	ssd_buffer_hdr = &ssd_buffer_descriptors[first_freessd];
+	takeFreeSSDBuffer(ssd_buffer_hdr);
+	ssd_buffer_strategy_control->n_usedssd++;
+	return ssd_buffer_hdr;
+}
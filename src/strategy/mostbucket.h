@@ -0,0 +1,48 @@
+#define DEBUG 0
+/*-------------------------------Most (bucket)----------------------------*/
+#include <band_table.h>
+
+typedef struct
+{
+	long ssd_buf_id;//ssd buffer location in shared buffer
+	long next_ssd_buf;
+} SSDBufferDescForMostBucket;
+
+typedef struct
+{
+	long band_num;
+	long current_pages;
+	long first_page;
+	long next_band;         // to link bands with the same current_pages
+	long last_band;         // to link bands with the same current_pages
+	long next_free_band;
+} BandDescForMostBucket;
+
+typedef struct
+{
+	long first_band;        // most recently filled band with this many pages
+	long last_band;         // oldest band with this many pages, evicted first
+} BandBucketForMost;
+
+typedef struct
+{
+    long        nbands;          // # of cached bands
+    long        first_freeband;  // Head of list of free band descriptors
+    long        n_initband;      // band descriptors [0, n_initband) have been set up
+    long        nbuckets;        // pages per band + 1
+    long        max_pages;       // highest non-empty bucket, 0 if none
+} SSDBufferStrategyControlForMostBucket;
+
+extern unsigned long NBANDTables;
+extern unsigned long NSMRBands;
+
+SSDBufferDescForMostBucket *ssd_buffer_descriptors_for_mostbucket;
+BandDescForMostBucket *band_descriptors_for_mostbucket;
+BandBucketForMost *band_buckets_for_mostbucket;     // band lists indexed by current_pages
+SSDBufferStrategyControlForMostBucket *ssd_buffer_strategy_control_for_mostbucket;
+BandHashBucket *band_hashtable_for_mostbucket;
+
+void initSSDBufferForMostBucket();
+void initSSDBufferDescForMostBucket(long ssd_buf_id);
+SSDBufferDesc *getMostBucketBuffer(SSDBufferTag);
+void hitInMostBucketBuffer();
@@ -10,29 +10,37 @@ static volatile void* moveToSCANHead(SSDBufferDescForSCAN *ssd_buf_hdr_for_scan)
 
 /*
  * init buffer hash table, strategy_control, buffer, work_mem
+ *
+ * Used buffers are kept in a skip list ordered by offset. Level 0 is the
+ * full doubly linked list the scan pointer walks, so advancing the pointer
+ * is O(1); insert and delete search the upper levels in O(log n).
  */
 void initSSDBufferForSCAN()
 {
 	ssd_buffer_strategy_control_for_scan = (SSDBufferStrategyControlForSCAN *) malloc(sizeof(SSDBufferStrategyControlForSCAN));
 	ssd_buffer_strategy_control_for_scan->scan_ptr = -1;
-	ssd_buffer_strategy_control_for_scan->start= -1;  
- // ssd_buffer_strategy_control_for_scan->last_scan = -1;
+	ssd_buffer_strategy_control_for_scan->nlevels = 1;
+	ssd_buffer_strategy_control_for_scan->level_seed = 1;
 
-	ssd_buffer_descriptors_for_scan = (SSDBufferDescForSCAN *) malloc(sizeof(SSDBufferDescForSCAN)*NSSDBuffers);
-	SSDBufferDescForSCAN *ssd_buf_hdr_for_scan;
-	//ssd_buf_hdr_for_scan is a pointer
-	long i;
-	ssd_buf_hdr_for_scan = ssd_buffer_descriptors_for_scan;
-	
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_scan++, i++) {
-		ssd_buf_hdr_for_scan->ssd_buf_id = i;
-        ssd_buf_hdr_for_scan->next_scan = -1;
-        ssd_buf_hdr_for_scan->last_scan = -1;
-
-	}
+	ssd_buffer_descriptors_for_scan = (SSDBufferDescForSCAN *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescForSCAN));
+	long level;
+	for (level = 0; level < SCAN_MAX_LEVEL; level++)
+		ssd_buffer_strategy_control_for_scan->start[level] = -1;
 	flush_fifo_times = 0;
 }
 
+void initSSDBufferDescForSCAN(long ssd_buf_id)
+{
+	SSDBufferDescForSCAN *ssd_buf_hdr_for_scan = &ssd_buffer_descriptors_for_scan[ssd_buf_id];
+	long level;
+
+	ssd_buf_hdr_for_scan->ssd_buf_id = ssd_buf_id;
+	for (level = 0; level < SCAN_MAX_LEVEL; level++)
+		ssd_buf_hdr_for_scan->next_scan[level] = -1;
+	ssd_buf_hdr_for_scan->last_scan = -1;
+	ssd_buf_hdr_for_scan->nlevels = 0;
+}
+
 static volatile void* addToSCANHead(SSDBufferDescForSCAN *ssd_buf_hdr_for_scan)
 {
   /*  if (ssd_buffer_strategy_control->n_usedssd == 0) {
@@ -50,103 +58,101 @@ ssd_buf_hdr_for_scan 指针->
     return NULL;
 */
 }
-void output(){
-	SSDBufferDescForSCAN *ssd_buf_hdr_for_scan;
-	//ssd_buf_hdr_for_scan is a pointer
-	long i;
-	ssd_buf_hdr_for_scan = ssd_buffer_descriptors_for_scan;
-	
-	for (i = 0; i < NSSDBuffers; ssd_buf_hdr_for_scan++, i++) {
-	  printf("ssd_buf_id %ld",ssd_buf_hdr_for_scan->ssd_buf_id);
-      	  printf("next_scan %ld",ssd_buf_hdr_for_scan->next_scan);
-      	  printf("last_scan %ld\n",ssd_buf_hdr_for_scan->last_scan);
-	}
-	for(int j = 0 ; j < NSSDBuffers; j++){
-	 printf("ssd_buf_tag no.%d tag is %ld\n",j,ssd_buffer_descriptors[j].ssd_buf_tag.offset);
+/* a new buffer gets level k+1 with probability 1/4^k */
+static long
+randomLevel()
+{
+	long		level = 1;
+	unsigned long	seed = ssd_buffer_strategy_control_for_scan->level_seed;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	ssd_buffer_strategy_control_for_scan->level_seed = seed;
+	while (level < SCAN_MAX_LEVEL && (seed & 3) == 0) {
+		level++;
+		seed >>= 2;
 	}
-	printf("scanptr %ld\n",ssd_buffer_strategy_control_for_scan->scan_ptr);
-	printf("start %ld\n",ssd_buffer_strategy_control_for_scan->start);
+	return level;
+}
 
+/* next buffer after ssd_buf_id on the given level, ssd_buf_id -1 is the head */
+static long
+nextOnLevel(long ssd_buf_id, long level)
+{
+	if (ssd_buf_id < 0)
+		return ssd_buffer_strategy_control_for_scan->start[level];
+	return ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan[level];
+}
 
+static void
+setNextOnLevel(long ssd_buf_id, long level, long next)
+{
+	if (ssd_buf_id < 0)
+		ssd_buffer_strategy_control_for_scan->start[level] = next;
+	else
+		ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan[level] = next;
 }
+
 void insertByTag(SSDBufferTag ssd_buf_tag, long ssd_buf_id){
-		printf("start %ld\n",ssd_buffer_strategy_control_for_scan->start);
-	if(ssd_buffer_strategy_control_for_scan->start == -1){
-		ssd_buffer_strategy_control_for_scan->start = ssd_buf_id;
-		ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buf_id;
-//		printf("insert %ld",ssd_buffer_strategy_control_for_scan->start);	
-//		printf("check that should be -1 %ld\n",ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan);
-	}
-	else{
-
-	long movePtr;
-	movePtr = ssd_buffer_strategy_control_for_scan->start;
-	if(ssd_buffer_descriptors[movePtr].ssd_buf_tag.offset > ssd_buf_tag.offset){
-		printf("ENTER HERE\n");
-		ssd_buffer_descriptors_for_scan[movePtr].last_scan = ssd_buf_id;
-		ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan = movePtr;
-		ssd_buffer_strategy_control_for_scan -> start = ssd_buf_id;	
-	}else{
-
-	while(ssd_buffer_descriptors[movePtr].ssd_buf_tag.offset <= ssd_buf_tag.offset){
-//		printf("%ld, %ld\n", ssd_buffer_descriptors[movePtr].ssd_buf_tag.offset,ssd_buf_tag.offset );
-		
-		if(ssd_buffer_descriptors_for_scan[movePtr].next_scan!=-1){
-//printf("movePtr before %ld\n",movePtr);
-		long next = ssd_buffer_descriptors_for_scan[movePtr].next_scan;
-			if(ssd_buffer_descriptors[next].ssd_buf_tag.offset<= ssd_buf_tag.offset){
-				movePtr = next;
-				}
-			else
-				break;
-//printf("movePtr %ld\n",movePtr);
-		}
-		else
-			break;
-		}
-	long  temp ;
-	temp = ssd_buffer_descriptors_for_scan[movePtr].next_scan;
-	ssd_buffer_descriptors_for_scan[movePtr].next_scan = ssd_buf_id;
-	ssd_buffer_descriptors_for_scan[ssd_buf_id].last_scan =	ssd_buffer_descriptors_for_scan[movePtr].ssd_buf_id;
-	if(temp!=-1){
-		ssd_buffer_descriptors_for_scan[temp].last_scan =  ssd_buf_id;
-		ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan = temp;
-	}else{
-		ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan = temp;
-	}
+	SSDBufferDescForSCAN *ssd_buf_hdr_for_scan = &ssd_buffer_descriptors_for_scan[ssd_buf_id];
+	long		update[SCAN_MAX_LEVEL];
+	long		movePtr = -1;
+	long		next, level, nlevels;
+
+	for (level = ssd_buffer_strategy_control_for_scan->nlevels - 1; level >= 0; level--) {
+		while ((next = nextOnLevel(movePtr, level)) >= 0 && ssd_buffer_descriptors[next].ssd_buf_tag.offset <= ssd_buf_tag.offset)
+			movePtr = next;
+		update[level] = movePtr;
 	}
 
-}
-output();
+	nlevels = randomLevel();
+	for (level = ssd_buffer_strategy_control_for_scan->nlevels; level < nlevels; level++)
+		update[level] = -1;
+	if (nlevels > ssd_buffer_strategy_control_for_scan->nlevels)
+		ssd_buffer_strategy_control_for_scan->nlevels = nlevels;
+
+	ssd_buf_hdr_for_scan->nlevels = nlevels;
+	for (level = 0; level < nlevels; level++) {
+		ssd_buf_hdr_for_scan->next_scan[level] = nextOnLevel(update[level], level);
+		setNextOnLevel(update[level], level, ssd_buf_id);
+	}
+	ssd_buf_hdr_for_scan->last_scan = update[0];
+	if (ssd_buf_hdr_for_scan->next_scan[0] >= 0)
+		ssd_buffer_descriptors_for_scan[ssd_buf_hdr_for_scan->next_scan[0]].last_scan = ssd_buf_id;
 
+	if (ssd_buffer_strategy_control_for_scan->scan_ptr < 0)
+		ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buf_id;
 }
 
 static volatile void* deleteFromSCAN(long ssd_buf_id)
 {
-	long last;
-	long next;	
-	last = ssd_buffer_descriptors_for_scan[ssd_buf_id].last_scan;
-	next = ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan;
-
-	ssd_buffer_descriptors_for_scan[last].next_scan = ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan;
-	ssd_buffer_descriptors_for_scan[next].last_scan = ssd_buffer_descriptors_for_scan[ssd_buf_id].last_scan;
-	ssd_buffer_descriptors_for_scan[ssd_buf_id].last_scan = -1;
-	ssd_buffer_descriptors_for_scan[ssd_buf_id].next_scan = -1;
-
-/*    if (ssd_buf_hdr_for_scan->last_scan >= 0) {
-        ssd_buffer_descriptors_for_scan[ssd_buf_hdr_for_scan->last_scan].next_scan=ssd_buf_hdr_for_scan->next_scan;
-    } else {
-        ssd_buffer_strategy_control_for_scan->first_scan = ssd_buf_hdr_for_scan->next_scan;
-    }
-    if (ssd_buf_hdr_for_scan->next_scan >= 0 ) {
-       ssd_buffer_descriptors_for_scan[ssd_buf_hdr_for_scan->next_scan].last_scan=ssd_buf_hdr_for_scan->last_scan;
-    } else {
-        ssd_buffer_strategy_control_for_scan->last_scan = ssd_buf_hdr_for_scan->last_scan;
-    }
-    ssd_buffer_strategy_control->n_usedssd --;
-
-    return NULL;
-*/
+	SSDBufferDescForSCAN *ssd_buf_hdr_for_scan = &ssd_buffer_descriptors_for_scan[ssd_buf_id];
+	long		offset = ssd_buffer_descriptors[ssd_buf_id].ssd_buf_tag.offset;
+	long		movePtr = -1;
+	long		next, level;
+
+	for (level = ssd_buffer_strategy_control_for_scan->nlevels - 1; level >= 0; level--) {
+		while ((next = nextOnLevel(movePtr, level)) >= 0 && next != ssd_buf_id && ssd_buffer_descriptors[next].ssd_buf_tag.offset <= offset)
+			movePtr = next;
+		if (level < ssd_buf_hdr_for_scan->nlevels) {
+			if (next != ssd_buf_id) {
+				printf("[ERROR] deleteFromSCAN():-------ssd_buf_id=%ld not found on level %ld\n", ssd_buf_id, level);
+				exit(-1);
+			}
+			setNextOnLevel(movePtr, level, ssd_buf_hdr_for_scan->next_scan[level]);
+			ssd_buf_hdr_for_scan->next_scan[level] = -1;
+		}
+	}
+	next = nextOnLevel(movePtr, 0);
+	if (next >= 0)
+		ssd_buffer_descriptors_for_scan[next].last_scan = movePtr;
+	while (ssd_buffer_strategy_control_for_scan->nlevels > 1 && ssd_buffer_strategy_control_for_scan->start[ssd_buffer_strategy_control_for_scan->nlevels - 1] < 0)
+		ssd_buffer_strategy_control_for_scan->nlevels--;
+	ssd_buf_hdr_for_scan->last_scan = -1;
+	ssd_buf_hdr_for_scan->nlevels = 0;
+
+	return NULL;
 }
 
 static volatile void* moveToSCANHead(SSDBufferDescForSCAN *ssd_buf_hdr_for_scan)
@@ -166,31 +172,28 @@ SSDBufferDesc *getSCANBuffer(SSDBufferTag ssd_buf_tag)
 	if(ssd_buffer_strategy_control->first_freessd <0){
 		flush_fifo_times++;
 		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control_for_scan->scan_ptr];
-		if(ssd_buf_hdr->ssd_buf_id == ssd_buffer_strategy_control_for_scan->start){
-			ssd_buffer_strategy_control_for_scan->start = ssd_buffer_descriptors_for_scan[ssd_buffer_strategy_control_for_scan->scan_ptr].next_scan;	
-		}	
 /*if the next is -1*/
-		if(ssd_buffer_descriptors_for_scan[ssd_buffer_strategy_control_for_scan->scan_ptr].next_scan != -1){
-			ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buffer_descriptors_for_scan[ssd_buffer_strategy_control_for_scan->scan_ptr].next_scan;
+		if(ssd_buffer_descriptors_for_scan[ssd_buf_hdr->ssd_buf_id].next_scan[0] != -1){
+			ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buffer_descriptors_for_scan[ssd_buf_hdr->ssd_buf_id].next_scan[0];
 		}else{
-	//		ssd_buffer_descriptors_for_scan[ssd_buffer_descriptors_for_scan[ssd_buffer_strategy_control_for_scan->scan_ptr].
-			ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buffer_strategy_control_for_scan->start;
+			ssd_buffer_strategy_control_for_scan->scan_ptr = ssd_buffer_strategy_control_for_scan->start[0];
 		}
 		
  		unsigned char   old_flag = ssd_buf_hdr->ssd_buf_flag;
         	SSDBufferTag    old_tag = ssd_buf_hdr->ssd_buf_tag;
         	if (DEBUG)
                 	printf("[INFO] SSDBufferAlloc(): old_flag&SSD_BUF_DIRTY=%d\n", old_flag & SSD_BUF_DIRTY);
-        	if (old_flag & SSD_BUF_DIRTY != 0) {
+        	if ((old_flag & SSD_BUF_DIRTY) != 0) {
                 	flushSSDBuffer(ssd_buf_hdr);
        		}
-        	if (old_flag & SSD_BUF_VALID != 0) {
+        	if ((old_flag & SSD_BUF_VALID) != 0) {
                 	unsigned long   old_hash = ssdbuftableHashcode(&old_tag);
                 	ssdbuftableDelete(&old_tag, old_hash);
         	}
 		deleteFromSCAN(ssd_buf_hdr->ssd_buf_id);
-		ssd_buf_hdr->next_freessd = ssd_buffer_strategy_control->first_freessd; 
-		ssd_buffer_strategy_control->first_freessd = ssd_buf_hdr->ssd_buf_id;
+		if (ssd_buffer_strategy_control_for_scan->scan_ptr == ssd_buf_hdr->ssd_buf_id)
+			ssd_buffer_strategy_control_for_scan->scan_ptr = -1;
+		putFreeSSDBuffer(ssd_buf_hdr);
 					
 	}
 
@@ -199,8 +202,7 @@ SSDBufferDesc *getSCANBuffer(SSDBufferTag ssd_buf_tag)
 	//	printf("Enter freessd\n");
 		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
 		ssd_buf_hdr_for_scan = &ssd_buffer_descriptors_for_scan[ssd_buffer_strategy_control->first_freessd];
-		ssd_buffer_strategy_control->first_freessd = ssd_buf_hdr->next_freessd;
-		ssd_buf_hdr->next_freessd = -1;
+		takeFreeSSDBuffer(ssd_buf_hdr);
 		// request has known tag
 		insertByTag(ssd_buf_tag,ssd_buf_hdr->ssd_buf_id);
 	        return ssd_buf_hdr;
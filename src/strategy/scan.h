@@ -5,17 +5,22 @@
 /* ---------------------------scan---------------------------- */
 #include <band_table.h>
 
+#define SCAN_MAX_LEVEL 16			// skip list levels, enough for 4^16 buffers
+
 typedef struct
 {
 	long 		ssd_buf_id;				// ssd buffer location in shared buffer
-    long        next_scan;               // to link used ssd as SCAN
-    long        last_scan;               // to link used ssd as SCAN
+    long        next_scan[SCAN_MAX_LEVEL]; // skip list by offset, next_scan[0] links every used ssd
+    long        last_scan;               // previous used ssd on level 0
+    long        nlevels;                 // # of levels this buffer is linked on
 } SSDBufferDescForSCAN;
 
 typedef struct
 {
-	long start;
-    long        scan_ptr;        
+	long        start[SCAN_MAX_LEVEL];   // first buffer on each level, start[0] has the smallest offset
+    long        scan_ptr;                // next buffer to evict, advances by offset
+    long        nlevels;                 // highest level in use
+    unsigned long level_seed;
 } SSDBufferStrategyControlForSCAN;
 
 SSDBufferDescForSCAN	*ssd_buffer_descriptors_for_scan;
@@ -24,7 +29,8 @@ BandHashBucket *band_hashtable;
 
 extern unsigned long flush_fifo_times;
 extern void initSSDBufferForSCAN();
+extern void initSSDBufferDescForSCAN(long ssd_buf_id);
 extern SSDBufferDesc *getSCANBuffer();
 extern void *hitInSCANBuffer(SSDBufferDesc *);
-extern void insertByTag();
+extern void insertByTag(SSDBufferTag ssd_buf_tag, long ssd_buf_id);
 #endif
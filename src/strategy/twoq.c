@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "ssd_buf_table.h"
+#include "twoq.h"
+#include "band_table.h"
+
+static volatile void *addTo2QHead(SSDBufferDescFor2Q * ssd_buf_hdr_for_2q, unsigned twoq_list);
+static volatile void *deleteFrom2Q(SSDBufferDescFor2Q * ssd_buf_hdr_for_2q);
+static volatile void *addGhostTo2QHead(SSDBufferTag ghost_tag);
+static volatile void *deleteGhostFrom2Q(long ghost_id);
+static SSDBufferDesc *reclaim2QBuffer();
+static void	initGhostDescFor2Q(long ghost_id);
+
+/*
+ * Full 2Q (Johnson & Shasha, VLDB'94).
+ * New blocks enter the A1in FIFO; blocks evicted from A1in leave their tag in
+ * the A1out ghost FIFO, and only a miss that finds its tag in A1out goes to the
+ * Am LRU. One-touch scans therefore never displace Am.
+ */
+void
+initSSDBufferFor2Q()
+{
+	initBandTable(NBANDTables, &ghost_hashtable_for_2q);
+
+	ssd_buffer_strategy_control_for_2q = (SSDBufferStrategyControlFor2Q *) malloc(sizeof(SSDBufferStrategyControlFor2Q));
+	long		i;
+	for (i = 0; i < 4; i++) {
+		ssd_buffer_strategy_control_for_2q->first_lru[i] = -1;
+		ssd_buffer_strategy_control_for_2q->last_lru[i] = -1;
+		ssd_buffer_strategy_control_for_2q->nlist[i] = 0;
+	}
+	ssd_buffer_strategy_control_for_2q->kin = NSSDBuffers * KIN_PERCENT_2Q / 100;
+	if (ssd_buffer_strategy_control_for_2q->kin < 1)
+		ssd_buffer_strategy_control_for_2q->kin = 1;
+	ssd_buffer_strategy_control_for_2q->kout = NSSDBuffers * KOUT_PERCENT_2Q / 100;
+	if (ssd_buffer_strategy_control_for_2q->kout > NSSDBuffers)
+		ssd_buffer_strategy_control_for_2q->kout = NSSDBuffers;
+	ssd_buffer_strategy_control_for_2q->first_freeghost = 0;
+	ssd_buffer_strategy_control_for_2q->n_initghost = 0;
+
+	ssd_buffer_descriptors_for_2q = (SSDBufferDescFor2Q *) allocSSDArray(NSSDBuffers, sizeof(SSDBufferDescFor2Q));
+	ghost_descriptors_for_2q = (GhostDescFor2Q *) allocSSDArray(NSSDBuffers, sizeof(GhostDescFor2Q));
+	initGhostDescFor2Q(0);
+	flush_fifo_times = 0;
+}
+
+void
+initSSDBufferDescFor2Q(long ssd_buf_id)
+{
+	SSDBufferDescFor2Q *ssd_buf_hdr_for_2q = &ssd_buffer_descriptors_for_2q[ssd_buf_id];
+
+	ssd_buf_hdr_for_2q->ssd_buf_id = ssd_buf_id;
+	ssd_buf_hdr_for_2q->next_2q = -1;
+	ssd_buf_hdr_for_2q->last_2q = -1;
+	ssd_buf_hdr_for_2q->twoq_list = 0;
+}
+
+/* ghost_id has just become the head of the free ghost list */
+static void
+initGhostDescFor2Q(long ghost_id)
+{
+	GhostDescFor2Q *ghost_hdr_for_2q = &ghost_descriptors_for_2q[ghost_id];
+
+	ghost_hdr_for_2q->ghost_id = ghost_id;
+	ghost_hdr_for_2q->next_ghost = ghost_id + 1 < NSSDBuffers ? ghost_id + 1 : -1;
+	ghost_hdr_for_2q->last_ghost = -1;
+	ssd_buffer_strategy_control_for_2q->n_initghost = ghost_id + 1;
+}
+
+static volatile void *
+addTo2QHead(SSDBufferDescFor2Q * ssd_buf_hdr_for_2q, unsigned twoq_list)
+{
+	SSDBufferStrategyControlFor2Q *control = ssd_buffer_strategy_control_for_2q;
+
+	ssd_buf_hdr_for_2q->twoq_list = twoq_list;
+	ssd_buf_hdr_for_2q->last_2q = -1;
+	ssd_buf_hdr_for_2q->next_2q = control->first_lru[twoq_list];
+	if (control->first_lru[twoq_list] >= 0)
+		ssd_buffer_descriptors_for_2q[control->first_lru[twoq_list]].last_2q = ssd_buf_hdr_for_2q->ssd_buf_id;
+	else
+		control->last_lru[twoq_list] = ssd_buf_hdr_for_2q->ssd_buf_id;
+	control->first_lru[twoq_list] = ssd_buf_hdr_for_2q->ssd_buf_id;
+	control->nlist[twoq_list]++;
+
+	return NULL;
+}
+
+static volatile void *
+deleteFrom2Q(SSDBufferDescFor2Q * ssd_buf_hdr_for_2q)
+{
+	SSDBufferStrategyControlFor2Q *control = ssd_buffer_strategy_control_for_2q;
+	unsigned	twoq_list = ssd_buf_hdr_for_2q->twoq_list;
+
+	if (ssd_buf_hdr_for_2q->last_2q >= 0)
+		ssd_buffer_descriptors_for_2q[ssd_buf_hdr_for_2q->last_2q].next_2q = ssd_buf_hdr_for_2q->next_2q;
+	else
+		control->first_lru[twoq_list] = ssd_buf_hdr_for_2q->next_2q;
+	if (ssd_buf_hdr_for_2q->next_2q >= 0)
+		ssd_buffer_descriptors_for_2q[ssd_buf_hdr_for_2q->next_2q].last_2q = ssd_buf_hdr_for_2q->last_2q;
+	else
+		control->last_lru[twoq_list] = ssd_buf_hdr_for_2q->last_2q;
+	ssd_buf_hdr_for_2q->next_2q = -1;
+	ssd_buf_hdr_for_2q->last_2q = -1;
+	ssd_buf_hdr_for_2q->twoq_list = 0;
+	control->nlist[twoq_list]--;
+
+	return NULL;
+}
+
+static volatile void *
+addGhostTo2QHead(SSDBufferTag ghost_tag)
+{
+	SSDBufferStrategyControlFor2Q *control = ssd_buffer_strategy_control_for_2q;
+	GhostDescFor2Q *ghost_hdr_for_2q;
+	long		ghost_num = ghost_tag.offset / SSD_BUFFER_SIZE;
+
+	if (control->kout == 0)
+		return NULL;
+	if (control->nlist[TWOQ_A1OUT] >= control->kout || control->first_freeghost < 0)
+		deleteGhostFrom2Q(control->last_lru[TWOQ_A1OUT]);
+	ghost_hdr_for_2q = &ghost_descriptors_for_2q[control->first_freeghost];
+	control->first_freeghost = ghost_hdr_for_2q->next_ghost;
+	if (control->first_freeghost >= 0 && control->first_freeghost == control->n_initghost)
+		initGhostDescFor2Q(control->n_initghost);
+
+	ghost_hdr_for_2q->ghost_tag = ghost_tag;
+	ghost_hdr_for_2q->last_ghost = -1;
+	ghost_hdr_for_2q->next_ghost = control->first_lru[TWOQ_A1OUT];
+	if (control->first_lru[TWOQ_A1OUT] >= 0)
+		ghost_descriptors_for_2q[control->first_lru[TWOQ_A1OUT]].last_ghost = ghost_hdr_for_2q->ghost_id;
+	else
+		control->last_lru[TWOQ_A1OUT] = ghost_hdr_for_2q->ghost_id;
+	control->first_lru[TWOQ_A1OUT] = ghost_hdr_for_2q->ghost_id;
+	control->nlist[TWOQ_A1OUT]++;
+	bandtableInsert(ghost_num, bandtableHashcode(ghost_num), ghost_hdr_for_2q->ghost_id, &ghost_hashtable_for_2q);
+
+	return NULL;
+}
+
+static volatile void *
+deleteGhostFrom2Q(long ghost_id)
+{
+	SSDBufferStrategyControlFor2Q *control = ssd_buffer_strategy_control_for_2q;
+	GhostDescFor2Q *ghost_hdr_for_2q = &ghost_descriptors_for_2q[ghost_id];
+	long		ghost_num = ghost_hdr_for_2q->ghost_tag.offset / SSD_BUFFER_SIZE;
+
+	if (ghost_hdr_for_2q->last_ghost >= 0)
+		ghost_descriptors_for_2q[ghost_hdr_for_2q->last_ghost].next_ghost = ghost_hdr_for_2q->next_ghost;
+	else
+		control->first_lru[TWOQ_A1OUT] = ghost_hdr_for_2q->next_ghost;
+	if (ghost_hdr_for_2q->next_ghost >= 0)
+		ghost_descriptors_for_2q[ghost_hdr_for_2q->next_ghost].last_ghost = ghost_hdr_for_2q->last_ghost;
+	else
+		control->last_lru[TWOQ_A1OUT] = ghost_hdr_for_2q->last_ghost;
+	control->nlist[TWOQ_A1OUT]--;
+	bandtableDelete(ghost_num, bandtableHashcode(ghost_num), &ghost_hashtable_for_2q);
+
+	ghost_hdr_for_2q->last_ghost = -1;
+	ghost_hdr_for_2q->next_ghost = control->first_freeghost;
+	control->first_freeghost = ghost_id;
+
+	return NULL;
+}
+
+/*
+ * take a free buffer, or evict the tail of A1in (into A1out) or of Am
+ */
+static SSDBufferDesc *
+reclaim2QBuffer()
+{
+	SSDBufferStrategyControlFor2Q *control = ssd_buffer_strategy_control_for_2q;
+	SSDBufferDesc  *ssd_buf_hdr;
+	bool		from_a1in;
+
+	if (ssd_buffer_strategy_control->first_freessd >= 0) {
+		ssd_buf_hdr = &ssd_buffer_descriptors[ssd_buffer_strategy_control->first_freessd];
+		takeFreeSSDBuffer(ssd_buf_hdr);
+		ssd_buffer_strategy_control->n_usedssd++;
+		return ssd_buf_hdr;
+	}
+	flush_fifo_times++;
+	from_a1in = control->nlist[TWOQ_A1IN] > control->kin || control->nlist[TWOQ_AM] == 0;
+	if (from_a1in)
+		ssd_buf_hdr = &ssd_buffer_descriptors[control->last_lru[TWOQ_A1IN]];
+	else
+		ssd_buf_hdr = &ssd_buffer_descriptors[control->last_lru[TWOQ_AM]];
+	deleteFrom2Q(&ssd_buffer_descriptors_for_2q[ssd_buf_hdr->ssd_buf_id]);
+
+	unsigned char	old_flag = ssd_buf_hdr->ssd_buf_flag;
+	SSDBufferTag	old_tag = ssd_buf_hdr->ssd_buf_tag;
+	if (DEBUG)
+		printf("[INFO] SSDBufferAlloc(): old_flag&SSD_BUF_DIRTY=%d\n", old_flag & SSD_BUF_DIRTY);
+	if ((old_flag & SSD_BUF_DIRTY) != 0) {
+		flushSSDBuffer(ssd_buf_hdr);
+	}
+	if ((old_flag & SSD_BUF_VALID) != 0) {
+		unsigned long	old_hash = ssdbuftableHashcode(&old_tag);
+		ssdbuftableDelete(&old_tag, old_hash);
+	}
+	if (from_a1in)
+		addGhostTo2QHead(old_tag);
+
+	return ssd_buf_hdr;
+}
+
+SSDBufferDesc  *
+get2QBuffer(SSDBufferTag ssd_buf_tag)
+{
+	SSDBufferDesc  *ssd_buf_hdr;
+	long		ghost_num = ssd_buf_tag.offset / SSD_BUFFER_SIZE;
+	long		ghost_id = bandtableLookup(ghost_num, bandtableHashcode(ghost_num), ghost_hashtable_for_2q);
+
+	ssd_buf_hdr = reclaim2QBuffer();
+	if (ghost_id >= 0) {
+		/* reclaiming may have pushed this very ghost out of A1out */
+		ghost_id = bandtableLookup(ghost_num, bandtableHashcode(ghost_num), ghost_hashtable_for_2q);
+	}
+	if (ghost_id >= 0) {
+		deleteGhostFrom2Q(ghost_id);
+		addTo2QHead(&ssd_buffer_descriptors_for_2q[ssd_buf_hdr->ssd_buf_id], TWOQ_AM);
+	} else
+		addTo2QHead(&ssd_buffer_descriptors_for_2q[ssd_buf_hdr->ssd_buf_id], TWOQ_A1IN);
+
+	return ssd_buf_hdr;
+}
+
+void           *
+hitIn2QBuffer(SSDBufferDesc * ssd_buf_hdr)
+{
+	SSDBufferDescFor2Q *ssd_buf_hdr_for_2q = &ssd_buffer_descriptors_for_2q[ssd_buf_hdr->ssd_buf_id];
+
+	if (ssd_buf_hdr_for_2q->twoq_list == TWOQ_AM) {
+		deleteFrom2Q(ssd_buf_hdr_for_2q);
+		addTo2QHead(ssd_buf_hdr_for_2q, TWOQ_AM);
+	}
+
+	return NULL;
+}
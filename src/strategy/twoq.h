@@ -0,0 +1,48 @@
+#define DEBUG 0
+/* ---------------------------2q---------------------------- */
+#include <band_table.h>
+
+#define TWOQ_A1IN  1
+#define TWOQ_AM    2
+#define TWOQ_A1OUT 3
+
+typedef struct
+{
+	long 		ssd_buf_id;				// ssd buffer location in shared buffer
+    long        next_2q;                // to link used ssd in A1in or Am
+    long        last_2q;                // to link used ssd in A1in or Am
+    unsigned    twoq_list;              // TWOQ_A1IN or TWOQ_AM, 0 if free
+} SSDBufferDescFor2Q;
+
+typedef struct
+{
+	SSDBufferTag	ghost_tag;          // tag of a block evicted from A1in
+	long		ghost_id;
+	long		next_ghost;             // to link ghosts in A1out, or free ghosts
+	long		last_ghost;
+} GhostDescFor2Q;
+
+typedef struct
+{
+	long		first_lru[4];           // head of each list, indexed by TWOQ_A1IN..TWOQ_A1OUT
+	long		last_lru[4];            // tail of each list
+	long		nlist[4];               // # of entries in each list
+	long		kin;                    // max size of A1in
+	long		kout;                   // max size of A1out
+	long		first_freeghost;
+	long		n_initghost;            // ghosts [0, n_initghost) have been set up
+} SSDBufferStrategyControlFor2Q;
+
+SSDBufferDescFor2Q	*ssd_buffer_descriptors_for_2q;
+GhostDescFor2Q		*ghost_descriptors_for_2q;
+SSDBufferStrategyControlFor2Q *ssd_buffer_strategy_control_for_2q;
+BandHashBucket *ghost_hashtable_for_2q;
+
+extern unsigned long flush_fifo_times;
+extern unsigned long KIN_PERCENT_2Q;
+extern unsigned long KOUT_PERCENT_2Q;
+
+extern void initSSDBufferFor2Q();
+extern void initSSDBufferDescFor2Q(long ssd_buf_id);
+extern SSDBufferDesc *get2QBuffer(SSDBufferTag);
+extern void *hitIn2QBuffer(SSDBufferDesc *);
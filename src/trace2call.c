@@ -2,13 +2,52 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include "ssd-cache.h"
 #include "smr-simulator/smr-simulator.h"
+#include "smr-simulator/zoned.h"
 #include "strategy/clock.h"
 #include "strategy/lru.h"
 #include "strategy/lruofband.h"
 #include "strategy/scan.h"
+#include "strategy/WA.h"
+#include "destage.h"
+#include "checkpoint.h"
+#include "staging.h"
+#include "admission.h"
+#include "strategy/band_hotness.h"
+#include "trace2call.h"
+#include "partition.h"
+
+/*
+ * foreground latency of the write requests in ns, as a histogram: values
+ * below 2 * LATENCY_SUB_BUCKETS have a bucket each, larger ones
+ * LATENCY_SUB_BUCKETS buckets per power of two, so a percentile is off by
+ * at most 1/128
+ */
+#define LATENCY_SUB_BUCKETS 64
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * 59)
+static unsigned long latency_buckets[LATENCY_BUCKETS];
+static unsigned long nlatency;
+static unsigned long max_latency_ns;
+static struct timespec ts_startup;	// process start, set by markStartup()
+static unsigned long nrequests;		// trace lines replayed
+static unsigned long time_to_first_request_us;
+static struct timespec ts_measure;	// replay start, or the end of the warm-up
+
+static void recordLatency(struct timespec *start, struct timespec *end);
+static unsigned long latencyPercentile(unsigned long rank);
+static void reportLatency();
+static void reportSMRDrives(double measure_s);
+static void resetStatistics();
+
+/* called first thing in main(), startup is measured up to the first completed request */
+void
+markStartup()
+{
+	clock_gettime(CLOCK_MONOTONIC, &ts_startup);
+}
 
 void trace_to_iocall(char* trace_file_path) {
 	FILE* trace;
@@ -24,21 +63,21 @@ void trace_to_iocall(char* trace_file_path) {
 	char write_or_read[100];
 	off_t offset;
     size_t size;
-	char* ssd_buffer;
+	char* ssd_buffer = NULL;
+	size_t extent_size = 0;
+	unsigned long nblocks;
 	bool is_first_call = 1;
-	int i;
+	bool is_write;
 	float size_float;
+	struct timespec ts_begin, ts_end;
+	double measure_s;
 
     gettimeofday(&tv_begin, &tz_begin);
     time_begin = tv_begin.tv_sec + tv_begin.tv_usec/1000000.0;
-    int returnCode = posix_memalign(&ssd_buffer,512,sizeof(char)*BLCKSZ);
-        if(returnCode < 0){
-                printf("[ERROR] flushSSDBuffer():--------posix memalign\n");
-                free(ssd_buffer);
-                exit(-1);
-        }
-    while(!feof(trace)) {
-		fscanf(trace, "%lf %c %s %lu %f", &time, &action, write_or_read, &offset, &size_float);
+	clock_gettime(CLOCK_MONOTONIC, &ts_measure);
+	while (fscanf(trace, "%lf %c %s %lu %f", &time, &action, write_or_read, &offset, &size_float) == 5) {
+		if (WARMUP_REQUESTS > 0 && nrequests++ == WARMUP_REQUESTS)
+			resetStatistics();
         //printf("original size : %f\n",size_float);
 	gettimeofday(&tv_now, &tz_now);
         if (DEBUG)
@@ -61,32 +100,188 @@ void trace_to_iocall(char* trace_file_path) {
 	else 
 		size = offset_end - offset;
 //	printf("offset : %lu    size %lu\n",offset,size);
-    	for (i=0; i<BLCKSZ; i++)
-      		ssd_buffer[i] = '1';
-	while (size > 0 ) {
-        	if(strstr(write_or_read, "W")) {
-               	 if (DEBUG)
-       				printf("[INFO] trace_to_iocall():--------wirte offset=%lu\n", offset);
-        		if(BandOrBlock == 0 )
-				write_block(offset, ssd_buffer);
-			else
-				write_band(offset,ssd_buffer);
-     		 } else if(strstr(write_or_read, "R")) {
-        /*       	if (DEBUG)
-       			printf("[INFO] trace_to_iocall():--------read offset=%lu\n", offset);
-        		if(BandOrBlock == 0 )
-				read_block(offset, ssd_buffer);
-       			else
-				read_band(offset,ssd_buffer);
-	 */	 }
-      	offset += BLCKSZ;
-     	size -= BLCKSZ;
-    	}
+	if (size > extent_size) {
+		free(ssd_buffer);
+		if (posix_memalign((void **) &ssd_buffer, 512, size) != 0) {
+			printf("[ERROR] trace_to_iocall():--------posix memalign %lu\n", (unsigned long) size);
+			exit(-1);
+		}
+		extent_size = size;
+		memset(ssd_buffer, '1', size);
+	}
+	/* the whole request in one call, instead of one write_block() per BLCKSZ */
+	if (strstr(write_or_read, "W"))
+		is_write = 1;
+	else if (strstr(write_or_read, "R"))
+		is_write = 0;
+	else
+		continue;
+	if (DEBUG)
+		printf("[INFO] trace_to_iocall():--------%s offset=%lu size=%lu\n", is_write ? "write" : "read", offset, (unsigned long) size);
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	/* a partition takes only the blocks of its own bands */
+	if (CACHE_PARTITIONS > 1)
+		nblocks = accessPartitionExtent(offset, size, ssd_buffer, is_write);
+	else {
+		if (is_write)
+			write_extent(offset, size, ssd_buffer);
+		else
+			read_extent(offset, size, ssd_buffer);
+		nblocks = size / BLCKSZ;
 	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	if (nblocks == 0)
+		continue;
+	request_blocks += nblocks;
+	io_requests++;
+	if (RECORD_LATENCY && is_write)
+		recordLatency(&ts_begin, &ts_end);
+	if (io_requests == 1 && time_to_first_request_us == 0)
+		time_to_first_request_us = (ts_end.tv_sec - ts_startup.tv_sec) * 1000000UL + ts_end.tv_nsec / 1000 - ts_startup.tv_nsec / 1000;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	measure_s = ts_end.tv_sec - ts_measure.tv_sec + (ts_end.tv_nsec - ts_measure.tv_nsec) / 1e9;
     gettimeofday(&tv_now, &tz_now);
     time_now = tv_now.tv_sec + tv_now.tv_usec/1000000.0;
     printf("total run time (s) = %lf\n", time_now - time_begin);
+	collectSMRDriveStats();
 	printf("hit num:%lu   flush_ssd_blocks:%lu flush_fifo_times:%lu flush_fifo_blocks:%lu  flusd_bands:%lu\n ",hit_num,flush_ssd_blocks,flush_fifo_times,flush_fifo_blocks,flush_bands);
+	printf("smr_seeks:%lu seek_distance(MB):%lu smrwrite_band_switches:%lu blocks_per_band_flush:%.2f syscalls_per_band_flush:%.2f read_KB_per_band_flush:%.1f write_KB_per_band_flush:%.1f\n",
+	       smr_seeks, smr_seek_distance / 1024 / 1024, smrwrite_band_switches, flush_bands ? (double) flush_band_blocks / flush_bands : 0,
+	       flush_bands ? (double) flush_band_syscalls / flush_bands : 0, flush_bands ? flush_band_read_bytes / 1024.0 / flush_bands : 0,
+	       flush_bands ? flush_band_write_bytes / 1024.0 / flush_bands : 0);
+	printf("clean_policy:%s band_rmws_per_GB:%.2f clean_stalls:%lu\n", clean_policy_names[CleanPolicy],
+	       flush_fifo_blocks ? flush_bands / (flush_fifo_blocks * (double) BLCKSZ / 1024 / 1024 / 1024) : 0, clean_stalls);
+	if (ZONED_SMR)
+		printf("zoned max_open:%lu zone_resets:%lu zone_rewrite(MB):%.1f zone_finishes:%lu zone_write(MB):%.1f\n",
+		       ZONED_MAX_OPEN, zone_resets, zone_reset_bytes / 1024.0 / 1024.0, zone_finishes, zone_write_bytes / 1024.0 / 1024.0);
+	if (NSMRDrives > 1)
+		reportSMRDrives(measure_s);
+	printf("restore_time(ms):%.3f restored_buffers:%lu checkpoints:%lu journal_records:%lu\n",
+	       restore_time_us / 1000.0, restored_buffers, checkpoint_times, journal_records);
+	printf("time_to_first_request(ms):%.3f\n", time_to_first_request_us / 1000.0);
+	if (STAGING_BUFFER_MB > 0)
+		printf("staging(MB):%lu batch:%lu writes:%lu coalesced:%lu read_hits:%lu ssd_writes:%lu (%.1f%% of direct) ssd_write_calls:%lu\n",
+		       STAGING_BUFFER_MB, STAGING_BATCH_BLOCKS, staging_write_blocks, staging_coalesced_blocks, staging_read_hits,
+		       ssd_write_blocks, staging_write_blocks ? 100.0 * ssd_write_blocks / staging_write_blocks : 0, ssd_write_calls);
+	else
+		printf("ssd_writes:%lu ssd_write_calls:%lu\n", ssd_write_blocks, ssd_write_calls);
+	if (AdmissionPolicy != AdmitAll)
+		printf("admission:%s admitted_blocks:%lu bypassed_blocks:%lu bypassed(%%):%.1f\n", admission_policy_names[AdmissionPolicy],
+		       admitted_blocks, bypassed_blocks, admitted_blocks + bypassed_blocks ? 100.0 * bypassed_blocks / (admitted_blocks + bypassed_blocks) : 0);
+	if (BAND_HOTNESS)
+		reportBandHotness();
+	if (EvictStrategy == WA && WA_AUTOTUNE)
+		printf("wa_tune epochs:%lu threshold:%lu\n", wa_tune_epochs, WRITEAMPLIFICATION);
+	reportSSDWear(measure_s);
+	printf("requests:%lu blocks:%lu iops:%.1f\n", io_requests, request_blocks, measure_s > 0 ? io_requests / measure_s : 0);
+	reportLatency();
 	fclose(trace);
+	free(ssd_buffer);
 	
 }
+
+static void
+recordLatency(struct timespec *start, struct timespec *end)
+{
+	unsigned long	ns = (end->tv_sec - start->tv_sec) * 1000000000UL + end->tv_nsec - start->tv_nsec;
+	unsigned long	shift = 0;
+
+	/* keep the top 7 bits, the bits dropped pick the power of two */
+	while ((ns >> shift) >= 2 * LATENCY_SUB_BUCKETS)
+		shift++;
+	latency_buckets[shift * LATENCY_SUB_BUCKETS + (ns >> shift)]++;
+	if (ns > max_latency_ns)
+		max_latency_ns = ns;
+	nlatency++;
+}
+
+/* the middle of the bucket holding the rank-th smallest latency */
+static unsigned long
+latencyPercentile(unsigned long rank)
+{
+	unsigned long	i, seen = 0, shift;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += latency_buckets[i];
+		if (seen > rank)
+			break;
+	}
+	if (i < LATENCY_SUB_BUCKETS)
+		return i;
+	shift = i / LATENCY_SUB_BUCKETS - 1;
+	return ((i % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS) << shift) + (1UL << shift) / 2;
+}
+
+static void
+reportLatency()
+{
+	if (nlatency == 0)
+		return;
+	printf("destagers:%lu low_watermark:%lu high_watermark:%lu window:%lu destage_blocks:%lu sync_flush_blocks:%lu\n",
+	       NDESTAGERS, DESTAGE_LOW_WATERMARK, DESTAGE_HIGH_WATERMARK, DESTAGE_WINDOW, destage_blocks, sync_flush_blocks);
+	printf("foreground latency (us): p50=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+	       latencyPercentile(nlatency / 2) / 1000.0,
+	       latencyPercentile(nlatency * 99 / 100) / 1000.0,
+	       latencyPercentile(nlatency * 999 / 1000) / 1000.0,
+	       max_latency_ns / 1000.0);
+}
+
+/*
+ * the smr array drive by drive: MB the ssd cache wrote to it and the smr
+ * disk rewrote, per second of the measured replay, and its band RMWs
+ */
+static void
+reportSMRDrives(double measure_s)
+{
+	SMRDriveStats  *stats;
+	long		d;
+
+	printf("smr_drives:%lu smr_write(MB/s):%.1f smr_rewrite(MB/s):%.1f\n", NSMRDrives,
+	       measure_s > 0 ? flush_fifo_blocks * (double) BLCKSZ / 1024 / 1024 / measure_s : 0,
+	       measure_s > 0 ? flush_band_write_bytes / 1024.0 / 1024.0 / measure_s : 0);
+	for (d = 0; d < NSMRDrives; d++) {
+		stats = &smr_drives[d].stats;
+		printf("drive:%ld smr_write(MB/s):%.1f smr_rewrite(MB/s):%.1f band_rmws:%lu band_rmws_per_GB:%.2f clean_stalls:%lu smr_seeks:%lu\n", d,
+		       measure_s > 0 ? stats->flush_fifo_blocks * (double) BLCKSZ / 1024 / 1024 / measure_s : 0,
+		       measure_s > 0 ? stats->flush_band_write_bytes / 1024.0 / 1024.0 / measure_s : 0, stats->flush_bands,
+		       stats->flush_fifo_blocks ? stats->flush_bands / (stats->flush_fifo_blocks * (double) BLCKSZ / 1024 / 1024 / 1024) : 0,
+		       stats->clean_stalls, stats->smr_seeks);
+	}
+}
+
+/*
+ * start the counters over once WARMUP_REQUESTS trace lines have been
+ * replayed, so the report covers the warm cache only
+ */
+static void
+resetStatistics()
+{
+	hit_num = 0;
+	request_blocks = 0;
+	flush_ssd_blocks = 0;
+	flush_fifo_times = 0;
+	resetSMRDriveStats();
+	zone_resets = 0;
+	zone_reset_bytes = 0;
+	zone_finishes = 0;
+	zone_write_bytes = 0;
+	destage_blocks = 0;
+	sync_flush_blocks = 0;
+	ssd_write_blocks = 0;
+	ssd_write_calls = 0;
+	ssd_nand_write_bytes = 0;
+	staging_write_blocks = 0;
+	staging_coalesced_blocks = 0;
+	staging_read_hits = 0;
+	admitted_blocks = 0;
+	bypassed_blocks = 0;
+	band_hotness_touches = 0;
+	band_hotness_queries = 0;
+	band_hotness_halvings = 0;
+	memset(latency_buckets, 0, sizeof(latency_buckets));
+	nlatency = 0;
+	max_latency_ns = 0;
+	io_requests = 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts_measure);
+}
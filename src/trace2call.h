@@ -2,5 +2,10 @@
 /* ---------------------------trace 2 call---------------------------- */
 
 
+extern void markStartup();
 extern void trace_to_iocall(char* trace_file_path);
 extern int BandOrBlock;
+extern unsigned long WARMUP_REQUESTS;
+extern unsigned long RECORD_LATENCY;
+extern unsigned long request_blocks;
+extern unsigned long io_requests;
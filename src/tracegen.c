@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "ssd-cache.h"
+#include "smr-simulator/smr-simulator.h"
+#include "tracegen.h"
+
+#define TRACEGEN_OUT_SIZE (1024 * 1024)
+
+static unsigned long rng_state;
+static unsigned long nslots;		// request-sized slots in the working set
+static unsigned long slot_step;		// coprime to nslots, spreads ranked slots over the working set
+static unsigned long nbands;		// bands that overlap the working set
+static unsigned long band_step;		// coprime to nbands, picks the hot bands
+static unsigned long *band_slots;	// first slot of each band, band_slots[nbands] = nslots
+static unsigned long *stream_slots;
+static double	zipf_hx1, zipf_hn, zipf_s;
+static char	out[TRACEGEN_OUT_SIZE];
+static long	out_len;
+
+static unsigned long nextRandom();
+static double	nextUniform();
+static unsigned long coprimeStep(unsigned long n);
+static double	zipfH(double x, double theta);
+static double	zipfHInverse(double x, double theta);
+static void	initZipf(unsigned long n, double theta);
+static unsigned long nextZipf(unsigned long n, double theta);
+static unsigned long nextSlot();
+static char    *formatUnsigned(char *p, unsigned long v, int width);
+static void	emitRequest(FILE * trace, unsigned long request, unsigned long slot);
+
+/*
+ * Write TRACEGEN_REQUESTS requests in the format trace_to_iocall() replays,
+ * "time Q W|R offset size(KB)", one request of TRACEGEN_REQUEST_KB per line.
+ * Offsets fall in the first TRACEGEN_WORKING_SET_MB of the smr disk and are
+ * chosen by TRACEGEN_PATTERN; TRACEGEN_BURST_PERCENT of the requests instead
+ * start a run of TRACEGEN_BURST_KB from the first byte of a random band. The
+ * same TRACEGEN_SEED always gives the same trace.
+ */
+void
+generateTrace(char *trace_file_path)
+{
+	FILE	       *trace;
+	unsigned long	request_size = TRACEGEN_REQUEST_KB * 1024;
+	unsigned long	working_set = TRACEGEN_WORKING_SET_MB * 1024 * 1024;
+	unsigned long	request, burst_slot, burst_end, i;
+	struct timespec	ts_begin, ts_end;
+
+	if (request_size == 0 || request_size % BLCKSZ != 0 || working_set < request_size) {
+		printf("[ERROR] generateTrace():-------request of %luKB in a working set of %luMB\n", TRACEGEN_REQUEST_KB, TRACEGEN_WORKING_SET_MB);
+		exit(-1);
+	}
+	nslots = working_set / request_size;
+	if (nslots >= 1UL << 32) {
+		printf("[ERROR] generateTrace():-------%lu request slots, at most 2^32\n", nslots);
+		exit(-1);
+	}
+	if ((trace = fopen(trace_file_path, "w")) == NULL) {
+		printf("[ERROR] generateTrace():-------open %s\n", trace_file_path);
+		exit(-1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+
+	rng_state = TRACEGEN_SEED;
+	slot_step = coprimeStep(nslots);
+	nbands = GetSMRBandNumFromSSD(nslots * request_size - 1) + 1;
+	band_step = coprimeStep(nbands);
+	band_slots = (unsigned long *) malloc(sizeof(unsigned long) * (nbands + 1));
+	for (i = 0; i < nbands; i++)
+		band_slots[i] = (GetSMRBandStartFromNum(i) + request_size - 1) / request_size;
+	band_slots[nbands] = nslots;
+	if (TRACEGEN_PATTERN == TRACEGEN_ZIPF)
+		initZipf(nslots, TRACEGEN_ZIPF_THETA);
+	if (TRACEGEN_PATTERN == TRACEGEN_SEQUENTIAL) {
+		if (TRACEGEN_STREAMS == 0)
+			TRACEGEN_STREAMS = 1;
+		stream_slots = (unsigned long *) malloc(sizeof(unsigned long) * TRACEGEN_STREAMS);
+		for (i = 0; i < TRACEGEN_STREAMS; i++)
+			stream_slots[i] = nslots / TRACEGEN_STREAMS * i;
+	}
+	out_len = 0;
+
+	request = 0;
+	while (request < TRACEGEN_REQUESTS) {
+		if (TRACEGEN_BURST_PERCENT > 0 && nextRandom() % 100 < TRACEGEN_BURST_PERCENT) {
+			i = nextRandom() % nbands;
+			burst_slot = band_slots[i];
+			burst_end = burst_slot + TRACEGEN_BURST_KB / TRACEGEN_REQUEST_KB;
+			if (burst_end > band_slots[i + 1])
+				burst_end = band_slots[i + 1];
+			for (; burst_slot < burst_end && request < TRACEGEN_REQUESTS; burst_slot++)
+				emitRequest(trace, request++, burst_slot);
+		} else
+			emitRequest(trace, request++, nextSlot());
+	}
+	fwrite(out, 1, out_len, trace);
+	fclose(trace);
+	free(band_slots);
+	free(stream_slots);
+	stream_slots = NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	printf("[INFO] generateTrace():-------%lu requests to %s in %.3fs, pattern=%d seed=%lu working_set(MB)=%lu bands=%lu\n",
+	       TRACEGEN_REQUESTS, trace_file_path, ts_end.tv_sec - ts_begin.tv_sec + (ts_end.tv_nsec - ts_begin.tv_nsec) / 1e9,
+	       TRACEGEN_PATTERN, TRACEGEN_SEED, TRACEGEN_WORKING_SET_MB, nbands);
+}
+
+/* splitmix64 */
+static unsigned long
+nextRandom()
+{
+	unsigned long	z = (rng_state += 0x9e3779b97f4a7c15UL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+	return z ^ (z >> 31);
+}
+
+/* uniform in [0, 1) */
+static double
+nextUniform()
+{
+	return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static unsigned long
+coprimeStep(unsigned long n)
+{
+	unsigned long	step = 2654435761UL % n, a, b, t;
+
+	for (;; step++) {
+		for (a = n, b = step; b != 0; t = a % b, a = b, b = t);
+		if (a == 1 || n == 1)
+			return step % n;
+	}
+}
+
+/*
+ * zipf ranks 1..n by rejection-inversion (Hormann and Derflinger), a constant
+ * number of log/exp per sample however large n is
+ */
+static double
+zipfH(double x, double theta)
+{
+	double		log_x = log(x);
+	double		t = (1 - theta) * log_x;
+
+	return (fabs(t) > 1e-8 ? expm1(t) / t : 1 + t / 2) * log_x;
+}
+
+static double
+zipfHInverse(double x, double theta)
+{
+	double		t = (1 - theta) * x;
+
+	if (t < -1)
+		t = -1;
+	return exp((fabs(t) > 1e-8 ? log1p(t) / t : 1 - t / 2) * x);
+}
+
+static void
+initZipf(unsigned long n, double theta)
+{
+	zipf_hx1 = zipfH(1.5, theta) - 1;
+	zipf_hn = zipfH(n + 0.5, theta);
+	zipf_s = 2 - zipfHInverse(zipfH(2.5, theta) - exp(-theta * log(2)), theta);
+}
+
+static unsigned long
+nextZipf(unsigned long n, double theta)
+{
+	double		u, x;
+	unsigned long	k;
+
+	for (;;) {
+		u = zipf_hn + nextUniform() * (zipf_hx1 - zipf_hn);
+		x = zipfHInverse(u, theta);
+		k = (unsigned long) (x + 0.5);
+		if (k < 1)
+			k = 1;
+		else if (k > n)
+			k = n;
+		if (k - x <= zipf_s || u >= zipfH(k + 0.5, theta) - exp(-theta * log(k)))
+			return k;
+	}
+}
+
+static unsigned long
+nextSlot()
+{
+	unsigned long	stream, slot, band_num, nhot;
+
+	if (TRACEGEN_PATTERN == TRACEGEN_ZIPF)
+		return (nextZipf(nslots, TRACEGEN_ZIPF_THETA) - 1) * slot_step % nslots;
+	else if (TRACEGEN_PATTERN == TRACEGEN_HOTBAND) {
+		nhot = nbands * TRACEGEN_HOT_BAND_PERCENT / 100;
+		if (nhot < 1)
+			nhot = 1;
+		if (nextRandom() % 100 < TRACEGEN_HOT_ACCESS_PERCENT)
+			band_num = nextRandom() % nhot * band_step % nbands;
+		else
+			band_num = nextRandom() % nbands;
+		if (band_slots[band_num + 1] <= band_slots[band_num])
+			return band_slots[band_num] < nslots ? band_slots[band_num] : nslots - 1;
+		return band_slots[band_num] + nextRandom() % (band_slots[band_num + 1] - band_slots[band_num]);
+	} else if (TRACEGEN_PATTERN == TRACEGEN_SEQUENTIAL) {
+		stream = nextRandom() % TRACEGEN_STREAMS;
+		slot = stream_slots[stream];
+		stream_slots[stream] = (slot + 1) % nslots;
+		return slot;
+	}
+	return nextRandom() % nslots;
+}
+
+static char    *
+formatUnsigned(char *p, unsigned long v, int width)
+{
+	char		digits[20];
+	int		n = 0;
+
+	do {
+		digits[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v > 0);
+	while (n < width--)
+		*p++ = '0';
+	while (n > 0)
+		*p++ = digits[--n];
+	return p;
+}
+
+static void
+emitRequest(FILE * trace, unsigned long request, unsigned long slot)
+{
+	unsigned long	time_us = (request + 1) * TRACEGEN_INTERVAL_US;
+	char	       *p;
+
+	if (out_len > TRACEGEN_OUT_SIZE - 128) {
+		fwrite(out, 1, out_len, trace);
+		out_len = 0;
+	}
+	p = out + out_len;
+	p = formatUnsigned(p, time_us / 1000000, 0);
+	*p++ = '.';
+	p = formatUnsigned(p, time_us % 1000000, 6);
+	*p++ = ' ';
+	*p++ = 'Q';
+	*p++ = ' ';
+	*p++ = TRACEGEN_READ_PERCENT > 0 && nextRandom() % 100 < TRACEGEN_READ_PERCENT ? 'R' : 'W';
+	*p++ = ' ';
+	p = formatUnsigned(p, slot * TRACEGEN_REQUEST_KB * 1024, 0);
+	*p++ = ' ';
+	p = formatUnsigned(p, TRACEGEN_REQUEST_KB, 0);
+	*p++ = '\n';
+	out_len = p - out;
+}
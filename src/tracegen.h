@@ -0,0 +1,30 @@
+#ifndef SMR_SSD_CACHE_TRACEGEN_H
+#define SMR_SSD_CACHE_TRACEGEN_H
+
+#define DEBUG 0
+/* ---------------------------trace generator---------------------------- */
+
+typedef enum
+{
+	TRACEGEN_UNIFORM = 0,
+	TRACEGEN_ZIPF,				// request slots ranked by a zipf distribution
+	TRACEGEN_HOTBAND,			// most requests go to a few hot bands
+	TRACEGEN_SEQUENTIAL			// interleaved sequential streams
+} TraceGenPattern;
+
+extern unsigned long TRACEGEN_REQUESTS;
+extern unsigned long TRACEGEN_SEED;
+extern TraceGenPattern TRACEGEN_PATTERN;
+extern double TRACEGEN_ZIPF_THETA;
+extern unsigned long TRACEGEN_WORKING_SET_MB;
+extern unsigned long TRACEGEN_REQUEST_KB;
+extern unsigned long TRACEGEN_READ_PERCENT;
+extern unsigned long TRACEGEN_HOT_BAND_PERCENT;
+extern unsigned long TRACEGEN_HOT_ACCESS_PERCENT;
+extern unsigned long TRACEGEN_STREAMS;
+extern unsigned long TRACEGEN_BURST_PERCENT;
+extern unsigned long TRACEGEN_BURST_KB;
+extern unsigned long TRACEGEN_INTERVAL_US;
+
+extern void generateTrace(char *trace_file_path);
+#endif